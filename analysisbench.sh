@@ -0,0 +1,15 @@
+#!/bin/sh
+#
+# Compare the analysis backends of exampleB4c: events/s and bytes/event
+# for the configurations of analysisbench.mac.
+# Usage: ./analysisbench.sh [backends] (default: root csv xml)
+#
+
+EXAMPLE=${EXAMPLE:-./exampleB4c}
+BACKENDS=${*:-"root csv xml"}
+
+for BACKEND in $BACKENDS
+do
+  echo "=== $BACKEND"
+  $EXAMPLE -analysis $BACKEND -m analysisbench.mac | grep "^ Analysis $BACKEND:"
+done
@@ -8,9 +8,6 @@ GAP_THICKNESS=5
 #Set the amount of electromagnetic calorimeter layers
 EMLAYERS=10
 
-./bin/Linux-g++/exampleB4c -m run_el.mac -emlayers $EMLAYERS -absorber $ABS_THICKNESS -gap $GAP_THICKNESS 
-mv result.root output_el.root 
-./bin/Linux-g++/exampleB4c -m run_pi.mac -emlayers $EMLAYERS -absorber $ABS_THICKNESS -gap $GAP_THICKNESS
-mv result.root output_pi.root
-
-root -l process.C
+#Electrons and pions interleaved in one run: e/pi, resolution and sampling
+#fraction are printed at the end of the run and saved in summary_r0.json
+./bin/Linux-g++/exampleB4c -m mix.mac -emlayers $EMLAYERS -absorber $ABS_THICKNESS -gap $GAP_THICKNESS | grep -A 20 "Response per species"
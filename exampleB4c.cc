@@ -30,7 +30,14 @@
 
 #include "B4cDetectorConstruction.hh"
 #include "B4cActionInitialization.hh"
-
+#include "B4cParameterSweep.hh"
+#include "B4cPhysicsTableCache.hh"
+#include "B4cFastSimulationPhysics.hh"
+#include "B4Analysis.hh"
+
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#endif
 #include "G4RunManager.hh"
 #include "G4UserSpecialCuts.hh"
 #include "G4StepLimiterPhysics.hh"
@@ -55,6 +62,12 @@ namespace {
     	<< "[-absorber <absorber thickness (mm)>] [-gap <gap thickness (mm)>] "
     	<< "[-felayers nr] [-wlayers nr] [-hadronic <layer thickness (mm)>]"
     	<< G4endl;
+    G4cerr << "   [-sweep <file with one sweep point per line>]" << G4endl;
+    G4cerr << "   [-analysis <" << B4Analysis::GetCandidates() 
+           << ">] (default " << B4Analysis::GetBackend() << ")" << G4endl;
+#ifdef G4MULTITHREADED
+    G4cerr << "   [-t nThreads] (0 = sequential run manager, default)" << G4endl;
+#endif
   }
 }
 
@@ -62,42 +75,61 @@ namespace {
 
 int main(int argc,char** argv)
 {
-  // Evaluate arguments
+  // Evaluate arguments: options, each followed by its value
   //
-  if ( argc > 15 ) {
+  if ( argc % 2 == 0 ) {
     PrintUsage();
     return 1;
   }
   
   G4String macro;
   G4String session;
+  G4String sweep;
+  G4String backend;
 
   G4int layers = 10;
   G4double absoSize = 10*mm;
   G4double gapSize = 5*mm;
   G4int feLayers = 0;
   G4int wLayers = 0;
-  G4int hadSize = 20*mm;
+  G4double hadSize = 20*mm;
+#ifdef G4MULTITHREADED
+  G4int nThreads = 0;
+#endif
 
   for ( G4int i=1; i<argc; i=i+2 ) {
     if      ( G4String(argv[i]) == "-m" ) macro = argv[i+1];
     else if ( G4String(argv[i]) == "-u" ) session = argv[i+1];
+    else if ( G4String(argv[i]) == "-sweep" ) sweep = argv[i+1];
+    else if ( G4String(argv[i]) == "-analysis" ) backend = argv[i+1];
     else if ( G4String(argv[i]) == "-emlayers" ) layers = G4UIcommand::ConvertToInt(argv[i+1]);
     else if ( G4String(argv[i]) == "-absorber" ) absoSize = G4UIcommand::ConvertToDouble(argv[i+1]);
     else if ( G4String(argv[i]) == "-gap" ) gapSize = G4UIcommand::ConvertToDouble(argv[i+1]);
     else if ( G4String(argv[i]) == "-felayers" ) feLayers = G4UIcommand::ConvertToInt(argv[i+1]);
     else if ( G4String(argv[i]) == "-wlayers" ) wLayers = G4UIcommand::ConvertToInt(argv[i+1]);
     else if ( G4String(argv[i]) == "-hadronic" ) hadSize = G4UIcommand::ConvertToDouble(argv[i+1]);
+#ifdef G4MULTITHREADED
+    else if ( G4String(argv[i]) == "-t" ) nThreads = G4UIcommand::ConvertToInt(argv[i+1]);
+#endif
     else {
       PrintUsage();
       return 1;
     }
   }  
+
+  // Select the analysis backend before the run actions create the
+  // analysis managers
+  //
+  if ( backend.size() && ! B4Analysis::SetBackend(backend) ) {
+    PrintUsage();
+    return 1;
+  }
   
-  // Detect interactive mode (if no macro provided) and define UI session
+  // Detect interactive mode (if no macro or sweep provided) and define
+  // UI session
   //
   G4UIExecutive* ui = 0;
-  if ( ! macro.size() ) {
+  if ( ! macro.size() && ! sweep.size() ) {
     ui = new G4UIExecutive(argc, argv);
   }
 
@@ -105,21 +137,36 @@ int main(int argc,char** argv)
   //
   G4Random::setTheEngine(new CLHEP::RanecuEngine);
   
-  // Construct the default run manager
+  // Construct the run manager: multi-threaded if workers were requested,
+  // the default sequential one otherwise
   //
-  G4RunManager * runManager = new G4RunManager;
+  G4RunManager * runManager = 0;
+#ifdef G4MULTITHREADED
+  if ( nThreads > 0 ) {
+    G4MTRunManager* mtRunManager = new G4MTRunManager;
+    mtRunManager->SetNumberOfThreads(nThreads);
+    runManager = mtRunManager;
+  }
+#endif
+  if ( ! runManager ) runManager = new G4RunManager;
 
   // Set mandatory initialization classes
   //
-  G4UserLimits* limits = new G4UserLimits(DBL_MAX, DBL_MAX, DBL_MAX, 2*MeV);
   B4cDetectorConstruction* detConstruction = new B4cDetectorConstruction(
-		  limits, absoSize, gapSize, layers, hadSize, feLayers, wLayers
+		  absoSize, gapSize, layers, hadSize, feLayers, wLayers
 		  );
   runManager->SetUserInitialization(detConstruction);
 
   G4VModularPhysicsList* physicsList = new FTFP_BERT;
   physicsList->RegisterPhysics(new G4StepLimiterPhysics());
+  // the fast simulation process is activated only in the runs with a
+  // shower library replay or parameterised showers
+  physicsList->RegisterPhysics(new B4cFastSimulationPhysics());
   runManager->SetUserInitialization(physicsList);
+
+  // Store the physics tables on disk and retrieve them in later jobs
+  B4cPhysicsTableCache* physicsTableCache
+    = new B4cPhysicsTableCache(physicsList, "FTFP_BERT+G4StepLimiterPhysics+B4cFastSimulationPhysics");
     
   B4cActionInitialization* actionInitialization
      = new B4cActionInitialization();
@@ -136,10 +183,18 @@ int main(int argc,char** argv)
 
   // Process macro or start UI session
   //
-  if ( macro.size() ) {
+  if ( macro.size() || sweep.size() ) {
     // batch mode
-    G4String command = "/control/execute ";
-    UImanager->ApplyCommand(command+macro);
+    if ( macro.size() ) {
+      G4String command = "/control/execute ";
+      UImanager->ApplyCommand(command+macro);
+    }
+    // sweep mode: all points in this process, the macro above (if any)
+    // serves as a common setup
+    if ( sweep.size() ) {
+      B4cParameterSweep parameterSweep(detConstruction);
+      if ( parameterSweep.Load(sweep) ) parameterSweep.Execute();
+    }
   }
   else  {  
     // interactive mode : define UI session
@@ -156,7 +211,7 @@ int main(int argc,char** argv)
   // owned and deleted by the run manager, so they should not be deleted 
   // in the main() program !
 
-  delete limits;
+  delete physicsTableCache;
   delete visManager;
   delete runManager;
 }
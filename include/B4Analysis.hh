@@ -31,7 +31,43 @@
 #ifndef B4Analysis_h
 #define B4Analysis_h 1
 
-#include "g4root.hh"
-//#include "g4xml.hh"
+#include "G4VAnalysisManager.hh"
+#include "globals.hh"
+
+/// Runtime selection of the analysis technology
+///
+/// The output backend - root (default), csv, xml or hdf5 (Geant4 10.4 or
+/// later built with HDF5, and this example configured with B4_WITH_HDF5)
+/// - is selected with the -analysis option of exampleB4c or with the
+/// /B4/analysis/backend command before the first run; it is the same for
+/// all threads.
+///
+/// All booking and filling goes through the G4VAnalysisManager interface 
+/// of the manager returned by GetManager(), created for the selected
+/// backend at the first call in each thread. The settings specific to one 
+/// technology are applied only when it is selected.
+
+class B4Analysis
+{
+  public:
+    // backend selection
+    static G4bool SetBackend(const G4String& name);
+    static const G4String& GetBackend();
+    static const char* GetCandidates();
+    static G4String GetFileExtension();
+
+    // analysis manager of this thread
+    static G4VAnalysisManager* GetManager();
+    static void DeleteManager();
+
+    // technology-specific settings, ignored by the other backends
+    static void SetNtupleMerging(G4bool merging);
+    static void SetBasketSize(G4int basketSize);
+    static void SetCompressionLevel(G4int level);
+
+  private:
+    static G4String& Backend();
+    static G4ThreadLocal G4VAnalysisManager* fgManager;
+};
 
 #endif
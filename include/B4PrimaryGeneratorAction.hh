@@ -31,11 +31,15 @@
 #ifndef B4PrimaryGeneratorAction_h
 #define B4PrimaryGeneratorAction_h 1
 
+#include "B4cBeamSpectrum.hh"
+#include "B4cPrimaryFile.hh"
+
 #include "G4VUserPrimaryGeneratorAction.hh"
 #include "globals.hh"
 
 class G4ParticleGun;
 class G4Event;
+class G4GenericMessenger;
 
 /// The primary generator action class with particle gum.
 ///
@@ -43,6 +47,45 @@ class G4Event;
 /// perpendicular to the input face. The type of the particle
 /// can be changed via the G4 build-in commands of G4ParticleGun class 
 /// (see the macros provided with this example).
+///
+/// With /B4/gun/reseedEvents true, the random engine is reseeded at the
+/// start of each event from the base seed set with /B4/gun/eventSeed, the
+/// run ID and the event ID. An event then gets the same random sequence in
+/// sequential and multi-threaded mode, whichever worker thread processes
+/// it. It is off by default: the reseeding replaces the state of the 
+/// engine, so /random/setSeeds and the seeding of the workers by the 
+/// master have no effect while it is on.
+///
+/// The gun is placed at the upstream face of the world or, with 
+/// /B4/gun/frontFace, at the front face of the calorimeter (the most 
+/// upstream face of the daughters of the world), looked up once per run;
+/// with a tight world (/B4/det/tightWorld) the primaries then cross no
+/// vacuum before the calorimeter. The beam model is set with the /B4/beam/ commands:
+/// - spectrum: mono (the /gun/energy, default), flat, gauss, powerlaw or
+///   table, sampled with an alias table (B4cBeamSpectrum) built at the 
+///   first event of each run; the gauss spectrum is centred on /gun/energy,
+/// - sigmaX, sigmaY: Gaussian beam spot,
+/// - divergenceX, divergenceY: Gaussian angular spread around the gun
+///   direction.
+/// In a mixed run (/B4/mix/, B4cParticleMix), the particle and energy of
+/// each event are those of the species drawn, in place of the /gun/ ones 
+/// and of the spectrum. The gun settings are restored after each event,
+/// so that the /gun/ commands keep their meaning.
+///
+/// With pile-up (/B4/pileup/, B4cPileUp), a Poisson number of overlay
+/// primaries, each with its own vertex, species, energy, beam spot and 
+/// time offset, follows the signal primary.
+///
+/// With /B4/replay/file, the signal primaries are instead replayed from a
+/// primary event file (B4cPrimaryFile): a memory-mapped binary file or,
+/// as a fallback, an ASCII HEPEVT file. Event i of a run replays the 
+/// file event firstEvent + i, so the worker threads read disjoint events
+/// without locking, and the pages of the next /B4/replay/prefetch events
+/// are read ahead by the kernel. When the file is exhausted a warning is
+/// issued and the run is stopped (the event has no primaries and is not
+/// accounted by the event action), or with /B4/replay/wrap true the file
+/// is replayed again from its first event (modulo the number of events).
+/// /B4/replay/off returns to the particle gun from the next run.
 
 class B4PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
@@ -54,11 +97,54 @@ public:
   
   // set methods
   void SetRandomFlag(G4bool value);
+  void StopReplay();
 
   // get methods
   G4ParticleGun* getGun();
+  // the /gun/energy setting, restored after each event
+  G4double GetNominalEnergy() const;
 private:
+  void ReseedEvent(const G4Event* event);
+  void BeginOfRun();
+  void ShootPrimary(G4Event* event, G4int species, G4double time);
+  void ReplayPrimaries(G4Event* event);
+  void DefineCommands();
+
   G4ParticleGun*  fParticleGun; // G4 particle gun
+  G4GenericMessenger* fMessenger;
+  G4GenericMessenger* fBeamMessenger;
+  G4GenericMessenger* fReplayMessenger;
+  G4int   fEventSeed;     // base seed of the per-event random sequences
+  G4bool  fReseedEvents;  // option to reseed the engine at each event
+  G4bool  fFrontFace;     // option to start at the calorimeter front face
+
+  // cached per run
+  G4int    fRunID;             // run of the cached values
+  G4double fGunZ;              // the world or calorimeter front face
+  B4cBeamSpectrum fSpectrum;   // empty for a mono-energetic beam
+
+  // beam model
+  G4String fSpectrumShape;  // mono, flat, gauss, powerlaw or table
+  G4String fSpectrumFile;   // table: "lowEdge highEdge weight" in MeV
+  G4double fMinEnergy;      // flat, powerlaw
+  G4double fMaxEnergy;      // flat, powerlaw
+  G4double fEnergySpread;   // gauss: relative sigma
+  G4double fSpectralIndex;  // powerlaw: E^-index
+  G4int    fSpectrumBins;   // bins of the analytic spectra
+  G4double fSigmaX;         // beam spot
+  G4double fSigmaY;
+  G4double fDivergenceX;    // angular spread
+  G4double fDivergenceY;
+
+  // replay of a primary event file
+  G4String fReplayFileName;  // empty = no replay
+  G4int    fReplayFirstEvent;
+  G4int    fReplayPrefetch;  // events read ahead
+  G4bool   fReplayWrap;      // option to replay the file again at its end
+  G4bool   fReplayWrapped;   // the end of the file was reached in this run
+  B4cPrimaryFile fReplayFile;
+  G4int    fPrefetchBegin;   // events read ahead [begin, end)
+  G4int    fPrefetchEnd;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
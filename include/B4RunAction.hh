@@ -32,9 +32,22 @@
 #define B4RunAction_h 1
 
 #include "G4UserRunAction.hh"
+#include "G4Timer.hh"
 #include "globals.hh"
 
+#include <vector>
+
 class G4Run;
+class G4GenericMessenger;
+class B4cRun;
+class B4cNtupleSchema;
+class B4cAsyncWriter;
+class B4cRecordFile;
+class B4cVoxelFile;
+class B4cResponseSummary;
+class B4cAdaptiveRun;
+class B4cParticleMix;
+class B4cPileUp;
 
 /// Run action class
 ///
@@ -47,11 +60,49 @@ class G4Run;
 /// - Track length in absorber
 /// - Track length in gap
 /// The same values are also saved in the ntuple.
+/// The energy-weighted transverse profile of the EM gaps is histogrammed 
+/// per event from the radial bins of the sensitive detector (H1 em_trans 
+/// and H2 em_trans_layers), its mean and rms radius are saved in the 
+/// ntuple, as is the kinetic energy of the tracks killed by the stacking
+/// action time and energy cuts. The other columns of this "result" ntuple
+/// are selected with the /B4/ntuple/ commands (B4cNtupleSchema), defined
+/// on the master; both ntuples are booked at the first run. The cells 
+/// fired in the segmented layers are saved one per row in the second 
+/// ntuple. In a mixed-species run (/B4/mix/, B4cParticleMix), the total 
+/// and gap energy of each species are histogrammed separately.
 /// The histograms and ntuple are saved in the output file in a format
-/// accoring to a selected technology in B4Analysis.hh.
+/// according to the technology selected at runtime (B4Analysis), with 
+/// /B4/analysis/backend or the -analysis option. The master prints the
+/// events per second and the output bytes per event of each run.
 ///
 /// In EndOfRunAction(), the accumulated statistic and computed 
-/// dispersion is printed.
+/// dispersion is printed; the master also prints the response per 
+/// primary species, e/pi and the energy resolution, and writes them in
+/// a JSON file (B4cResponseSummary). With /B4/adaptive/precision, the
+/// run stops once the target precision is reached (B4cAdaptiveRun) and
+/// the master prints the number of events needed.
+///
+/// The per-event quantities are accumulated in a B4cRun created in
+/// GenerateRun(); in multi-threaded mode the worker runs, histograms and
+/// ntuple rows are merged on the master at the end of run.
+///
+/// With /B4/output/async, an asynchronous writer (B4cAsyncWriter) is 
+/// started for each event thread at the beginning of run and stopped at
+/// its end, once it has filled the histograms and ntuple of its thread,
+/// before the file is written;
+/// the queue depth and stalls of the writers are printed in the summary.
+/// Likewise, with /B4/records/enable a fixed-record event file 
+/// (B4cRecordFile) is opened for each event thread and run, and with
+/// /B4/voxels/enable a shower image file (B4cVoxelFile).
+///
+/// The master keeps the time per event and the mean gap deposit per EM 
+/// layer of the last run with and without parameterised showers 
+/// (/B4/param/enable) and prints the speedup and the deviation of the
+/// parameterised profile once both are available.
+///
+/// With /B4/nav/timing (B4cSteppingAction), the master prints the steps,
+/// their share and the time per step in each logical volume, the 
+/// slowest volumes first.
 ///
 
 class B4RunAction : public G4UserRunAction
@@ -60,8 +111,40 @@ class B4RunAction : public G4UserRunAction
     B4RunAction();
     virtual ~B4RunAction();
 
+    virtual G4Run* GenerateRun();
     virtual void BeginOfRunAction(const G4Run*);
     virtual void   EndOfRunAction(const G4Run*);
+
+    // set methods
+    void SetAnalysisBackend(const G4String& backend);
+
+  private:
+    void Book();
+    G4double GetOutputSize(const G4String& fileName) const;
+    void PrintParameterisationReport(const B4cRun* run);
+
+    B4cNtupleSchema*    fNtupleSchema;
+    G4GenericMessenger* fNtupleMessenger;
+    B4cAsyncWriter*     fWriter;
+    G4GenericMessenger* fOutputMessenger;
+    B4cRecordFile*      fRecordFile;
+    G4GenericMessenger* fRecordMessenger;
+    B4cVoxelFile*       fVoxelFile;
+    G4GenericMessenger* fVoxelMessenger;
+    B4cResponseSummary* fResponseSummary;
+    G4GenericMessenger* fSummaryMessenger;
+    B4cAdaptiveRun*     fAdaptiveRun;
+    G4GenericMessenger* fAdaptiveMessenger;
+    B4cParticleMix*     fParticleMix;
+    G4GenericMessenger* fMixMessenger;
+    B4cPileUp*          fPileUp;
+    G4GenericMessenger* fPileUpMessenger;
+    G4GenericMessenger* fAnalysisMessenger;
+    G4GenericMessenger* fNavMessenger;
+
+    G4Timer  fTimer;
+    G4double fSecondsPerEvent[2];           ///< full, parameterised
+    std::vector<G4double> fLayerProfile[2]; ///< full, parameterised
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,113 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cAdaptiveRun.hh
+/// \brief Definition of the B4cAdaptiveRun class
+
+#ifndef B4cAdaptiveRun_h
+#define B4cAdaptiveRun_h 1
+
+#include "B4cRunningStatistics.hh"
+#include "B4cRun.hh"
+
+#include "globals.hh"
+
+#include <map>
+
+/// Adaptive run length: the run is stopped once a target statistical 
+/// precision is reached
+///
+/// With /B4/adaptive/precision > 0, the event threads add the visible 
+/// (gap) energy of each event per primary species (B4cRun::SpeciesKey,
+/// the same particle at two energies being two species) to their own 
+/// accumulators, which are merged every /B4/adaptive/interval events 
+/// into accumulators shared by all threads. The target is reached when
+/// every species seen has at least minEvents events and the relative 
+/// statistical error of its selected quantity is below the precision:
+/// - mean: the mean visible energy,
+/// - resolution: the energy resolution sigma/E.
+/// Each event thread then stops after its current event (soft abort); 
+/// the number of events of /run/beamOn is the maximum. The master prints
+/// the number of events needed and the precision reached, computed from
+/// the merged run.
+/// There is one instance per thread, created by the run action.
+
+class B4cAdaptiveRun
+{
+  public:
+    struct Options {
+      Options();
+      G4double precision;  ///< target relative error, 0 = fixed run length
+      G4String quantity;   ///< "mean" or "resolution"
+      G4int    interval;   ///< events of a thread between two checks
+      G4int    minEvents;  ///< events per species before a check
+    };
+    static Options& GetOptions();
+
+    B4cAdaptiveRun();
+    ~B4cAdaptiveRun();
+
+    // adaptive run of this thread, 0 if there is none
+    static B4cAdaptiveRun* GetInstance();
+    static G4bool IsEnabled();
+
+    // master (or sequential) run action: reset the shared accumulators
+    static void Reset();
+    // run action of each thread
+    void BeginOfRun();
+    // event action
+    void AddEvent(const B4cRun::SpeciesKey& key, G4double visibleEdep);
+    // master: relative error of the selected quantity of a species
+    static G4double GetPrecision(const B4cRunningStatistics& visible);
+    static void Print(const B4cRun* run);
+
+  private:
+    // methods
+    void Flush();
+
+    // data members
+    static G4ThreadLocal B4cAdaptiveRun* fgInstance;
+
+    // statistics per species since the last check
+    std::map<B4cRun::SpeciesKey, B4cRunningStatistics> fPending;
+    G4int fNofPendingEvents;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline B4cAdaptiveRun* B4cAdaptiveRun::GetInstance() {
+  return fgInstance;
+}
+
+inline G4bool B4cAdaptiveRun::IsEnabled() {
+  return GetOptions().precision > 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,205 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cAsyncWriter.hh
+/// \brief Definition of the B4cAsyncWriter class
+
+#ifndef B4cAsyncWriter_h
+#define B4cAsyncWriter_h 1
+
+#include "globals.hh"
+#include "B4cNtupleSchema.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class G4VAnalysisManager;
+
+/// Asynchronous writer of the per-event records
+///
+/// The event action copies the summary of each event in a fixed-size 
+/// record, in a slot of a bounded single-producer single-consumer ring 
+/// buffer, and a dedicated writer thread:
+/// - appends the records to a binary file through a large stdio buffer,
+/// - fills the EM layer and transverse profile histograms and the result
+///   ntuple (B4cNtupleSchema) from each record, as the event action does
+///   in the synchronous mode.
+/// The record size is fixed for a run: the header values (kEventID, ...)
+/// followed by the gap energy deposit of each EM layer (-1 for the layers 
+/// without gap read-out), by its radial bins (layer-major) and by the 
+/// layer vectors of the ntuple schema, if booked.
+///
+/// The analysis managers (B4Analysis) are thread-local: the writer thread 
+/// fills the manager of the event thread which started it. The event 
+/// thread locks GetAnalysisMutex() for its own fills while the writer 
+/// runs.
+///
+/// When the buffer is full the event thread waits for a free slot; the
+/// queue depth and these stalls are added to the run by the event action.
+/// The writer is controlled with the /B4/output/ commands:
+/// - async [true|false]
+/// - queueSize <number of records>
+/// - file <base name of the record files>
+/// There is one writer per event thread, its file name is suffixed with
+/// the thread number in multi-threaded mode.
+
+class B4cAsyncWriter
+{
+  public:
+    struct Options {
+      Options();
+      G4bool   enable;
+      G4int    queueSize;
+      G4String fileName;
+    };
+    static Options& GetOptions();
+
+    // header values of a record
+    enum {
+      kEventID = 0, kAbsoEdep, kGapEdep, kHcalEdep, 
+      kAbsoLength, kGapLength, kHcalLength,
+      kEmRMean, kEmRRms, kKilledTime, kKilledEkin,
+      kHasPrimary, kPrimaryPdg, kPrimaryEkin, kPrimaryX, kPrimaryY,
+      kPrimaryDirX, kPrimaryDirY, kPrimaryDirZ,
+      kSpecies, kBeamEnergy, kSpeciesTotalH1, kSpeciesVisibleH1,
+      kHasPileUp, kNofPrimaries, kSignalEdep,
+      kVectorSize,   ///< size of each layer vector (kNofVectors values)
+      kNofHeaderValues = kVectorSize + B4cNtupleSchema::kNofVectors
+    };
+
+    B4cAsyncWriter();
+    ~B4cAsyncWriter();
+
+    // writer of this thread, 0 if there is none
+    static B4cAsyncWriter* GetInstance();
+
+    // start and stop the writer thread (begin and end of run); the
+    // vectors of the schema hold up to vectorCapacity[i] layers
+    void Start(G4int nofLayers, G4int nofRadialBins, G4double radialBinWidth,
+               const G4int vectorCapacity[B4cNtupleSchema::kNofVectors]);
+    void Stop();
+    G4bool IsRunning() const;
+
+    // event thread: get a free slot (waiting if the buffer is full),
+    // then make it available to the writer
+    G4double* AcquireSlot(G4double& depth, G4double& stallSeconds);
+    void      CommitSlot();
+
+    // record layout
+    G4int GetNofLayers() const;
+    G4int GetNofRadialBins() const;
+    G4int GetLayerOffset() const;
+    G4int GetRadialOffset() const;
+    G4int GetVectorOffset(G4int vector) const;
+    G4int GetVectorCapacity(G4int vector) const;
+
+    // to be locked by the event thread for its analysis fills
+    std::mutex& GetAnalysisMutex();
+
+  private:
+    // methods
+    void Run();
+    void Process(const G4double* record);
+    void FillHistograms(const G4double* record) const;
+    void FillNtuple(const G4double* record) const;
+
+    // data members
+    static G4ThreadLocal B4cAsyncWriter* fgInstance;
+
+    G4bool    fRunning;
+    G4int     fNofLayers;
+    G4int     fNofRadialBins;
+    G4double  fRadialBinWidth;
+    G4int     fVectorOffset[B4cNtupleSchema::kNofVectors];
+    G4int     fVectorCapacity[B4cNtupleSchema::kNofVectors];
+    size_t    fRecordSize;
+    size_t    fCapacity;
+    std::vector<G4double> fSlots;
+    std::atomic<size_t>   fHead;   ///< records committed by the event thread
+    std::atomic<size_t>   fTail;   ///< records processed by the writer
+    std::atomic<bool>     fStop;
+    std::thread           fThread;
+    std::mutex            fAnalysisMutex;
+
+    // owned by the writer thread while running
+    std::FILE*            fFile;
+    std::vector<char>     fFileBuffer;
+    G4VAnalysisManager*   fAnalysisManager;  ///< of the event thread
+    B4cNtupleSchema*      fSchema;           ///< of the event thread
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline B4cAsyncWriter* B4cAsyncWriter::GetInstance() {
+  return fgInstance;
+}
+
+inline G4bool B4cAsyncWriter::IsRunning() const {
+  return fRunning;
+}
+
+inline G4int B4cAsyncWriter::GetNofLayers() const {
+  return fNofLayers;
+}
+
+inline G4int B4cAsyncWriter::GetNofRadialBins() const {
+  return fNofRadialBins;
+}
+
+inline G4int B4cAsyncWriter::GetLayerOffset() const {
+  return kNofHeaderValues;
+}
+
+inline G4int B4cAsyncWriter::GetRadialOffset() const {
+  return kNofHeaderValues + fNofLayers;
+}
+
+inline G4int B4cAsyncWriter::GetVectorOffset(G4int vector) const {
+  return fVectorOffset[vector];
+}
+
+inline G4int B4cAsyncWriter::GetVectorCapacity(G4int vector) const {
+  return fVectorCapacity[vector];
+}
+
+inline std::mutex& B4cAsyncWriter::GetAnalysisMutex() {
+  return fAnalysisMutex;
+}
+
+inline void B4cAsyncWriter::CommitSlot() {
+  fHead.store(fHead.load(std::memory_order_relaxed) + 1, 
+              std::memory_order_release);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,106 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cBeamSpectrum.hh
+/// \brief Definition of the B4cBeamSpectrum class
+
+#ifndef B4cBeamSpectrum_h
+#define B4cBeamSpectrum_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+/// Energy spectrum of the beam, sampled with an alias table
+///
+/// The spectrum is a histogram: either read from a file, one bin per 
+/// line "lowEdge highEdge weight" with the edges in MeV ('#' starts a 
+/// comment), or tabulated from an analytic shape in a number of equal 
+/// bins:
+/// - flat:      uniform between minEnergy and maxEnergy,
+/// - gauss:     mean energy and relative spread, within +-5 sigma,
+/// - powerlaw:  E^-index between minEnergy and maxEnergy.
+/// The alias table (Walker, Vose) is built once; a sample then costs two
+/// random numbers and one table look-up, whatever the number of bins, 
+/// and the energy is uniform within the selected bin.
+
+class B4cBeamSpectrum
+{
+  public:
+    B4cBeamSpectrum();
+    ~B4cBeamSpectrum();
+
+    // methods
+    G4bool SetHistogram(const std::vector<G4double>& lowEdges,
+                        const std::vector<G4double>& highEdges,
+                        const std::vector<G4double>& weights);
+    G4bool ReadTable(const G4String& fileName);
+    G4bool SetFlat(G4double minEnergy, G4double maxEnergy, G4int nofBins);
+    G4bool SetGauss(G4double mean, G4double relativeSpread, G4int nofBins);
+    G4bool SetPowerLaw(G4double minEnergy, G4double maxEnergy, 
+                       G4double index, G4int nofBins);
+    void Clear();
+
+    G4double Sample() const;
+
+    // get methods
+    G4bool IsEmpty() const;
+    G4int  GetNofBins() const;
+    G4double GetMean() const;
+
+  private:
+    // methods
+    template <class Density>
+    G4bool Tabulate(G4double minEnergy, G4double maxEnergy, G4int nofBins,
+                    Density density);
+
+    // data members
+    std::vector<G4double> fLowEdges;
+    std::vector<G4double> fWidths;
+    std::vector<G4double> fProbabilities; ///< of keeping the bin
+    std::vector<G4int>    fAliases;       ///< bin taken otherwise
+    G4double fMean;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline G4bool B4cBeamSpectrum::IsEmpty() const {
+  return fLowEdges.empty();
+}
+
+inline G4int B4cBeamSpectrum::GetNofBins() const {
+  return fLowEdges.size();
+}
+
+inline G4double B4cBeamSpectrum::GetMean() const {
+  return fMean;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -32,25 +32,79 @@
 #define B4cCalorimeterSD_h 1
 
 #include "G4VSensitiveDetector.hh"
+#include "G4ThreeVector.hh"
 
 #include "B4cCalorHit.hh"
+#include "B4cCellMap.hh"
 
 #include <vector>
+#include <algorithm>
 
 class G4Step;
+class G4VTouchable;
 class G4HCofThisEvent;
 
 /// Calorimeter sensitive detector class
 ///
-/// In Initialize(), it creates one hit for each calorimeter layer and one more
-/// hit for accounting the total quantities in all layers.
+/// By default (flat mode) the values are accounted in ProcessHits(), which
+/// is called by Geant4 kernel at each step, into contiguous per-layer 
+/// buffers (energy deposit, track length, energy-weighted position 
+/// moments and the energy deposit in radial bins around the calorimeter
+/// axis) allocated once and reused for all events. The totals over all
+/// layers are summed in EndOfEvent(). The event action reads the buffers
+/// directly, so the hits collection is only materialised in EndOfEvent()
+/// if requested with /B4/sd/storeHits.
 ///
-/// The values are accounted in hits in ProcessHits() function which is called
-/// by Geant4 kernel at each step.
+/// With /B4/sd/flat false, Initialize() creates one hit for each calorimeter
+/// layer and one more hit for accounting the total quantities in all 
+/// layers, and each step is accounted in these hits, as in the original
+/// example; the buffers are then filled from the hits in EndOfEvent().
+///
+/// Optionally each layer is segmented in a transverse grid of 
+/// nofCellsX x nofCellsY readout cells (SetCellGrid()). The cell is 
+/// computed from the pre-step point in the local frame of the sensitive
+/// volume, without any extra physical volume, and the energy deposit is
+/// accumulated in a sparse B4cCellMap, so that the cost is proportional to
+/// the number of cells fired in the event, available after EndOfEvent().
+///
+/// With /B4/sd/voxelsX and voxelsY, the energy deposit is also binned 
+/// on a voxel grid over the whole calorimeter stack: voxelsX x voxelsY 
+/// transverse bins times the layers, the layers of this detector 
+/// starting at the offset set with SetVoxelLayerOffset(). The voxels are
+/// accumulated in a second B4cCellMap, so the memory per event is bounded
+/// by the number of fired voxels (at most the grid size), whatever the 
+/// number of steps.
+///
+/// With pile-up (/B4/pileup/, B4cPileUp), the energy deposit is also 
+/// summed per primary of origin, in one accumulator per primary which 
+/// deposited energy in the event.
+///
+/// The energy spots of the fast simulation models are deposited in the
+/// same accumulators via AddSpot().
+///
+/// With /B4/sd/timing true, the time spent in ProcessHits() and the number
+/// of processed steps are added to the run, which prints the cost per step
+/// at the end of run.
 
 class B4cCalorimeterSD : public G4VSensitiveDetector
 {
   public:
+    /// Options shared by all calorimeter SDs of the application. They are
+    /// set with /B4/sd/ commands on the master between runs and picked up
+    /// by each SD at the start of every event.
+    struct Options {
+      Options() 
+        : flat(true), storeHits(false), timing(false), radialBins(100),
+          voxelsX(0), voxelsY(0) {}
+      G4bool flat;       ///< accumulate in the flat per-layer buffers
+      G4bool storeHits;  ///< materialise the hits collection in flat mode
+      G4bool timing;     ///< measure the time spent in ProcessHits()
+      G4int  radialBins; ///< number of radial bins of the transverse profile
+      G4int  voxelsX;    ///< voxels in x of the shower image, 0 = none
+      G4int  voxelsY;    ///< voxels in y of the shower image, 0 = none
+    };
+    static Options& GetOptions();
+
     B4cCalorimeterSD(const G4String& name, 
                      const G4String& hitsCollectionName, 
                      G4int nofCells);
@@ -61,12 +115,211 @@ class B4cCalorimeterSD : public G4VSensitiveDetector
     virtual G4bool ProcessHits(G4Step* step, G4TouchableHistory* history);
     virtual void   EndOfEvent(G4HCofThisEvent* hitCollection);
 
+    // set methods
+    void SetNofCells(G4int nofCells);
+    void SetRadialRange(G4double rMax);
+    void SetCellGrid(G4int nofCellsX, G4int nofCellsY, G4double sizeXY);
+    void SetVoxelLayerOffset(G4int offset);
+
+    // deposit of a parameterised or frozen shower spot located in one of
+    // the volumes of this detector
+    void AddSpot(G4double edep, const G4ThreeVector& position,
+                 const G4VTouchable* touchable);
+
+    // get methods (valid after EndOfEvent())
+    G4int    GetNofCells() const;
+    G4double GetEdep(G4int layer) const;
+    G4double GetTrackLength(G4int layer) const;
+    G4ThreeVector GetMeanPosition(G4int layer) const;
+    G4double GetEdepR(G4int layer) const;
+    G4double GetEdepR2(G4int layer) const;
+    G4int    GetNofRadialBins() const;
+    G4double GetRadialBinWidth() const;
+    G4double GetRadialEdep(G4int layer, G4int bin) const;
+    G4double GetTotalEdep() const;
+    G4double GetTotalTrackLength() const;
+    G4bool   HasCellGrid() const;
+    G4int    GetNofCellsX() const;
+    G4int    GetNofCellsY() const;
+    G4int    GetNofFiredCells() const;
+    void     GetFiredCell(G4int i, G4int& layer, G4int& ix, G4int& iy) const;
+    G4double GetFiredCellEdep(G4int i) const;
+    G4bool   HasVoxels() const;
+    G4int    GetNofFiredVoxels() const;
+    G4int    GetFiredVoxelKey(G4int i) const;  ///< (z*nofY + iy)*nofX + ix
+    G4double GetFiredVoxelEdep(G4int i) const;
+    G4int    GetNofPrimaries() const;
+    G4double GetPrimaryEdep(G4int primary) const;  ///< 0 = signal
+
   private:
+    // methods
+    G4bool AccumulateFlat(const G4Step* step);
+    G4bool AccumulateHits(const G4Step* step);
+    void   Accumulate(const G4VTouchable* touchable, 
+                      const G4ThreeVector& position,
+                      G4double edep, G4double stepLength);
+    void   ResetBuffers();
+    void   SetNofRadialBins(G4int nofBins);
+    void   AddRadialEdep(G4int layer, G4double r, G4double edep);
+    void   SetVoxelGrid(G4int nofVoxelsX, G4int nofVoxelsY);
+    void   AddReadoutEdep(const G4VTouchable* touchable,
+                          const G4ThreeVector& position,
+                          G4int layer, G4double edep);
+    void   AddPrimaryEdep(G4int trackID, G4double edep);
+    void   FillBuffersFromHits();
+    void   MaterialiseHits(G4HCofThisEvent* hce);
+
+    // data members
     B4cCalorHitsCollection* fHitsCollection;
     G4int     fNofCells;
+    G4int     fHCID;
+    G4bool    fFlat;
+    G4bool    fTiming;
+
+    // per-layer buffers (structure of arrays)
+    std::vector<G4double> fEdep;         ///< energy deposit
+    std::vector<G4double> fTrackLength;  ///< charged track length
+    std::vector<G4double> fEdepX;        ///< sum of edep*x
+    std::vector<G4double> fEdepY;        ///< sum of edep*y
+    std::vector<G4double> fEdepR;        ///< sum of edep*r
+    std::vector<G4double> fEdepR2;       ///< sum of edep*(x^2+y^2)
+    std::vector<G4double> fRadialEdep;   ///< edep per (layer, radial bin),
+                                         ///< last bin of a layer = overflow
+    G4int     fNofRadialBins;
+    G4double  fRadialRange;
+    G4double  fInvRadialBinWidth;
+    G4double  fTotalEdep;
+    G4double  fTotalTrackLength;
+
+    // transverse readout cells
+    G4int     fNofCellsX;
+    G4int     fNofCellsY;
+    G4double  fHalfSizeXY;
+    G4double  fInvCellWidthX;
+    G4double  fInvCellWidthY;
+    B4cCellMap fCellMap;     ///< key = (layer*nofCellsY + iy)*nofCellsX + ix
+
+    // voxels of the shower image
+    G4int     fNofVoxelsX;
+    G4int     fNofVoxelsY;
+    G4int     fVoxelLayerOffset;
+    G4double  fInvVoxelWidthX;
+    G4double  fInvVoxelWidthY;
+    B4cCellMap fVoxelMap;
+
+    // pile-up: energy deposit per primary of origin
+    G4bool    fPileUp;
+    std::vector<G4double> fPrimaryEdep;
+
+    // timing
+    G4double  fNofTimedSteps;
+    G4double  fTimedSeconds;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-#endif
+inline G4int B4cCalorimeterSD::GetNofCells() const {
+  return fNofCells;
+}
+
+inline G4double B4cCalorimeterSD::GetEdep(G4int layer) const {
+  return fEdep[layer];
+}
+
+inline G4double B4cCalorimeterSD::GetTrackLength(G4int layer) const {
+  return fTrackLength[layer];
+}
+
+inline G4double B4cCalorimeterSD::GetEdepR(G4int layer) const {
+  return fEdepR[layer];
+}
+
+inline G4double B4cCalorimeterSD::GetEdepR2(G4int layer) const {
+  return fEdepR2[layer];
+}
+
+inline G4int B4cCalorimeterSD::GetNofRadialBins() const {
+  return fNofRadialBins;
+}
 
+inline G4double B4cCalorimeterSD::GetRadialBinWidth() const {
+  return ( fNofRadialBins > 0 ) ? fRadialRange/fNofRadialBins : 0.;
+}
+
+/// bin = GetNofRadialBins() returns the deposit beyond the radial range
+inline G4double B4cCalorimeterSD::GetRadialEdep(G4int layer, G4int bin) const {
+  return fRadialEdep[layer*(fNofRadialBins+1) + bin];
+}
+
+inline G4double B4cCalorimeterSD::GetTotalEdep() const {
+  return fTotalEdep;
+}
+
+inline G4double B4cCalorimeterSD::GetTotalTrackLength() const {
+  return fTotalTrackLength;
+}
+
+inline G4bool B4cCalorimeterSD::HasCellGrid() const {
+  return fNofCellsX*fNofCellsY > 1;
+}
+
+inline G4int B4cCalorimeterSD::GetNofCellsX() const {
+  return fNofCellsX;
+}
+
+inline G4int B4cCalorimeterSD::GetNofCellsY() const {
+  return fNofCellsY;
+}
+
+inline G4int B4cCalorimeterSD::GetNofFiredCells() const {
+  return fCellMap.GetNofFiredCells();
+}
+
+inline void B4cCalorimeterSD::GetFiredCell(G4int i, G4int& layer, 
+                                           G4int& ix, G4int& iy) const {
+  G4int key = fCellMap.GetFiredKey(i);
+  ix = key % fNofCellsX;
+  key /= fNofCellsX;
+  iy = key % fNofCellsY;
+  layer = key / fNofCellsY;
+}
+
+inline G4double B4cCalorimeterSD::GetFiredCellEdep(G4int i) const {
+  return fCellMap.GetFiredEdep(i);
+}
+
+inline G4bool B4cCalorimeterSD::HasVoxels() const {
+  return fNofVoxelsX > 0;
+}
+
+inline G4int B4cCalorimeterSD::GetNofFiredVoxels() const {
+  return fVoxelMap.GetNofFiredCells();
+}
+
+inline G4int B4cCalorimeterSD::GetFiredVoxelKey(G4int i) const {
+  return fVoxelMap.GetFiredKey(i);
+}
+
+inline G4double B4cCalorimeterSD::GetFiredVoxelEdep(G4int i) const {
+  return fVoxelMap.GetFiredEdep(i);
+}
+
+/// only the primaries up to the last one with a deposit are counted
+inline G4int B4cCalorimeterSD::GetNofPrimaries() const {
+  return fPrimaryEdep.size();
+}
+
+inline G4double B4cCalorimeterSD::GetPrimaryEdep(G4int primary) const {
+  return ( primary < G4int(fPrimaryEdep.size()) ) ? fPrimaryEdep[primary] : 0.;
+}
+
+inline void B4cCalorimeterSD::AddRadialEdep(G4int layer, G4double r,
+                                            G4double edep) {
+  if ( ! fNofRadialBins ) return;
+  G4int bin = std::min(G4int(r*fInvRadialBinWidth), fNofRadialBins);
+  fRadialEdep[layer*(fNofRadialBins+1) + bin] += edep;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,158 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cCalorimeterStack.hh
+/// \brief Definition of the B4cCalorimeterStack class
+
+#ifndef B4cCalorimeterStack_h
+#define B4cCalorimeterStack_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4Material;
+
+/// Description of the calorimeter as an ordered list of modules
+///
+/// A module is a number of identical layers of an absorber plate followed
+/// by an active plate (either may be absent). Its section (em, fe or w)
+/// selects the region, with its production cuts (and the user limits of
+/// its sensitive plates), and the output group (absorber and gap layers,
+/// iron or tungsten layers) of its deposits. Its readout flag selects the
+/// plates that are sensitive; each of them gets its own sensitive detector
+/// and hits collection named after the module ("<name>AbsorberSD",
+/// "<name>ActiveSD").
+///
+/// The stack is either built from the parameters of the detector
+/// construction (SetSampling()) or read from a file (Load()), one module
+/// per line:
+///
+///   name section layers absorber thickness active thickness readout
+///
+/// with the thicknesses in mm, "-" for a missing material and the readout
+/// one of none, absorber, active or both; empty lines and lines starting 
+/// with '#' are ignored. The modules are placed along z in this order.
+
+class B4cCalorimeterStack
+{
+  public:
+    enum Section { kEm, kFe, kW, kNofSections };
+    enum Readout { kNone = 0, kAbsorber = 1, kActive = 2, kBoth = 3 };
+
+    struct Module {
+      Module();
+
+      G4double GetLayerThickness() const;
+      G4double GetThickness() const;
+      G4bool   HasReadout(G4bool active) const;
+      G4String GetVolumeName(G4bool active) const;
+      G4String GetSDName(G4bool active) const;
+      G4String GetHitsCollectionName(G4bool active) const;
+
+      G4String name;
+      Section  section;
+      G4int    nofLayers;
+      G4String absorberMaterial;
+      G4double absorberThickness;
+      G4String activeMaterial;
+      G4double activeThickness;
+      G4int    readout;
+    };
+
+    B4cCalorimeterStack();
+    ~B4cCalorimeterStack();
+
+    // methods
+    G4bool Load(const G4String& fileName);
+    void SetSampling(G4double absoThickness, G4double gapThickness, 
+                     G4int nofLayers, G4double hadLayerThickness,
+                     G4int feLayers, G4int wLayers);
+    G4bool AddModule(const Module& module);
+    void Clear();
+
+    static G4Material* FindMaterial(const G4String& name);
+    static const char* GetSectionName(G4int section);
+
+    // get methods
+    G4int GetNofModules() const;
+    const Module& GetModule(G4int index) const;
+    const Module* GetFirstModule(Section section) const;
+    G4int GetNofLayers() const;
+    G4int GetNofLayers(Section section) const;
+    G4int GetNofReadoutLayers(Section section, G4bool active) const;
+    G4int GetFirstLayer(G4int index) const;
+    G4int GetFirstSectionLayer(G4int index) const;
+    G4double GetThickness() const;
+    G4double GetThickness(Section section) const;
+
+  private:
+    std::vector<Module> fModules;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline G4double B4cCalorimeterStack::Module::GetLayerThickness() const {
+  return absorberThickness + activeThickness;
+}
+
+inline G4double B4cCalorimeterStack::Module::GetThickness() const {
+  return nofLayers*GetLayerThickness();
+}
+
+inline G4bool B4cCalorimeterStack::Module::HasReadout(G4bool active) const {
+  return active ? ( activeThickness > 0. && ( readout & kActive ) )
+                : ( absorberThickness > 0. && ( readout & kAbsorber ) );
+}
+
+inline G4String 
+B4cCalorimeterStack::Module::GetVolumeName(G4bool active) const {
+  return name + ( active ? "ActiveLV" : "AbsorberLV" );
+}
+
+inline G4String B4cCalorimeterStack::Module::GetSDName(G4bool active) const {
+  return name + ( active ? "ActiveSD" : "AbsorberSD" );
+}
+
+inline G4String 
+B4cCalorimeterStack::Module::GetHitsCollectionName(G4bool active) const {
+  return name + ( active ? "ActiveHitsCollection" : "AbsorberHitsCollection" );
+}
+
+inline G4int B4cCalorimeterStack::GetNofModules() const {
+  return fModules.size();
+}
+
+inline const B4cCalorimeterStack::Module& 
+B4cCalorimeterStack::GetModule(G4int index) const {
+  return fModules[index];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
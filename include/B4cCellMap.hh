@@ -0,0 +1,121 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cCellMap.hh
+/// \brief Definition of the B4cCellMap class
+
+#ifndef B4cCellMap_h
+#define B4cCellMap_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+/// Sparse accumulator of the energy deposit per readout cell
+///
+/// The cells are identified by a non-negative integer key and stored in an
+/// open-addressing hash table (linear probing) together with the list of 
+/// the cells fired in the current event, in the order of their first 
+/// deposit. The memory is thus proportional to the number of fired cells,
+/// not to the number of cells of the readout grid. The table is kept 
+/// between events and only the fired slots are cleared in Clear().
+
+class B4cCellMap
+{
+  public:
+    B4cCellMap();
+    ~B4cCellMap();
+
+    // methods
+    void Add(G4int key, G4double edep);
+    void Clear();
+
+    // get methods
+    G4int    GetNofFiredCells() const;
+    G4int    GetFiredKey(G4int i) const;
+    G4double GetFiredEdep(G4int i) const;
+    G4int    GetCapacity() const;
+
+  private:
+    struct Slot {
+      Slot() : key(-1), edep(0.) {}
+      G4int    key;   ///< cell key, -1 for an empty slot
+      G4double edep;
+    };
+
+    // methods
+    G4int FindSlot(G4int key) const;
+    void  Grow();
+
+    // data members
+    std::vector<Slot>  fSlots;       ///< hash table, size is a power of 2
+    std::vector<G4int> fFiredSlots;  ///< slots fired in this event
+    unsigned int       fMask;        ///< table size - 1
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline G4int B4cCellMap::GetNofFiredCells() const {
+  return fFiredSlots.size();
+}
+
+inline G4int B4cCellMap::GetFiredKey(G4int i) const {
+  return fSlots[fFiredSlots[i]].key;
+}
+
+inline G4double B4cCellMap::GetFiredEdep(G4int i) const {
+  return fSlots[fFiredSlots[i]].edep;
+}
+
+inline G4int B4cCellMap::GetCapacity() const {
+  return fSlots.size();
+}
+
+inline G4int B4cCellMap::FindSlot(G4int key) const {
+  // Fibonacci hashing, then linear probing up to the key or an empty slot
+  unsigned int slot = ( static_cast<unsigned int>(key)*2654435769u ) & fMask;
+  while ( fSlots[slot].key != key && fSlots[slot].key >= 0 ) {
+    slot = ( slot + 1 ) & fMask;
+  }
+  return slot;
+}
+
+inline void B4cCellMap::Add(G4int key, G4double edep) {
+  // Keep the load factor below 1/2
+  if ( 2*(fFiredSlots.size() + 1) > fSlots.size() ) Grow();
+
+  G4int slot = FindSlot(key);
+  if ( fSlots[slot].key < 0 ) {
+    fSlots[slot].key = key;
+    fFiredSlots.push_back(slot);
+  }
+  fSlots[slot].edep += edep;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -32,35 +32,89 @@
 #define B4cDetectorConstruction_h 1
 
 #include "G4VUserDetectorConstruction.hh"
+#include "B4cCalorimeterStack.hh"
 #include "globals.hh"
 
-#include "G4UserLimits.hh"
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
 
+#include <map>
+
 class G4VPhysicalVolume;
+class G4Timer;
 class G4GlobalMagFieldMessenger;
+class G4GenericMessenger;
+class B4cShowerLibraryModel;
+class B4cParameterisedShowerModel;
+class B4cRegionSettings;
+class B4cOverlapCache;
 
 /// Detector construction class to define materials and geometry.
-/// The calorimeter is a box made of a given number of layers. A layer consists
-/// of an absorber plate and of a detection gap. The layer is replicated.
+/// The calorimeter is a stack of modules (B4cCalorimeterStack) placed one
+/// behind the other along z. A module is made of a given number of layers;
+/// a layer consists of an absorber plate and of an active plate and is 
+/// replicated. The volumes of a module are created once, whatever its 
+/// number of layers.
 ///
-/// Four parameters define the geometry of the calorimeter :
+/// By default the stack is built from the parameters of the constructor:
+/// an EM calorimeter (lead absorber plates and liquid argon gaps) followed
+/// by an iron and a tungsten hadronic calorimeter, of which the plates 
+/// fill the layers. Five parameters define it :
 ///
 /// - the thickness of an absorber plate,
 /// - the thickness of a gap,
 /// - the number of layers,
-/// - the transverse size of the calorimeter (the input face is a square).
+/// - the thickness and the number of iron and tungsten layers,
+///
+/// and the transverse size of the calorimeter (the input face is a square)
+/// is common to all modules. Any other stack can be read from a file with
+/// /B4/det/stack. The get methods of the EM calorimeter return the sum of
+/// the layers of the EM modules and the plates of the first one.
 ///
 /// In ConstructSDandField() sensitive detectors of B4cCalorimeterSD type
-/// are created and associated with the Absorber and Gap volumes.
+/// are created and associated with the read-out plates of each module;
+/// their names are given by the module (B4cCalorimeterStack::Module).
+/// The detectors are reused when the geometry is rebuilt with new
+/// parameters (SetGeometry() followed by /run/reinitializeGeometry).
+///
+/// All the parameters of the constructor and the transverse size can be
+/// set with the /B4/det/ commands (absorber, gap, emLayers, hadronic,
+/// feLayers, wLayers, sizeXY); they are applied together by 
+/// /B4/det/update, which rebuilds only the geometry, keeping the physics
+/// tables and the analysis session, and prints the time it took.
+/// /B4/det/stack reads a stack file and rebuilds the geometry the same way.
+/// The options shared by these detectors are set with the /B4/sd/ commands
+/// defined here, on the master. The transverse readout grid of the active
+/// plates of the EM modules and of the iron and tungsten modules is set 
+/// with the /B4/det/ commands and passed to the detectors in 
+/// ConstructSDandField().
+///
+/// The modules of the EM, iron and tungsten sections are in the regions 
+/// "EMCalorimeter", "FeCalorimeter" and "WCalorimeter", each with its own production cuts
+/// and user limits (B4cRegionSettings) set with the /B4/region/em/, 
+/// /B4/region/fe/ and /B4/region/w/ commands.
+///
+/// The EM and tungsten calorimeter regions are also the envelopes of the
+/// frozen shower library model, created in ConstructSDandField() and controlled with the 
+/// /B4/showerLib/ commands. The EM calorimeter is also the envelope of the
+/// parameterised shower model, controlled with the /B4/param/ commands.
+/// The volumes are placed without the overlap test, which B4cOverlapCache
+/// runs after the build only for the geometries not validated before
+/// (/B4/overlaps/ commands).
+///
+/// The world is by default much deeper than the calorimeter; with
+/// /B4/det/tightWorld it encloses the stack with a 1 mm margin, the stack
+/// is then centred at the origin. The smartless value of the voxelisation
+/// of any logical volume, typically the modules which are the mothers of
+/// the layer replicas, can be set with /B4/det/smartless; it is kept 
+/// across rebuilds.
 /// In addition a transverse uniform magnetic field is defined 
 /// via G4GlobalMagFieldMessenger class.
 
 class B4cDetectorConstruction : public G4VUserDetectorConstruction
 {
   public:
-    B4cDetectorConstruction(G4UserLimits* limits,
+    B4cDetectorConstruction(
     		G4double absoThickness_ = 10*mm, G4double gapThickness_ = 5*mm, G4int noLayers = 10,
     		G4double hadLayerThickness_ = 20*mm, G4int feLayers_ = 0, G4int wLayers_ = 0
     		);
@@ -71,36 +125,79 @@ class B4cDetectorConstruction : public G4VUserDetectorConstruction
     virtual G4VPhysicalVolume* Construct();
     virtual void ConstructSDandField();
 
+    // set methods
+    void SetGeometry(G4double absoThickness_, G4double gapThickness_,
+                     G4int noLayers, G4double hadLayerThickness_,
+                     G4int feLayers_, G4int wLayers_);
+    void SetGapCellGrid(G4int nofCellsX, G4int nofCellsY);
+    void SetFeCellGrid(G4int nofCellsX, G4int nofCellsY);
+    void SetWCellGrid(G4int nofCellsX, G4int nofCellsY);
+    void SetCalorimeterSizeXY(G4double sizeXY);
+    void UpdateGeometry();
+    void LoadStack(const G4String& fileName);
+    void SetSmartless(const G4String& volumeName, G4double smartless);
+
     // get methods
     G4double GetAbsorberThickness() const;
     G4double GetGapThickness() const;
     G4double GetCalorimeterSizeXY() const;
     G4int GetNumberOfLayers() const;
     G4int GetNumberOfHadronicLayers() const;
+    G4int GetNumberOfFeLayers() const;
+    G4int GetNumberOfWLayers() const;
     G4double GetEMLayerThickness() const;
     G4double GetHadLayerThickness() const;
     G4double GetCalorimeterThickness() const;
+    const B4cCalorimeterStack& GetStack() const;
 
   private:
     // methods
     //
     void DefineMaterials();
     G4VPhysicalVolume* DefineVolumes();
+    void ComputeParameters();
+    void RebuildGeometry(G4Timer& timer);
   
     // data members
     //
     static G4ThreadLocal G4GlobalMagFieldMessenger*  fMagFieldMessenger; 
                                       // magnetic field messenger
+    static G4ThreadLocal B4cShowerLibraryModel* fShowerLibraryModel;
+    static G4ThreadLocal B4cParameterisedShowerModel* 
+                                         fParameterisedShowerModel;
+
+    B4cRegionSettings* fEmRegionSettings;
+    B4cRegionSettings* fFeRegionSettings;
+    B4cRegionSettings* fWRegionSettings;
+    B4cOverlapCache* fOverlapCache;
+    G4GenericMessenger* fSDMessenger;
+    G4GenericMessenger* fDetMessenger;
+    G4GenericMessenger* fShowerLibMessenger;
+    G4GenericMessenger* fParamMessenger;
 
-    G4UserLimits* fLimits;
+    // parameters set with the /B4/det/ commands, applied by UpdateGeometry()
+    struct Parameters {
+      G4double absoThickness;
+      G4double gapThickness;
+      G4int    nofLayers;
+      G4double hadLayerThickness;
+      G4int    feLayers;
+      G4int    wLayers;
+      G4double sizeXY;
+    };
+    Parameters fPending;
+    B4cCalorimeterStack fStack;
 
-    G4bool  fCheckOverlaps; // option to activate checking of volumes overlaps
-    G4int   fNofLayers;     // number of layers
+    G4bool  fCheckOverlaps; // option to check the overlaps at placement
+                            // (the cached check runs after the build)
+    G4bool  fTightWorld;    // option to fit the world to the calorimeter
+    std::map<G4String, G4double> fSmartless; // per logical volume name
+    G4int   fNofLayers;     // number of layers (all EM modules)
 
 
     //Useful geometry that we might want to retrieve later
 
-    const G4double calorSizeXY;
+    G4double calorSizeXY;
 
     G4double absoThickness; //10 mm
     G4double gapThickness;  //5 mm
@@ -110,8 +207,16 @@ class B4cDetectorConstruction : public G4VUserDetectorConstruction
     G4double worldSizeXY;
     G4double worldSizeZ;
 
-    G4int   fFeLayers;      // number of layers (hadronic calorimeter, iron)
-    G4int   fWLayers;       // number of layers (hadronic calorimeter, tungsten)
+    G4int   fFeLayers;      // number of layers (all iron modules)
+    G4int   fWLayers;       // number of layers (all tungsten modules)
+
+    // transverse readout grids (cells in x and y per layer)
+    G4int   fGapNofCellsX;
+    G4int   fGapNofCellsY;
+    G4int   fFeNofCellsX;
+    G4int   fFeNofCellsY;
+    G4int   fWNofCellsX;
+    G4int   fWNofCellsY;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -136,6 +241,14 @@ inline G4int B4cDetectorConstruction::GetNumberOfHadronicLayers() const {
   return fFeLayers + fWLayers;
 }
 
+inline G4int B4cDetectorConstruction::GetNumberOfFeLayers() const {
+  return fFeLayers;
+}
+
+inline G4int B4cDetectorConstruction::GetNumberOfWLayers() const {
+  return fWLayers;
+}
+
 inline G4double B4cDetectorConstruction::GetEMLayerThickness() const {
   return layerThickness;
 }
@@ -148,6 +261,10 @@ inline G4double B4cDetectorConstruction::GetCalorimeterThickness() const {
   return calorThickness;
 }
 
+inline const B4cCalorimeterStack& B4cDetectorConstruction::GetStack() const {
+  return fStack;
+}
+
 
 #endif
 
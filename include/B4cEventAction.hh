@@ -32,16 +32,38 @@
 #define B4cEventAction_h 1
 
 #include "G4UserEventAction.hh"
-
-#include "B4cCalorHit.hh"
+#include "B4cRun.hh"
 
 #include "globals.hh"
 
+#include <vector>
+
+class B4cCalorimeterSD;
+class B4cRecordFile;
+class B4cAsyncWriter;
+class G4PrimaryParticle;
+
 /// Event action class
 ///
 /// In EndOfEventAction(), it prints the accumulated quantities of the energy 
 /// deposit and track lengths of charged particles in Absorber and Gap layers
-/// stored in the hits collections.
+/// read from the per-layer buffers of the sensitive detectors of this thread.
+/// The detectors of the calorimeter modules (B4cCalorimeterStack) are 
+/// grouped at the first event of each run: the absorber and active plates
+/// of the EM modules, and the plates of the iron and of the tungsten 
+/// modules, which sum into the HCAL totals; the layers of the modules of a
+/// group follow each other in its per-layer outputs.
+/// The energy discarded by each cut of the stacking action is saved with
+/// the event deposits in the "result" ntuple, together with the column 
+/// groups selected in its schema (B4cNtupleSchema); the readout cells fired in
+/// the EM gap and HCAL layers are saved in the "cells" ntuple.
+/// With /B4/output/async, the values of the histograms and of the result
+/// ntuple are copied in a record passed to the B4cAsyncWriter of this 
+/// thread, which fills them.
+/// With /B4/records/enable, the layer energies, totals and primary 
+/// particle are also written in the fixed-record file (B4cRecordFile) of
+/// this thread, and with /B4/voxels/enable the voxels fired in the 
+/// sensitive detectors are passed to the shower image file (B4cVoxelFile).
 
 class B4cEventAction : public G4UserEventAction
 {
@@ -54,16 +76,40 @@ public:
     
 private:
   // methods
-  B4cCalorHitsCollection* GetHitsCollection(G4int hcID,
-                                            const G4Event* event) const;
+  B4cCalorimeterSD* GetCalorimeterSD(const G4String& sdName) const;
+  void UpdateReadouts();
+  void AddTotals(G4int group, G4double& edep, G4double& trackLength) const;
+  B4cRun::SpeciesKey GetSpeciesKey(const G4PrimaryParticle* primary) const;
   void PrintEventStatistics(G4double absoEdep, G4double absoTrackLength,
                             G4double gapEdep, G4double gapTrackLength,
                             G4double hcalEdep, G4double hcalTrackLength) const;
+  void FillResultNtuple(const G4Event* event,
+                        G4double absoEdep, G4double gapEdep, G4double hcalEdep,
+                        G4double absoTrackLength, G4double gapTrackLength,
+                        G4double hcalTrackLength, G4double rMean, 
+                        G4double rRms, G4double killedTime,
+                        G4double killedEkin) const;
+  void FillWriterRecord(B4cAsyncWriter* writer, G4double* record,
+                        const G4Event* event);
+  void FillLayers(G4int group, std::vector<G4double>& layers) const;
+  void FillRecord(B4cRecordFile* recordFile, const G4Event* event,
+                  G4double absoEdep, G4double gapEdep,
+                  G4double hcalEdep) const;
+  void FillFiredCells(G4int group, G4int detector, G4int eventID) const;
+
+  // the output groups of the sensitive detectors
+  enum Group { kAbso, kGap, kFe, kW, kNofGroups };
+
+  struct Readout {
+    const B4cCalorimeterSD* sd;
+    G4int firstLayer;      ///< in its group
+    G4int firstCellLayer;  ///< in its detector of the cells ntuple
+  };
   
   // data members                   
-  G4int  fAbsHCID;
-  G4int  fGapHCID;
-  G4int  fHcalHCID;
+  std::vector<Readout> fReadouts[kNofGroups];
+  G4int fRunID;
+  std::vector<G4double> fLayers;   ///< buffer of the writer records
 };
                      
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,66 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cFastSimulationPhysics.hh
+/// \brief Definition of the B4cFastSimulationPhysics class
+
+#ifndef B4cFastSimulationPhysics_h
+#define B4cFastSimulationPhysics_h 1
+
+#include "G4VPhysicsConstructor.hh"
+#include "globals.hh"
+
+/// Physics constructor adding the fast simulation manager process to 
+/// gammas, electrons and positrons, so that the fast simulation models
+/// attached to the calorimeter envelopes in 
+/// B4cDetectorConstruction::ConstructSDandField() are called.
+///
+/// The process is active only in the runs with a fast simulation, the 
+/// shower library replay (/B4/showerLib/mode replay) or the parameterised
+/// showers (/B4/param/enable): UpdateActivation() is called by the run 
+/// action of each thread at the beginning of each run. An inactive 
+/// process is skipped by the stepping manager, so the default runs have
+/// no per-step cost, while the fast simulation can still be switched on
+/// between runs.
+
+class B4cFastSimulationPhysics : public G4VPhysicsConstructor
+{
+  public:
+    B4cFastSimulationPhysics(const G4String& name = "B4cFastSimulation");
+    virtual ~B4cFastSimulationPhysics();
+
+    virtual void ConstructParticle();
+    virtual void ConstructProcess();
+
+    // (de)activate the process of this thread according to the options 
+    // of the fast simulation models
+    static void UpdateActivation();
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
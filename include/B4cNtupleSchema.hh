@@ -0,0 +1,146 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cNtupleSchema.hh
+/// \brief Definition of the B4cNtupleSchema class
+
+#ifndef B4cNtupleSchema_h
+#define B4cNtupleSchema_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4VAnalysisManager;
+
+/// Configurable schema of the "result" ntuple
+///
+/// The event summary columns (em_total, em_rmean, em_rrms, killed_time,
+/// killed_ekin) are always booked; the other column groups are selected 
+/// with the /B4/ntuple/ commands:
+/// - layers: per-layer energy deposit vectors of the absorber, gap, 
+///   iron and tungsten layers (abso_layers, gap_layers, fe_layers, 
+///   w_layers),
+/// - totals: energy deposit per sub-detector and in total,
+/// - trackLengths: charged track length per sub-detector,
+/// - primary: PDG code, kinetic energy, position and direction of the 
+///   first primary particle,
+/// and, in a mixed run (/B4/mix/), the species index and beam energy of
+/// the event, and with pile-up (/B4/pileup/), the number of primaries and
+/// the deposits of the signal primary and of the overlays.
+/// The basket size (root backend) and compression level of the output 
+/// file are also set there (Geant4 10.3 and later).
+///
+/// The ntuple is booked by the run action at the first run, so the 
+/// commands apply if issued before the first /run/beamOn. The columns of
+/// a disabled group are not booked and the event action skips their
+/// computation. There is one schema per thread, which owns the storage of
+/// the vector columns; it fills the analysis manager of the thread which
+/// booked it, also when called from the asynchronous writer thread.
+
+class B4cNtupleSchema
+{
+  public:
+    struct Options {
+      Options();
+      G4bool layers;
+      G4bool totals;
+      G4bool trackLengths;
+      G4bool primary;
+      G4int  basketSize;   ///< bytes per basket, 0 = default
+      G4int  compression;  ///< compression level of the output file
+    };
+    static Options& GetOptions();
+
+    // scalar columns
+    enum {
+      kEmTotal = 0, kEmRMean, kEmRRms, kKilledTime, kKilledEkin,
+      kAbsoEdep, kGapEdep, kHcalEdep, kTotalEdep,
+      kAbsoLength, kGapLength, kHcalLength,
+      kPrimaryPdg, kPrimaryEkin, kPrimaryX, kPrimaryY, 
+      kPrimaryDirX, kPrimaryDirY, kPrimaryDirZ,
+      kSpecies, kBeamEnergy,
+      kNofPrimaries, kSignalEdep, kPileUpEdep,
+      kNofColumns 
+    };
+    // vector columns
+    enum { kAbsoLayers = 0, kGapLayers, kFeLayers, kWLayers, kNofVectors };
+
+    B4cNtupleSchema();
+    ~B4cNtupleSchema();
+
+    // schema of this thread, 0 if there is none
+    static B4cNtupleSchema* GetInstance();
+
+    // book the ntuple with the selected columns (once)
+    void Book(G4int ntupleId);
+    G4bool IsBooked() const;
+
+    // fill methods, which do nothing for a column not booked
+    G4bool HasColumn(G4int column) const;
+    G4bool HasVector(G4int vector) const;
+    void   Fill(G4int column, G4double value) const;
+    void   Fill(G4int column, G4int value) const;
+    std::vector<G4double>& GetVector(G4int vector);
+    void   AddRow() const;
+
+  private:
+    static G4ThreadLocal B4cNtupleSchema* fgInstance;
+
+    G4VAnalysisManager* fAnalysisManager;
+    G4int fNtupleId;
+    G4int fColumnId[kNofColumns];          ///< -1 if not booked
+    G4bool fHasVector[kNofVectors];
+    std::vector<G4double> fVectors[kNofVectors];
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline B4cNtupleSchema* B4cNtupleSchema::GetInstance() {
+  return fgInstance;
+}
+
+inline G4bool B4cNtupleSchema::IsBooked() const {
+  return fNtupleId >= 0;
+}
+
+inline G4bool B4cNtupleSchema::HasColumn(G4int column) const {
+  return fColumnId[column] >= 0;
+}
+
+inline G4bool B4cNtupleSchema::HasVector(G4int vector) const {
+  return fHasVector[vector];
+}
+
+inline std::vector<G4double>& B4cNtupleSchema::GetVector(G4int vector) {
+  return fVectors[vector];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,83 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cOverlapCache.hh
+/// \brief Definition of the B4cOverlapCache class
+
+#ifndef B4cOverlapCache_h
+#define B4cOverlapCache_h 1
+
+#include "globals.hh"
+
+class G4GenericMessenger;
+
+/// Persistent cache of the geometries validated against overlaps
+///
+/// The volumes are placed without the overlap test; Validate() is called
+/// once the geometry is built and runs the surface-point test of all 
+/// placements only for a geometry not validated before. The geometry is
+/// identified by a hash of its full description: the Geant4 version, the
+/// test resolution, the solid and material of each logical volume and the
+/// placement (mother, translation, rotation, replication) of each physical
+/// volume. The hashes of the geometries found free of overlaps are 
+/// appended to the cache file, one per line, and reused by later builds 
+/// of the same or of later jobs (e.g. the points of a parameter sweep).
+/// The log reports the time taken by the test or that it was skipped.
+///
+/// The cache is controlled with the /B4/overlaps/ commands:
+/// - useCache [true|false]
+/// - cacheFile <file>
+/// - force [true|false]: test even the geometries found in the cache
+/// - resolution <number of surface points>
+
+class B4cOverlapCache
+{
+  public:
+    B4cOverlapCache();
+    ~B4cOverlapCache();
+
+    // methods
+    G4bool Validate();
+
+  private:
+    // methods
+    G4String GetKey() const;
+    G4bool IsCached(const G4String& hash) const;
+    void   AddToCache(const G4String& hash) const;
+
+    // data members
+    G4GenericMessenger* fMessenger;
+    G4bool   fUseCache;    // option to skip the geometries in the cache
+    G4String fCacheFile;   // file of the validated geometry hashes
+    G4bool   fForce;       // option to test the geometries in the cache
+    G4int    fResolution;  // number of surface points per volume
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
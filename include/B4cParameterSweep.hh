@@ -0,0 +1,92 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cParameterSweep.hh
+/// \brief Definition of the B4cParameterSweep class
+
+#ifndef B4cParameterSweep_h
+#define B4cParameterSweep_h 1
+
+#include "globals.hh"
+
+#include <vector>
+#include <fstream>
+
+class B4cDetectorConstruction;
+class B4cRun;
+
+/// Parameter sweep driver
+///
+/// It reads a list of sweep points, one per line:
+///
+///   particle energy unit emlayers absorber gap felayers wlayers hadronic events
+///
+/// with the absorber, gap and hadronic layer thicknesses in mm; empty lines
+/// and lines starting with '#' are ignored. 
+///
+/// Execute() runs all points in the current process: the kernel is
+/// initialised once and, between points, only the geometry is rebuilt 
+/// (and only if its parameters changed), so the physics tables are kept.
+/// Each point writes its own output file (result_<point>) and appends one
+/// record to the summary file.
+
+class B4cParameterSweep
+{
+  public:
+    B4cParameterSweep(B4cDetectorConstruction* detConstruction);
+    ~B4cParameterSweep();
+
+    G4bool Load(const G4String& fileName);
+    void   Execute(const G4String& summaryFileName = "sweep_summary.csv");
+
+  private:
+    struct Point {
+      G4String particle;
+      G4double energy;
+      G4int    emLayers;
+      G4double absoThickness;
+      G4double gapThickness;
+      G4int    feLayers;
+      G4int    wLayers;
+      G4double hadLayerThickness;
+      G4int    nofEvents;
+    };
+
+    // methods
+    G4bool SameGeometry(const Point& first, const Point& second) const;
+    void   WriteSummary(std::ofstream& summary, G4int index, 
+                        const Point& point, const G4String& fileName,
+                        const B4cRun* run, G4double time) const;
+
+    // data members
+    B4cDetectorConstruction* fDetConstruction;
+    std::vector<Point> fPoints;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
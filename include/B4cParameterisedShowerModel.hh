@@ -0,0 +1,127 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cParameterisedShowerModel.hh
+/// \brief Definition of the B4cParameterisedShowerModel class
+
+#ifndef B4cParameterisedShowerModel_h
+#define B4cParameterisedShowerModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <set>
+#include <map>
+
+class G4Material;
+class G4LogicalVolume;
+class G4Region;
+class G4Navigator;
+class G4TouchableHistory;
+
+/// Parameterised (GFlash-style) electromagnetic shower model
+///
+/// The model is attached to the EM calorimeter envelope. When switched on
+/// with /B4/param/enable, it replaces the gammas, electrons and positrons
+/// above a configurable energy moving downstream by a parameterised 
+/// shower of the homogenised absorber/gap medium:
+/// - longitudinal profile: gamma distribution in radiation lengths, 
+///   dE/dt = E b (bt)^(a-1) exp(-bt) / Gamma(a), with b = 0.5 and the 
+///   maximum at t = (a-1)/b = ln(E/Ec) - 0.5 (e+-) or + 0.5 (gamma);
+/// - transverse profile: core (80%, Rm/5) and tail (20%, Rm) components
+///   of the form 2 r R^2 / (r^2 + R^2)^2;
+/// - sampling: each layer deposit is shared between the gap and the 
+///   absorber according to their minimum ionisation energy loss, 
+///   scaled by the e/mip ratio.
+///
+/// The radiation length, critical energy and Moliere radius of the 
+/// effective medium are computed from the absorber and gap materials and
+/// thicknesses of the EM module in which the shower starts (the envelope
+/// of the fast track), at its first use in each run. The shower is 
+/// sampled in spots deposited directly in the calorimeter SDs at the 
+/// middle of the absorber and gap of each layer of this module; the 
+/// energy beyond its last layer is not deposited (leakage into the 
+/// following modules is not parameterised).
+
+class B4cParameterisedShowerModel : public G4VFastSimulationModel
+{
+  public:
+    struct Options {
+      Options();
+      G4bool   enable;
+      G4double minEnergy;  ///< trigger threshold
+      G4int    nofSpots;   ///< spots per shower
+      G4double eOverMip;   ///< e/mip ratio of the gap sampling
+    };
+    static Options& GetOptions();
+
+    B4cParameterisedShowerModel(const G4String& name);
+    virtual ~B4cParameterisedShowerModel();
+
+    // methods from base class
+    virtual G4bool IsApplicable(const G4ParticleDefinition& particle);
+    virtual G4bool ModelTrigger(const G4FastTrack& fastTrack);
+    virtual void   DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep);
+
+    // set methods
+    void AddEnvelope(G4Region* region);
+
+  private:
+    // effective medium of one EM module
+    struct Medium {
+      Medium();
+      G4bool    valid;
+      G4int     nofLayers;
+      G4double  absoThickness;
+      G4double  gapThickness;
+      G4double  layerThickness;
+      G4double  radiationLength;
+      G4double  criticalEnergy;
+      G4double  moliereRadius;
+      G4double  gapFraction;
+    };
+
+    // methods
+    const Medium* GetMedium(const G4LogicalVolume* envelope);
+    G4bool Prepare(const G4LogicalVolume* envelope, Medium& medium) const;
+    void   Deposit(const G4ThreeVector& position, G4double edep);
+
+    // data members
+    std::set<G4Region*>  fEnvelopes;
+    G4Navigator*         fNavigator;
+    G4TouchableHistory*  fTouchable;
+    G4bool               fNavigatorReady;
+
+    // effective media per envelope (module) volume, computed once per run
+    G4int  fRunID;
+    std::map<const G4LogicalVolume*, Medium>  fMedia;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,132 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cParticleMix.hh
+/// \brief Definition of the B4cParticleMix class
+
+#ifndef B4cParticleMix_h
+#define B4cParticleMix_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4ParticleDefinition;
+
+/// Mixture of beam species interleaved within a run
+///
+/// Each species, added with /B4/mix/add <particle> <energy> <unit> 
+/// [weight], is a particle type at a fixed energy; /B4/mix/clear empties
+/// the mixture. When the mixture is not empty, the primary generator 
+/// draws the species of each event according to the weights, in place 
+/// of the /gun/ particle and energy and of the beam spectrum, and tags 
+/// the event with the species index. The event action then fills the 
+/// species and beam energy ntuple columns and the histograms of the 
+/// species, so that e.g. e/pi comes out of a single job.
+///
+/// The species are shared by all threads; their histograms are booked at
+/// the first run, so the mixture must be defined before it. There is one 
+/// instance per thread, created by the run action, which holds the 
+/// species of the current event.
+
+class B4cParticleMix
+{
+  public:
+    struct Species {
+      G4ParticleDefinition* particle;
+      G4double energy;
+      G4double weight;
+    };
+
+    B4cParticleMix();
+    ~B4cParticleMix();
+
+    // mixture of this thread, 0 if there is none
+    static B4cParticleMix* GetInstance();
+
+    // commands (master)
+    void AddSpecies(const G4String& species);
+    void ClearSpecies();
+
+    // species shared by all threads
+    static G4bool IsEnabled();
+    static G4int  GetNofSpecies();
+    static const Species& GetSpecies(G4int index);
+    static G4String GetLabel(G4int index);
+
+    // primary generator: draw the species of the event (tagged) or of
+    // an overlay primary (not tagged)
+    G4int SampleSpecies();
+    G4int DrawSpecies() const;
+    // event action: the species drawn for the current event, -1 if none
+    G4int GetEventSpecies() const;
+
+    // run action: histograms of the species booked at the first run, two
+    // per species (total and visible energy) from firstId
+    void SetHistoIds(G4int firstId, G4int nofSpecies);
+    G4bool HasHistos(G4int index) const;
+    G4int GetHistoId(G4int index, G4bool visible) const;
+
+  private:
+    static G4ThreadLocal B4cParticleMix* fgInstance;
+
+    G4int fEventSpecies;
+    G4int fFirstHistoId;
+    G4int fNofHistoSpecies;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline B4cParticleMix* B4cParticleMix::GetInstance() {
+  return fgInstance;
+}
+
+inline G4bool B4cParticleMix::IsEnabled() {
+  return GetNofSpecies() > 0;
+}
+
+inline G4int B4cParticleMix::GetEventSpecies() const {
+  return fEventSpecies;
+}
+
+inline void B4cParticleMix::SetHistoIds(G4int firstId, G4int nofSpecies) {
+  fFirstHistoId = firstId;
+  fNofHistoSpecies = nofSpecies;
+}
+
+inline G4bool B4cParticleMix::HasHistos(G4int index) const {
+  return index >= 0 && index < fNofHistoSpecies;
+}
+
+inline G4int B4cParticleMix::GetHistoId(G4int index, G4bool visible) const {
+  return fFirstHistoId + 2*index + ( visible ? 1 : 0 );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,90 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cPhysicsTableCache.hh
+/// \brief Definition of the B4cPhysicsTableCache class
+
+#ifndef B4cPhysicsTableCache_h
+#define B4cPhysicsTableCache_h 1
+
+#include "G4VStateDependent.hh"
+#include "globals.hh"
+
+class G4VUserPhysicsList;
+class G4GenericMessenger;
+
+/// Persistent physics table cache
+///
+/// The physics tables are stored on disk after they have been built and
+/// retrieved instead of rebuilt by later jobs. The tables are kept in
+/// a sub-directory of the cache directory named after a hash of:
+/// - the physics list name and the Geant4 version,
+/// - the material table (composition and density),
+/// - the production cuts of each region and the materials used in it.
+/// A change of any of these selects another sub-directory, so stale tables
+/// are never retrieved.
+///
+/// The key is evaluated when a run is initialised (Idle -> Init state 
+/// transition), just before the kernel builds the physics tables, and the
+/// cache hit or miss is reported in the log. After a miss the tables are
+/// stored once the kernel has built them (Init -> Idle transition).
+///
+/// The cache is off by default and controlled with the /B4/phys/ commands:
+/// - useCache [true|false]
+/// - cacheDir <directory>, created with its missing parents when the 
+///   tables are first stored
+
+class B4cPhysicsTableCache : public G4VStateDependent
+{
+  public:
+    B4cPhysicsTableCache(G4VUserPhysicsList* physicsList,
+                         const G4String& physicsListName);
+    virtual ~B4cPhysicsTableCache();
+
+    // methods from base class
+    virtual G4bool Notify(G4ApplicationState requestedState);
+
+  private:
+    // methods
+    G4String GetKey() const;
+    void Prepare();
+    void Store();
+
+    // data members
+    G4VUserPhysicsList* fPhysicsList;
+    G4String fPhysicsListName;
+    G4GenericMessenger* fMessenger;
+    G4bool   fUseCache;      // option to activate the cache
+    G4String fCacheDir;      // top directory of the cache
+    G4String fKey;           // description of the active tables
+    G4String fTableDir;      // directory of the active tables
+    G4bool   fStorePending;  // tables to be stored after they are built
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
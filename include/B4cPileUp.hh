@@ -0,0 +1,115 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cPileUp.hh
+/// \brief Definition of the B4cPileUp class
+
+#ifndef B4cPileUp_h
+#define B4cPileUp_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+/// Pile-up overlays and the primary of origin of each track
+///
+/// With /B4/pileup/mean > 0, the primary generator adds to the signal 
+/// primary of each event a number of overlay primaries drawn from a 
+/// Poisson distribution of this mean. Each overlay has its own species 
+/// and energy (drawn from the /B4/mix/ mixture if defined, otherwise the
+/// /gun/ particle and the beam spectrum), its own beam spot and a time 
+/// offset uniform within /B4/pileup/timeWindow. The kill and defer times
+/// of the stacking action apply to the global time, offsets included.
+///
+/// The primaries are numbered in the order of their vertices, the signal
+/// being primary 0. The stacking action records the primary of origin of
+/// each new track, a look-up by track ID, so the calorimeter SDs can add
+/// each deposit to its primary: the cost per event grows with the number
+/// of tracks and primaries, not with the number of cells.
+///
+/// The options are shared by all threads; there is one instance per 
+/// thread, created by the run action.
+
+class B4cPileUp
+{
+  public:
+    struct Options {
+      Options();
+      G4double mean;        ///< mean number of overlays, 0 = no pile-up
+      G4double timeWindow;  ///< range of the overlay time offsets
+    };
+    static Options& GetOptions();
+
+    B4cPileUp();
+    ~B4cPileUp();
+
+    // pile-up of this thread, 0 if there is none
+    static B4cPileUp* GetInstance();
+    static G4bool IsEnabled();
+
+    // primary generator
+    G4int SampleNofOverlays() const;
+    G4double SampleTimeOffset() const;
+
+    // stacking action
+    void PrepareNewEvent();
+    void RecordTrack(G4int trackID, G4int parentID);
+
+    // primary of origin of a track of the current event, 0 if unknown
+    G4int GetPrimary(G4int trackID) const;
+    G4int GetNofPrimaries() const;
+
+  private:
+    static G4ThreadLocal B4cPileUp* fgInstance;
+
+    std::vector<G4int> fPrimaryOf;  ///< primary index per track ID
+    G4int fNofPrimaries;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline B4cPileUp* B4cPileUp::GetInstance() {
+  return fgInstance;
+}
+
+inline G4bool B4cPileUp::IsEnabled() {
+  return GetOptions().mean > 0.;
+}
+
+inline G4int B4cPileUp::GetPrimary(G4int trackID) const {
+  return ( trackID > 0 && trackID < G4int(fPrimaryOf.size()) ) 
+         ? fPrimaryOf[trackID] : 0;
+}
+
+inline G4int B4cPileUp::GetNofPrimaries() const {
+  return fNofPrimaries;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,116 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cPrimaryFile.hh
+/// \brief Definition of the B4cPrimaryFile class
+
+#ifndef B4cPrimaryFile_h
+#define B4cPrimaryFile_h 1
+
+#include "B4cPrimaryFormat.hh"
+
+#include "globals.hh"
+
+#include <vector>
+
+/// Random access to the events of a primary event file
+///
+/// A binary file (B4cPrimaryFormat.hh) is memory-mapped read-only, so the
+/// events are read in place, in any order, and each worker thread can map
+/// the same file and read its own events without locking; Prefetch() 
+/// asks the kernel to read the pages of the coming events in advance. 
+/// Any other file is parsed at Open() as an ASCII HEPEVT file into the
+/// same in-memory layout: per event, a line with the number of entries 
+/// NHEP followed by NHEP lines "ISTHEP IDHEP JDAHEP1 JDAHEP2 PHEP1 PHEP2
+/// PHEP3 PHEP5" (GeV), of which the final-state entries (ISTHEP = 1) are
+/// kept, at the beam entry point.
+
+class B4cPrimaryFile
+{
+  public:
+    B4cPrimaryFile();
+    ~B4cPrimaryFile();
+
+    // methods
+    G4bool Open(const G4String& fileName);
+    void   Close();
+    void   Prefetch(G4int firstEvent, G4int nofEvents) const;
+
+    // get methods
+    G4bool IsOpen() const;
+    G4bool IsMapped() const;
+    const G4String& GetFileName() const;
+    G4int  GetNofEvents() const;
+    G4int  GetNofParticles(G4int event) const;
+    const B4cPrimaryRecord* GetParticles(G4int event) const;
+
+  private:
+    // methods
+    G4bool Map();
+    G4bool ReadHepEvt();
+
+    // data members
+    G4String fFileName;
+    void*    fMapping;
+    size_t   fMappingSize;
+    const uint64_t*         fIndex;      ///< nofEvents+1 entries
+    const B4cPrimaryRecord* fParticles;
+    G4int    fNofEvents;
+    std::vector<uint64_t>         fOwnedIndex;      ///< HEPEVT file
+    std::vector<B4cPrimaryRecord> fOwnedParticles;  ///< HEPEVT file
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline G4bool B4cPrimaryFile::IsOpen() const {
+  return fIndex != 0;
+}
+
+inline G4bool B4cPrimaryFile::IsMapped() const {
+  return fMapping != 0;
+}
+
+inline const G4String& B4cPrimaryFile::GetFileName() const {
+  return fFileName;
+}
+
+inline G4int B4cPrimaryFile::GetNofEvents() const {
+  return fNofEvents;
+}
+
+inline G4int B4cPrimaryFile::GetNofParticles(G4int event) const {
+  return fIndex[event+1] - fIndex[event];
+}
+
+inline const B4cPrimaryRecord* B4cPrimaryFile::GetParticles(G4int event) const {
+  return fParticles + fIndex[event];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,73 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cPrimaryFormat.hh
+/// \brief Layout of the primary event files
+
+#ifndef B4cPrimaryFormat_h
+#define B4cPrimaryFormat_h 1
+
+#include <stdint.h>
+
+/// Layout of the primary event files replayed by the primary generator
+/// (/B4/replay/), written e.g. with reader/b4cprimaries.py.
+///
+/// A file starts with a header of kPrimaryHeaderSize bytes, followed by
+/// the event index, nofEvents+1 uint64 giving the first particle of each
+/// event (the last one is nofParticles), then by the nofParticles 
+/// particle records, all in native (little-endian) byte order. The 
+/// particles of event i are the records index[i] to index[i+1]-1, so an
+/// event is found without reading the events before it.
+///
+/// The momenta are in MeV, the vertex positions in mm relative to the
+/// beam entry point at the front face of the world, the times in ns. 
+/// The consecutive particles of an event with the same vertex position 
+/// and time share one primary vertex.
+
+const char     kPrimaryMagic[8] = { 'B', '4', 'C', 'P', 'R', 'I', '0', '1' };
+const uint32_t kPrimaryVersion = 1;
+const uint32_t kPrimaryHeaderSize = 4096;
+
+struct B4cPrimaryHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t nofEvents;
+  uint64_t nofParticles;
+};
+
+struct B4cPrimaryRecord
+{
+  int32_t pdg;
+  int32_t reserved;
+  double  px, py, pz;
+  double  x, y, z, t;
+};
+
+#endif
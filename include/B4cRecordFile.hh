@@ -0,0 +1,136 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cRecordFile.hh
+/// \brief Definition of the B4cRecordFile class
+
+#ifndef B4cRecordFile_h
+#define B4cRecordFile_h 1
+
+#include "B4cRecordFormat.hh"
+
+#include "globals.hh"
+
+#include <cstdio>
+#include <vector>
+
+/// Writer of the fixed-record event files
+///
+/// With /B4/records/enable, the event action fills one record per event
+/// with the event number, the PDG code and kinetic energy of the first
+/// primary particle, the energy deposit per sub-detector and in total, 
+/// and the energy deposit of each absorber, gap, iron and tungsten layer.
+/// The record layout is fixed at the beginning of each run from the 
+/// current geometry and described in the file header (B4cRecordFormat.hh),
+/// so the file can be memory-mapped with the reader library
+/// (reader/B4cRecordReader.hh) or numpy (reader/b4crecords.py).
+///
+/// The records are buffered in chunks of chunkSize records; each full
+/// chunk is appended to the file and the number of records in the header
+/// is updated, so the file can be read while the run is going on.
+/// The writer is controlled with the /B4/records/ commands:
+/// - enable [true|false]
+/// - chunkSize <number of records>
+/// - file <base name of the record files>
+/// There is one file per run and event thread: the base name is suffixed
+/// with the run number and, in multi-threaded mode, the thread number.
+
+class B4cRecordFile
+{
+  public:
+    struct Options {
+      Options();
+      G4bool   enable;
+      G4int    chunkSize;
+      G4String fileName;
+    };
+    static Options& GetOptions();
+
+    // fields of a record
+    enum {
+      kEventID = 0, kPrimaryPdg, kPrimaryEkin,
+      kAbsoEdep, kGapEdep, kHcalEdep, kTotalEdep,
+      kAbsoLayers, kGapLayers, kFeLayers, kWLayers,
+      kNofFields
+    };
+
+    B4cRecordFile();
+    ~B4cRecordFile();
+
+    // record file of this thread, 0 if there is none
+    static B4cRecordFile* GetInstance();
+
+    // open and close the file (begin and end of run)
+    void Open(G4int runID, G4int nofAbsoLayers, G4int nofGapLayers,
+              G4int nofFeLayers, G4int nofWLayers);
+    void Close();
+    G4bool IsOpen() const;
+
+    // event thread: get the next record (zeroed), then commit it
+    G4double* NewRecord();
+    void      CommitRecord();
+
+    // record layout
+    G4int GetOffset(G4int field) const;
+    G4int GetCount(G4int field) const;
+
+  private:
+    // methods
+    void WriteChunk();
+
+    // data members
+    static G4ThreadLocal B4cRecordFile* fgInstance;
+
+    std::FILE*            fFile;
+    B4cRecordHeader       fHeader;
+    size_t                fChunkSize;
+    size_t                fNofChunkRecords;
+    std::vector<G4double> fChunk;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline B4cRecordFile* B4cRecordFile::GetInstance() {
+  return fgInstance;
+}
+
+inline G4bool B4cRecordFile::IsOpen() const {
+  return fFile != 0;
+}
+
+inline G4int B4cRecordFile::GetOffset(G4int field) const {
+  return fHeader.fields[field].offset;
+}
+
+inline G4int B4cRecordFile::GetCount(G4int field) const {
+  return fHeader.fields[field].count;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,77 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cRecordFormat.hh
+/// \brief Layout of the fixed-record event files
+
+#ifndef B4cRecordFormat_h
+#define B4cRecordFormat_h 1
+
+#include <stdint.h>
+
+/// Layout of the fixed-record event files (/B4/records/), shared by
+/// the writer (B4cRecordFile) and the reader library (B4cRecordReader),
+/// which does not depend on Geant4.
+///
+/// A file starts with a header of kRecordHeaderSize bytes, so that the 
+/// records are page-aligned in a memory mapping, followed by the records
+/// in native (little-endian) byte order. A record is a fixed number of 
+/// doubles (nofValues), so the records of a file form a contiguous 
+/// nofRecords x nofValues row-major array. The header describes each 
+/// field of a record by its name, its first value and its number of 
+/// values (the per-layer fields have one value per layer).
+///
+/// The records are appended in chunks; nofRecords in the header is 
+/// updated after each chunk is written, so a reader can map the file
+/// while it is being written and only sees complete records.
+/// The energies are in MeV.
+
+const char     kRecordMagic[8] = { 'B', '4', 'C', 'R', 'E', 'C', '0', '1' };
+const uint32_t kRecordVersion = 1;
+const uint32_t kRecordHeaderSize = 4096;
+const uint32_t kRecordMaxFields = 32;
+
+struct B4cRecordField
+{
+  char     name[24];
+  uint32_t offset;   ///< index of the first value in the record
+  uint32_t count;    ///< number of values
+};
+
+struct B4cRecordHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint32_t nofValues;   ///< doubles per record
+  uint32_t nofFields;
+  uint64_t nofRecords;  ///< complete records, updated after each chunk
+  B4cRecordField fields[kRecordMaxFields];
+};
+
+#endif
@@ -0,0 +1,141 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cRegionSettings.hh
+/// \brief Definition of the B4cRegionSettings class
+
+#ifndef B4cRegionSettings_h
+#define B4cRegionSettings_h 1
+
+#include "G4VUserRegionInformation.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4Region;
+class G4LogicalVolume;
+class G4ParticleDefinition;
+class G4ProductionCuts;
+class G4UserLimits;
+class G4GenericMessenger;
+
+/// Production cuts, user limits and stacking thresholds of one calorimeter
+/// section
+///
+/// The production cut and the stacking thresholds are attached to the 
+/// region of the section (also as its user information) and so apply to
+/// all its volumes, the envelopes and layers included; the user limits 
+/// are attached only to the sensitive (read-out) plates, as the single 
+/// limits of the original example:
+/// - the production cut, the same for gammas, electrons, positrons and 
+///   protons,
+/// - the user limits applied by the G4StepLimiterPhysics processes:
+///   maximum step length, maximum track time and minimum kinetic energy,
+/// - the thresholds applied by B4cStackingAction to the secondaries 
+///   created in the region: the tracks created after the kill time are
+///   killed, the ones created after the defer time are deferred to the
+///   waiting stack, and the tracks of the listed particle types below the
+///   kill energy are killed.
+///
+/// They are set with the commands of the given directory, on the master;
+/// the region objects are shared by all threads and the new values are 
+/// used from the next run:
+/// - cut <value> <unit>
+/// - maxStep <value> <unit>
+/// - maxTime <value> <unit>
+/// - minEkin <value> <unit>
+/// - killTime <value> <unit>
+/// - deferTime <value> <unit>
+/// - killEkin <value> <unit>
+/// - killParticles <particle names>
+
+class B4cRegionSettings : public G4VUserRegionInformation
+{
+  public:
+    B4cRegionSettings(const G4String& directory, const G4String& title,
+                      G4double cut, G4double minEkin);
+    virtual ~B4cRegionSettings();
+
+    // methods from base class
+    virtual void Print() const;
+
+    // attach the settings to the region and the user limits to a 
+    // sensitive volume (at each geometry construction)
+    void Apply(G4Region* region) const;
+    void Apply(G4LogicalVolume* volume) const;
+
+    // set methods
+    void SetCut(G4double cut);
+    void SetMaxStep(G4double maxStep);
+    void SetMaxTime(G4double maxTime);
+    void SetMinEkin(G4double minEkin);
+    void SetKillTime(G4double killTime);
+    void SetDeferTime(G4double deferTime);
+    void SetKillEkin(G4double killEkin);
+    void SetKillParticles(const G4String& names);
+
+    // get methods
+    G4double GetCut() const;
+    const G4UserLimits* GetUserLimits() const;
+    G4double GetKillTime() const;
+    G4double GetDeferTime() const;
+    G4double GetKillEkin() const;
+    G4bool   IsKillParticle(const G4ParticleDefinition* particle) const;
+
+  private:
+    G4ProductionCuts*   fCuts;
+    G4UserLimits*       fLimits;
+    G4GenericMessenger* fMessenger;
+    G4String            fName;
+    G4double            fKillTime;
+    G4double            fDeferTime;
+    G4double            fKillEkin;
+    std::vector<G4String> fKillParticles;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline const G4UserLimits* B4cRegionSettings::GetUserLimits() const {
+  return fLimits;
+}
+
+inline G4double B4cRegionSettings::GetKillTime() const {
+  return fKillTime;
+}
+
+inline G4double B4cRegionSettings::GetDeferTime() const {
+  return fDeferTime;
+}
+
+inline G4double B4cRegionSettings::GetKillEkin() const {
+  return fKillEkin;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
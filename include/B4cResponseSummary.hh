@@ -0,0 +1,97 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cResponseSummary.hh
+/// \brief Definition of the B4cResponseSummary class
+
+#ifndef B4cResponseSummary_h
+#define B4cResponseSummary_h 1
+
+#include "B4cRun.hh"
+
+#include "globals.hh"
+
+#include <iosfwd>
+#include <map>
+#include <vector>
+
+/// End of run summary of the calorimeter response, on the master
+///
+/// For each primary species of the (merged) run (B4cRun::SpeciesKey: the
+/// species of a mixed run, or else the particle type at the /gun/energy 
+/// setting) it prints the mean 
+/// visible energy, the energy resolution sigma/E of the visible energy 
+/// and the EM sampling fraction, with their statistical errors (see 
+/// B4cRun::Response). The response of the last run of each particle type
+/// and energy is kept, so that e/pi, the ratio of the mean visible 
+/// energies of electrons and charged pions of the same energy, is printed
+/// for each energy once both have been simulated, in the same run or in 
+/// two runs of the same job.
+///
+/// On request, the same values, with the histogram of the total deposit
+/// over the primary energy, are written in a JSON file per run, 
+/// <file>_r<run>.json. This is controlled with the /B4/summary/ commands:
+/// - json [true|false], false by default
+/// - file <base name of the JSON files>
+
+class B4cResponseSummary
+{
+  public:
+    struct Options {
+      Options();
+      G4bool   json;
+      G4String fileName;
+    };
+    static Options& GetOptions();
+
+    B4cResponseSummary();
+    ~B4cResponseSummary();
+
+    void Report(const B4cRun* run);
+
+  private:
+    // methods
+    std::vector<G4double> GetEOverPiEnergies() const;
+    G4bool FindEOverPi(G4double energy, B4cRun::SpeciesKey& electron,
+                       B4cRun::SpeciesKey& pion) const;
+    G4bool GetEOverPi(G4double energy, G4double& ratio, G4double& error,
+                      B4cRun::SpeciesKey& electron, 
+                      B4cRun::SpeciesKey& pion) const;
+    void Print(const B4cRun* run) const;
+    void WriteJson(const B4cRun* run) const;
+    void WriteStatistics(std::ostream& output, const char* name,
+                         const B4cRunningStatistics& statistics) const;
+
+    // data members
+    // key = particle type and energy (no mixture index)
+    std::map<B4cRun::SpeciesKey, B4cRun::Response> fLastResponses;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
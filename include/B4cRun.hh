@@ -0,0 +1,259 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cRun.hh
+/// \brief Definition of the B4cRun class
+
+#ifndef B4cRun_h
+#define B4cRun_h 1
+
+#include "G4Run.hh"
+#include "globals.hh"
+
+#include "B4cRunningStatistics.hh"
+
+#include <map>
+#include <vector>
+
+class G4LogicalVolume;
+
+/// Run class
+///
+/// It accumulates the per-event energy deposits of one thread:
+/// - sums and sums of squares of the absorber, gap and HCAL deposits
+/// - the gap deposit per EM layer
+/// - the number of steps timed in the sensitive detectors and their time
+/// - the number of steps in each calorimeter region
+/// - the number of steps and the time spent in each logical volume 
+///   (navigation benchmark, /B4/nav/timing)
+/// - the queue depth and stalls of the asynchronous event writer
+/// - the response per primary species, the species drawn in a mixed run
+///   (/B4/mix/) or else the particle type of the first primary and the 
+///   /gun/energy setting (see SpeciesKey): streaming statistics of the primary energy, of the visible (gap) 
+///   energy, of the total deposit and of the EM sampling fraction
+///   gap/(absorber + gap), and a histogram of the total deposit over the
+///   primary energy
+///
+/// In multi-threaded mode each worker fills its own B4cRun and the
+/// worker runs are summed into the master run via Merge() at the end
+/// of run, so no locking is needed while events are processed.
+
+class B4cRun : public G4Run
+{
+  public:
+    B4cRun(G4int nofEmLayers);
+    virtual ~B4cRun();
+
+    // methods from base class
+    virtual void Merge(const G4Run* run);
+
+    // methods to accumulate data
+    void AddEvent(G4double absoEdep, G4double gapEdep, G4double hcalEdep);
+    void AddEmLayerEdep(G4int layer, G4double edep);
+    void AddSDTiming(G4double nofSteps, G4double seconds);
+    void AddRegionStep(G4int region);
+    void AddVolumeStep(const G4LogicalVolume* volume, G4double seconds,
+                       G4bool timed);
+    void AddWriterRecord(G4double depth, G4double stallSeconds);
+    struct SpeciesKey;
+    void AddResponse(const SpeciesKey& key, G4double primaryEnergy, 
+                     G4double absoEdep, G4double gapEdep, G4double hcalEdep);
+
+    // get methods
+    G4int    GetNofEmLayers() const;
+    G4double GetEmLayerEdep(G4int layer) const;
+    G4double GetMean(G4int quantity) const;
+    G4double GetRms(G4int quantity) const;
+    G4double GetNofTimedSDSteps() const;
+    G4double GetTimedSDSeconds() const;
+    G4double GetNofRegionSteps(G4int region) const;
+    static const char* GetRegionName(G4int region);
+    G4double GetNofWriterRecords() const;
+    G4double GetMeanWriterDepth() const;
+    G4double GetMaxWriterDepth() const;
+    G4double GetNofWriterStalls() const;
+    G4double GetWriterStallSeconds() const;
+
+    // primary species: the index of the species of a mixed run (-1 if
+    // there is none), its particle type and nominal energy, so that the
+    // same particle at two energies has two responses
+    struct SpeciesKey {
+      SpeciesKey(G4int index, G4int pdgCode, G4double nominalEnergy)
+        : species(index), pdg(pdgCode), energy(nominalEnergy) {}
+      G4bool operator<(const SpeciesKey& other) const;
+      G4int    species;
+      G4int    pdg;
+      G4double energy;
+    };
+
+    // response of a primary species
+    enum { kNofResponseBins = 110 };   ///< bins of 0.01 in total/E
+    struct Response {
+      Response();
+      void Merge(const Response& other);
+      B4cRunningStatistics primaryEnergy;
+      B4cRunningStatistics visible;
+      B4cRunningStatistics total;
+      B4cRunningStatistics samplingFraction;
+      G4double histogram[kNofResponseBins + 1];   ///< last bin = overflow
+    };
+    const std::map<SpeciesKey, Response>& GetResponses() const;
+
+    // steps in a logical volume
+    struct VolumeSteps {
+      VolumeSteps() : steps(0.), timedSteps(0.), seconds(0.) {}
+      G4double steps;       ///< all steps
+      G4double timedSteps;  ///< steps timed (not the first of a track)
+      G4double seconds;     ///< time of the timed steps
+    };
+    const std::map<const G4LogicalVolume*, VolumeSteps>& 
+      GetVolumeSteps() const;
+
+    // indices of the accumulated quantities
+    enum { kAbso = 0, kGap, kHcal, kTotal, kNofQuantities };
+
+    // indices of the regions
+    enum { kEmRegion = 0, kFeRegion, kWRegion, kOtherRegion, kNofRegions };
+
+  private:
+    G4int fNofRecorded;
+    G4double fSum[kNofQuantities];
+    G4double fSum2[kNofQuantities];
+    std::vector<G4double> fEmLayerEdep;
+    G4double fNofTimedSDSteps;
+    G4double fTimedSDSeconds;
+    G4double fNofRegionSteps[kNofRegions];
+    G4double fNofWriterRecords;
+    G4double fWriterDepthSum;
+    G4double fWriterMaxDepth;
+    G4double fNofWriterStalls;
+    G4double fWriterStallSeconds;
+    std::map<SpeciesKey, Response> fResponses;
+    std::map<const G4LogicalVolume*, VolumeSteps> fVolumeSteps;
+    const G4LogicalVolume* fLastVolume;     ///< volume of the previous step
+    VolumeSteps*           fLastVolumeSteps; ///< and its entry
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void B4cRun::AddEmLayerEdep(G4int layer, G4double edep) {
+  fEmLayerEdep[layer] += edep;
+}
+
+inline void B4cRun::AddSDTiming(G4double nofSteps, G4double seconds) {
+  fNofTimedSDSteps += nofSteps;
+  fTimedSDSeconds += seconds;
+}
+
+inline void B4cRun::AddRegionStep(G4int region) {
+  fNofRegionSteps[region] += 1.;
+}
+
+inline void B4cRun::AddVolumeStep(const G4LogicalVolume* volume, 
+                                  G4double seconds, G4bool timed) {
+  // the map is searched only when the volume changes
+  if ( volume != fLastVolume ) {
+    fLastVolume = volume;
+    fLastVolumeSteps = &fVolumeSteps[volume];
+  }
+  fLastVolumeSteps->steps += 1.;
+  if ( timed ) {
+    fLastVolumeSteps->timedSteps += 1.;
+    fLastVolumeSteps->seconds += seconds;
+  }
+}
+
+inline const std::map<const G4LogicalVolume*, B4cRun::VolumeSteps>& 
+B4cRun::GetVolumeSteps() const {
+  return fVolumeSteps;
+}
+
+inline G4double B4cRun::GetNofRegionSteps(G4int region) const {
+  return fNofRegionSteps[region];
+}
+
+inline void B4cRun::AddWriterRecord(G4double depth, G4double stallSeconds) {
+  fNofWriterRecords += 1.;
+  fWriterDepthSum += depth;
+  if ( depth > fWriterMaxDepth ) fWriterMaxDepth = depth;
+  if ( stallSeconds > 0. ) {
+    fNofWriterStalls += 1.;
+    fWriterStallSeconds += stallSeconds;
+  }
+}
+
+inline G4double B4cRun::GetNofWriterRecords() const {
+  return fNofWriterRecords;
+}
+
+inline G4double B4cRun::GetMeanWriterDepth() const {
+  return fNofWriterRecords > 0. ? fWriterDepthSum/fNofWriterRecords : 0.;
+}
+
+inline G4double B4cRun::GetMaxWriterDepth() const {
+  return fWriterMaxDepth;
+}
+
+inline G4double B4cRun::GetNofWriterStalls() const {
+  return fNofWriterStalls;
+}
+
+inline G4double B4cRun::GetWriterStallSeconds() const {
+  return fWriterStallSeconds;
+}
+
+inline G4bool 
+B4cRun::SpeciesKey::operator<(const SpeciesKey& other) const {
+  if ( species != other.species ) return species < other.species;
+  if ( pdg != other.pdg ) return pdg < other.pdg;
+  return energy < other.energy;
+}
+
+inline const std::map<B4cRun::SpeciesKey, B4cRun::Response>& 
+B4cRun::GetResponses() const {
+  return fResponses;
+}
+
+inline G4double B4cRun::GetNofTimedSDSteps() const {
+  return fNofTimedSDSteps;
+}
+
+inline G4double B4cRun::GetTimedSDSeconds() const {
+  return fTimedSDSeconds;
+}
+
+inline G4int B4cRun::GetNofEmLayers() const {
+  return fEmLayerEdep.size();
+}
+
+inline G4double B4cRun::GetEmLayerEdep(G4int layer) const {
+  return fEmLayerEdep[layer];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
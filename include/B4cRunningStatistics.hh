@@ -0,0 +1,95 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cRunningStatistics.hh
+/// \brief Definition of the B4cRunningStatistics class
+
+#ifndef B4cRunningStatistics_h
+#define B4cRunningStatistics_h 1
+
+#include "globals.hh"
+
+/// Streaming mean and variance of a quantity (Welford's algorithm)
+///
+/// The values are added one by one, without storing them and without 
+/// the cancellation of the sum of squares method. Two accumulators, e.g.
+/// of two worker runs, are combined with Merge() (Chan et al.). The 
+/// statistical errors of the mean, of the rms and of the relative rms
+/// assume a large number of values.
+
+class B4cRunningStatistics
+{
+  public:
+    B4cRunningStatistics();
+    ~B4cRunningStatistics();
+
+    // methods
+    void Add(G4double value);
+    void Merge(const B4cRunningStatistics& other);
+    void Reset();
+
+    // get methods
+    G4double GetN() const;
+    G4double GetMean() const;
+    G4double GetVariance() const;          ///< unbiased (n-1)
+    G4double GetRms() const;
+    G4double GetMeanError() const;
+    G4double GetRmsError() const;
+    G4double GetRelativeRms() const;       ///< rms/mean, e.g. sigma/E
+    G4double GetRelativeRmsError() const;
+
+  private:
+    G4double fN;
+    G4double fMean;
+    G4double fM2;   ///< sum of the squared deviations from the mean
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void B4cRunningStatistics::Add(G4double value) {
+  fN += 1.;
+  G4double delta = value - fMean;
+  fMean += delta/fN;
+  fM2 += delta*(value - fMean);
+}
+
+inline G4double B4cRunningStatistics::GetN() const {
+  return fN;
+}
+
+inline G4double B4cRunningStatistics::GetMean() const {
+  return fMean;
+}
+
+inline G4double B4cRunningStatistics::GetVariance() const {
+  return ( fN > 1. ) ? fM2/(fN - 1.) : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
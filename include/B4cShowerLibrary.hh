@@ -0,0 +1,161 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cShowerLibrary.hh
+/// \brief Definition of the B4cShowerLibrary class
+
+#ifndef B4cShowerLibrary_h
+#define B4cShowerLibrary_h 1
+
+#include "globals.hh"
+
+#include <vector>
+#include <stdint.h>
+
+/// Library of frozen electromagnetic showers
+///
+/// The library is a binary file, memory-mapped read-only and shared by all
+/// threads, made of:
+/// - a Header,
+/// - the index of the first shower of each (particle, energy bin), 
+///   nofParticles*nofEnergyBins+1 uint64_t values,
+/// - the Shower records, sorted by particle and energy bin,
+/// - the Spot records of all showers.
+///
+/// The energy bins are logarithmic between the minimum and maximum energy.
+/// A spot is an energy deposit cluster given in the shower frame (origin at
+/// the start point, z axis along the direction of the particle) as a 
+/// fraction of the shower energy.
+/// The library is written by B4cShowerLibraryRecorder at the end of a 
+/// recording run and replayed by B4cShowerLibraryModel.
+
+class B4cShowerLibrary
+{
+  public:
+    // particle types of the library
+    enum { kGamma = 0, kElectron, kPositron, kNofParticles };
+
+    // file records
+    struct Header {
+      char     magic[8];        ///< "B4CSLIB1"
+      uint32_t nofParticles;
+      uint32_t nofEnergyBins;
+      double   minEnergy;       ///< MeV
+      double   maxEnergy;       ///< MeV
+      uint64_t nofShowers;
+      uint64_t nofSpots;
+      char     geometry[128];   ///< description of the recording geometry
+    };
+    struct Shower {
+      double   energy;          ///< MeV
+      uint64_t firstSpot;
+      uint32_t nofSpots;
+      uint32_t reserved;
+    };
+    struct Spot {
+      float x, y, z;            ///< mm, in the shower frame
+      float fraction;           ///< of the shower energy
+    };
+
+    // shower being recorded
+    struct RecordedShower {
+      G4int    particle;
+      G4double energy;
+      std::vector<Spot> spots;
+    };
+
+    // Return the library mapped from the given file, shared by all threads;
+    // 0 if the file cannot be read
+    static const B4cShowerLibrary* Open(const G4String& fileName);
+
+    // Write a library file from the recorded showers
+    static G4bool Write(const G4String& fileName, const G4String& geometry,
+                        G4int nofEnergyBins, 
+                        G4double minEnergy, G4double maxEnergy,
+                        const std::vector<RecordedShower>& showers);
+
+    // Particle type of the library from the PDG code, -1 if the particle 
+    // is not handled
+    static G4int GetParticleIndex(G4int pdgCode);
+
+    // Energy bin, -1 outside the library range
+    static G4int GetEnergyBin(G4double energy, G4int nofEnergyBins,
+                              G4double minEnergy, G4double maxEnergy);
+
+    // get methods
+    G4bool HasShowers(G4int particle, G4double energy) const;
+    const Shower* FindShower(G4int particle, G4double energy,
+                             G4double random) const;
+    const Spot* GetSpots(const Shower* shower) const;
+    G4String GetGeometry() const;
+    G4int    GetNofShowers() const;
+    G4int    GetNofEnergyBins() const;
+    G4double GetMinEnergy() const;
+    G4double GetMaxEnergy() const;
+
+  private:
+    B4cShowerLibrary(const G4String& fileName);
+    ~B4cShowerLibrary();
+    G4bool IsValid() const;
+
+    friend class B4cShowerLibraryRegistry;
+
+    // data members
+    void*           fData;      ///< mapped file
+    size_t          fSize;
+    const Header*   fHeader;
+    const uint64_t* fIndex;
+    const Shower*   fShowers;
+    const Spot*     fSpots;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline const B4cShowerLibrary::Spot* 
+B4cShowerLibrary::GetSpots(const Shower* shower) const {
+  return fSpots + shower->firstSpot;
+}
+
+inline G4int B4cShowerLibrary::GetNofShowers() const {
+  return fHeader->nofShowers;
+}
+
+inline G4int B4cShowerLibrary::GetNofEnergyBins() const {
+  return fHeader->nofEnergyBins;
+}
+
+inline G4double B4cShowerLibrary::GetMinEnergy() const {
+  return fHeader->minEnergy;
+}
+
+inline G4double B4cShowerLibrary::GetMaxEnergy() const {
+  return fHeader->maxEnergy;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
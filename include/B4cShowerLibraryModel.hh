@@ -0,0 +1,140 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cShowerLibraryModel.hh
+/// \brief Definition of the B4cShowerLibraryModel class
+
+#ifndef B4cShowerLibraryModel_h
+#define B4cShowerLibraryModel_h 1
+
+#include "G4VFastSimulationModel.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include "B4cShowerLibrary.hh"
+
+#include <set>
+
+class G4LogicalVolume;
+class G4Region;
+class G4Navigator;
+class G4TouchableHistory;
+class G4Step;
+
+/// Frozen shower fast simulation model
+///
+/// The model is attached to the calorimeter envelopes and triggers on
+/// gammas, electrons and positrons below a configurable energy in the
+/// trigger volumes (the absorber plates of the first EM and tungsten
+/// modules). Depending on the
+/// mode set with /B4/showerLib/mode:
+/// - replay: the particle is killed and a shower of the same particle type
+///   and energy bin, picked at random in the library, is deposited in the
+///   calorimeter SDs, rotated to the particle direction and scaled to its
+///   energy;
+/// - record: the particle is tracked normally and its shower is recorded
+///   by B4cShowerLibraryRecorder, which writes the library at end of run;
+/// - validate: the particle is tracked normally and both its full 
+///   simulation and library showers are accounted per layer by 
+///   B4cShowerLibraryRecorder, which prints the comparison at end of run.
+/// Only the replay mode is a fast simulation: ModelTrigger() has no side
+/// effect and never triggers in the other modes. In the record and 
+/// validation modes the showers are started by StartShower(), called by 
+/// the stepping action for each step, with the same selection applied to
+/// its pre-step point.
+///
+/// The options are shared by the models of all threads and set on the 
+/// master between runs.
+
+class B4cShowerLibraryModel : public G4VFastSimulationModel
+{
+  public:
+    enum Mode { kOff = 0, kReplay, kRecord, kValidate };
+
+    struct Options {
+      Options();
+      void SetMode(const G4String& mode);
+      G4int    mode;
+      G4String fileName;          ///< library file
+      G4double maxEnergy;         ///< trigger threshold
+      G4double minEnergy;         ///< lower edge of the library
+      G4int    nofEnergyBins;     ///< logarithmic energy bins
+      G4int    maxShowersPerBin;  ///< recorded per bin and thread
+      G4double spotSize;          ///< size of the recorded clusters
+    };
+    static Options& GetOptions();
+
+    B4cShowerLibraryModel(const G4String& name);
+    virtual ~B4cShowerLibraryModel();
+
+    // model of this thread, 0 if there is none
+    static B4cShowerLibraryModel* GetInstance();
+
+    // methods from base class
+    virtual G4bool IsApplicable(const G4ParticleDefinition& particle);
+    virtual G4bool ModelTrigger(const G4FastTrack& fastTrack);
+    virtual void   DoIt(const G4FastTrack& fastTrack, G4FastStep& fastStep);
+
+    // record and validation modes: start the shower of the particle of
+    // the step (called by the stepping action before the step is recorded)
+    void StartShower(const G4Step* step);
+
+    // set methods
+    void AddEnvelope(G4Region* region);
+    void SetTriggerVolumes(G4LogicalVolume* absorberLV, 
+                           G4LogicalVolume* tungstenLV);
+
+  private:
+    // methods
+    G4bool IsTriggered(const G4LogicalVolume* volume, G4double energy) const;
+    const B4cShowerLibrary* GetLibrary();
+    void DepositShower(const B4cShowerLibrary* library,
+                       const B4cShowerLibrary::Shower* shower,
+                       G4double energy, const G4ThreeVector& position,
+                       const G4ThreeVector& direction, G4bool validation);
+
+    // data members
+    static G4ThreadLocal B4cShowerLibraryModel* fgInstance;
+
+    std::set<G4Region*>  fEnvelopes;
+    G4LogicalVolume*     fAbsorberLV;
+    G4LogicalVolume*     fTungstenLV;
+    const B4cShowerLibrary* fLibrary;
+    G4int                fLibraryRunID;
+    G4Navigator*         fNavigator;
+    G4TouchableHistory*  fTouchable;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline B4cShowerLibraryModel* B4cShowerLibraryModel::GetInstance() {
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,130 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cShowerLibraryRecorder.hh
+/// \brief Definition of the B4cShowerLibraryRecorder class
+
+#ifndef B4cShowerLibraryRecorder_h
+#define B4cShowerLibraryRecorder_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include "B4cShowerLibrary.hh"
+
+#include <map>
+#include <vector>
+#include <unordered_map>
+
+class G4Step;
+class G4Track;
+class G4VTouchable;
+class B4cCalorimeterSD;
+
+/// Recorder of the showers started by B4cShowerLibraryModel
+///
+/// A shower is started by the model, from the stepping action, for a 
+/// particle below the trigger energy; the steps of this particle and of all its descendants created
+/// afterwards are then followed until the end of event:
+/// - in record mode their energy deposits are clustered in spots of the 
+///   shower frame and the showers are written in the library at end of run;
+/// - in validation mode their energy deposits are summed per sensitive
+///   detector and layer, as are the deposits of the library showers 
+///   replayed by the model for the same particles, and both profiles are
+///   compared at end of run.
+///
+/// The steps are passed by the stepping action, which owns the recorder.
+/// There is one recorder per thread; the data of all threads are merged
+/// at the end of run and written/printed by the master in WriteResults().
+
+class B4cShowerLibraryRecorder
+{
+  public:
+    B4cShowerLibraryRecorder();
+    ~B4cShowerLibraryRecorder();
+
+    // recorder of this thread, 0 if there is none
+    static B4cShowerLibraryRecorder* GetInstance();
+
+    // description of the current geometry, saved in the library
+    static G4String GetGeometryDescription();
+
+    // method called by the stepping action
+    void RecordStep(const G4Step* step);
+
+    // methods called by the shower library model, the shower starts at
+    // the pre-step point
+    G4bool IsInShower(const G4Step* step);
+    G4bool StartShower(const G4Step* step, G4int particle);
+    void   AddLibraryDeposit(const B4cCalorimeterSD* calorSD,
+                             const G4VTouchable* touchable, G4double edep);
+
+    // methods called by the event and run actions
+    void EndOfEvent();
+    void EndOfRun();
+    static void WriteResults();
+
+  private:
+    struct ShowerInProgress {
+      G4int    particle;
+      G4double energy;
+      G4double startTime;
+      G4ThreeVector origin;
+      G4ThreeVector u, v, w;   ///< shower frame
+      std::unordered_map<G4long, G4int> spotOfVoxel;
+      std::vector<G4double> spotSums;  ///< e, e*x, e*y, e*z per spot
+    };
+    typedef std::map<G4String, std::vector<G4double> > Profiles;
+
+    // methods
+    G4int FindShower(const G4Track* track, G4double creationTime);
+    void AddDeposit(Profiles& profiles, const B4cCalorimeterSD* calorSD,
+                    const G4VTouchable* touchable, G4double edep);
+    void AddSpot(ShowerInProgress& shower, const G4ThreeVector& position,
+                 G4double edep);
+
+    // data members
+    static G4ThreadLocal B4cShowerLibraryRecorder* fgInstance;
+
+    std::unordered_map<G4int, G4int> fShowerOfTrack;  ///< track ID -> shower
+    std::vector<ShowerInProgress> fShowers;           ///< of this event
+    std::vector<B4cShowerLibrary::RecordedShower> fRecorded;
+    std::vector<G4int> fNofRecordedPerBin;
+    G4int    fNofValidatedShowers;
+    Profiles fFullProfiles;
+    Profiles fLibraryProfiles;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline B4cShowerLibraryRecorder* B4cShowerLibraryRecorder::GetInstance() {
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,90 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cStackingAction.hh
+/// \brief Definition of the B4cStackingAction class
+
+#ifndef B4cStackingAction_h
+#define B4cStackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+/// Stacking action class
+///
+/// The secondaries are killed or deferred to the waiting stack according
+/// to the thresholds of the region in which they are created 
+/// (B4cRegionSettings, set with the /B4/region/{em,fe,w}/ commands):
+/// - by their creation time (killTime, deferTime),
+/// - by their kinetic energy, for the listed particle types (killEkin,
+///   killParticles).
+/// The primary tracks are never killed. With pile-up (/B4/pileup/), the
+/// primary of origin of every new track is recorded in B4cPileUp.
+///
+/// The kinetic energy of the killed tracks is summed per cut for each 
+/// event and reported by the event action in the ntuple. There is one 
+/// stacking action per thread.
+
+class B4cStackingAction : public G4UserStackingAction
+{
+  public:
+    B4cStackingAction();
+    virtual ~B4cStackingAction();
+
+    // stacking action of this thread, 0 if there is none
+    static B4cStackingAction* GetInstance();
+
+    // methods from base class
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track);
+    virtual void PrepareNewEvent();
+
+    // get methods
+    G4double GetKilledEnergy(G4int cut) const;
+
+    // indices of the cuts
+    enum { kTimeCut = 0, kEnergyCut, kNofCuts };
+
+  private:
+    static G4ThreadLocal B4cStackingAction* fgInstance;
+
+    G4double fKilledEnergy[kNofCuts];  ///< in the current event
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline B4cStackingAction* B4cStackingAction::GetInstance() {
+  return fgInstance;
+}
+
+inline G4double B4cStackingAction::GetKilledEnergy(G4int cut) const {
+  return fKilledEnergy[cut];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,85 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cSteppingAction.hh
+/// \brief Definition of the B4cSteppingAction class
+
+#ifndef B4cSteppingAction_h
+#define B4cSteppingAction_h 1
+
+#include "G4UserSteppingAction.hh"
+#include "globals.hh"
+
+#include <chrono>
+
+class G4Region;
+class B4cShowerLibraryRecorder;
+
+/// Stepping action class
+///
+/// It counts the steps in each calorimeter region (B4cRun::kEmRegion, ...)
+/// in the run of this thread and passes the steps to the shower library
+/// model, which starts the showers to record or validate, and to the 
+/// shower library recorder, which it owns.
+///
+/// With the navigation benchmark (/B4/nav/timing, Options) it also counts
+/// the steps in each logical volume and attributes to the volume of the
+/// pre-step point the time elapsed since the previous step of the track,
+/// which covers the navigation, the physics and the user actions of the
+/// step; the first step of each track is counted but not timed.
+
+class B4cSteppingAction : public G4UserSteppingAction
+{
+  public:
+    B4cSteppingAction(B4cShowerLibraryRecorder* recorder);
+    virtual ~B4cSteppingAction();
+
+    // methods from base class
+    virtual void UserSteppingAction(const G4Step* step);
+
+    // options shared by all threads, set with the /B4/nav/ commands
+    struct Options {
+      Options() : timing(false) {}
+      G4bool timing;  ///< count and time the steps per logical volume
+    };
+    static Options& GetOptions();
+
+  private:
+    // methods
+    G4int GetRegionIndex(const G4Region* region) const;
+
+    // data members
+    B4cShowerLibraryRecorder* fRecorder;
+    const G4Region* fLastRegion;   ///< region of the previous step
+    G4int           fLastIndex;    ///< and its index
+    std::chrono::steady_clock::time_point fLastTime; ///< of the previous step
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,156 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cVoxelFile.hh
+/// \brief Definition of the B4cVoxelFile class
+
+#ifndef B4cVoxelFile_h
+#define B4cVoxelFile_h 1
+
+#include "B4cVoxelFormat.hh"
+
+#include "globals.hh"
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+/// Writer of the voxelised shower image files
+///
+/// With /B4/voxels/enable and a voxel grid set with /B4/sd/voxelsX and
+/// voxelsY, the event action passes the voxels fired in the calorimeter 
+/// sensitive detectors to the file of this thread, which merges the 
+/// absorber and gap deposits of a voxel and stores each event in sparse
+/// COO form (B4cVoxelFormat.hh).
+///
+/// The events are buffered in chunks, compressed with zlib and appended 
+/// to the file when chunkSize events or maxVoxels voxels are buffered, 
+/// so the memory does not grow with the number of events nor with the 
+/// shower energy beyond one chunk. The index of the chunks is written 
+/// when the file is closed; it is read by the reader library 
+/// (reader/B4cVoxelReader.hh) or reader/b4cvoxels.py for random access
+/// by event number.
+/// The writer is controlled with the /B4/voxels/ commands:
+/// - enable [true|false]
+/// - chunkSize <number of events>
+/// - maxVoxels <number of voxels per chunk>
+/// - compression <zlib level 0-9>
+/// - file <base name of the image files>
+/// There is one file per run and event thread, named as the record 
+/// files (B4cRecordFile).
+
+class B4cVoxelFile
+{
+  public:
+    struct Options {
+      Options();
+      G4bool   enable;
+      G4int    chunkSize;
+      G4int    maxVoxels;
+      G4int    compression;
+      G4String fileName;
+    };
+    static Options& GetOptions();
+
+    B4cVoxelFile();
+    ~B4cVoxelFile();
+
+    // image file of this thread, 0 if there is none
+    static B4cVoxelFile* GetInstance();
+
+    // open and close the file (begin and end of run)
+    void Open(G4int runID, G4int nofVoxelsX, G4int nofVoxelsY, 
+              G4int nofEmLayers, G4int nofLayers, G4double sizeXY);
+    void Close();
+    G4bool IsOpen() const;
+
+    // event thread: add the fired voxels of an event, in any order and 
+    // possibly several times
+    void BeginEvent(G4int eventID);
+    void AddVoxel(G4int voxel, G4double edep);
+    void EndEvent();
+
+    // statistics of the open file
+    G4double GetNofEvents() const;
+    G4double GetNofVoxels() const;
+    G4double GetNofBytes() const;
+
+  private:
+    // methods
+    void Write(const void* data, size_t size);
+    void WriteChunk();
+
+    // data members
+    static G4ThreadLocal B4cVoxelFile* fgInstance;
+
+    std::FILE*     fFile;
+    uint64_t       fOffset;
+    B4cVoxelHeader fHeader;
+    G4double       fNofVoxels;
+    std::vector<B4cVoxelChunk> fIndex;
+
+    // current event and chunk
+    G4int                fEventID;
+    std::vector<std::pair<G4int, G4double> > fEventVoxels;
+    std::vector<int32_t>  fEventIDs;
+    std::vector<uint32_t> fNofEventVoxels;
+    std::vector<uint32_t> fVoxels;
+    std::vector<float>    fEdeps;
+    std::vector<char>     fPayload;
+    std::vector<unsigned char> fCompressed;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline B4cVoxelFile* B4cVoxelFile::GetInstance() {
+  return fgInstance;
+}
+
+inline G4bool B4cVoxelFile::IsOpen() const {
+  return fFile != 0;
+}
+
+inline void B4cVoxelFile::AddVoxel(G4int voxel, G4double edep) {
+  fEventVoxels.push_back(std::make_pair(voxel, edep));
+}
+
+inline G4double B4cVoxelFile::GetNofEvents() const {
+  return fHeader.nofEvents;
+}
+
+inline G4double B4cVoxelFile::GetNofVoxels() const {
+  return fNofVoxels;
+}
+
+inline G4double B4cVoxelFile::GetNofBytes() const {
+  return fOffset;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
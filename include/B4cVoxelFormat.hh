@@ -0,0 +1,84 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cVoxelFormat.hh
+/// \brief Layout of the voxelised shower image files
+
+#ifndef B4cVoxelFormat_h
+#define B4cVoxelFormat_h 1
+
+#include <stdint.h>
+
+/// Layout of the voxelised shower image files (/B4/voxels/), shared by
+/// the writer (B4cVoxelFile) and the reader library (B4cVoxelReader).
+///
+/// The image of an event is stored in sparse COO form: the index of each
+/// fired voxel, (layer*nofVoxelsY + iy)*nofVoxelsX + ix, in increasing 
+/// order, and its energy deposit in MeV. The layers are the EM layers 
+/// (absorber and gap deposits summed) followed by the hadronic layers.
+///
+/// The file starts with a B4cVoxelHeader. The events are grouped in 
+/// chunks, each a B4cVoxelChunk followed by a zlib-compressed payload:
+///   int32_t  eventID[nofEvents]
+///   uint32_t nofEventVoxels[nofEvents]
+///   uint32_t voxel[nofVoxels]
+///   float    edep[nofVoxels]
+/// The array of the B4cVoxelChunk of all chunks, written at indexOffset
+/// when the file is closed, gives random access by event number. If the
+/// file was not closed (indexOffset = 0), the chunks can still be read in
+/// sequence.
+
+const char     kVoxelMagic[8] = { 'B', '4', 'C', 'V', 'O', 'X', '0', '1' };
+const uint32_t kVoxelVersion = 1;
+
+struct B4cVoxelHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t nofVoxelsX;
+  uint32_t nofVoxelsY;
+  uint32_t nofLayers;
+  double   sizeXY;       ///< transverse size of the grid (mm)
+  uint32_t nofEmLayers;  ///< the hadronic layers follow
+  uint32_t reserved;
+  uint64_t nofEvents;    ///< the following are set when the file is closed
+  uint64_t nofChunks;
+  uint64_t indexOffset;
+};
+
+struct B4cVoxelChunk
+{
+  int32_t  firstEventID;
+  int32_t  lastEventID;
+  uint32_t nofEvents;
+  uint32_t nofVoxels;
+  uint64_t payloadOffset;  ///< position of the compressed payload
+  uint64_t payloadSize;    ///< compressed size in bytes
+};
+
+#endif
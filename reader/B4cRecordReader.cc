@@ -0,0 +1,187 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cRecordReader.cc
+/// \brief Implementation of the B4cRecordReader class
+
+#include "B4cRecordReader.hh"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRecordReader::B4cRecordReader()
+ : fFileName(),
+   fDescriptor(-1),
+   fMapping(0),
+   fMappingSize(0),
+   fHeader(0),
+   fNofRecords(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRecordReader::~B4cRecordReader()
+{
+  Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool B4cRecordReader::Open(const std::string& fileName)
+{
+  Close();
+
+  fDescriptor = open(fileName.c_str(), O_RDONLY);
+  if ( fDescriptor < 0 ) return false;
+  fFileName = fileName;
+
+  if ( ! Map() ) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRecordReader::Close()
+{
+  Unmap();
+  if ( fDescriptor >= 0 ) close(fDescriptor);
+  fDescriptor = -1;
+  fFileName.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool B4cRecordReader::Refresh()
+{
+  if ( fDescriptor < 0 ) return false;
+  Unmap();
+  return Map();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool B4cRecordReader::Map()
+{
+  struct stat status;
+  if ( fstat(fDescriptor, &status) != 0 ) return false;
+  size_t size = status.st_size;
+  if ( size < sizeof(B4cRecordHeader) ) return false;
+
+  void* mapping = mmap(0, size, PROT_READ, MAP_SHARED, fDescriptor, 0);
+  if ( mapping == MAP_FAILED ) return false;
+  fMapping = mapping;
+  fMappingSize = size;
+
+  const B4cRecordHeader* header 
+    = static_cast<const B4cRecordHeader*>(fMapping);
+  if ( std::memcmp(header->magic, kRecordMagic, sizeof(kRecordMagic)) != 0 ||
+       header->version != kRecordVersion || 
+       header->headerSize < sizeof(B4cRecordHeader) ||
+       header->headerSize > size ||
+       header->nofFields > kRecordMaxFields ||
+       header->nofValues == 0 ) {
+    Unmap();
+    return false;
+  }
+
+  // The fields must lie in the record, the accessors do not check them
+  for ( uint32_t i=0; i<header->nofFields; ++i ) {
+    const B4cRecordField& field = header->fields[i];
+    if ( field.offset > header->nofValues ||
+         field.count > header->nofValues - field.offset ) {
+      Unmap();
+      return false;
+    }
+  }
+  fHeader = header;
+
+  // Only the records counted in the header are complete; the file may 
+  // be shorter if it was truncated
+  size_t recordSize = fHeader->nofValues*sizeof(double);
+  size_t nofRecords = (size - fHeader->headerSize)/recordSize;
+  fNofRecords = fHeader->nofRecords < nofRecords 
+              ? fHeader->nofRecords : nofRecords;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRecordReader::Unmap()
+{
+  if ( fMapping ) munmap(fMapping, fMappingSize);
+  fMapping = 0;
+  fMappingSize = 0;
+  fHeader = 0;
+  fNofRecords = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::string B4cRecordReader::GetFieldName(size_t field) const
+{
+  // the name is not null-terminated if it fills the array
+  const char* name = fHeader->fields[field].name;
+  return std::string(name, strnlen(name, sizeof(fHeader->fields[field].name)));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+size_t B4cRecordReader::FindField(const std::string& name) const
+{
+  for ( size_t i=0; i<GetNofFields(); ++i ) {
+    if ( GetFieldName(i) == name ) return i;
+  }
+  return npos;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+size_t B4cRecordReader::GetFieldOffset(const std::string& name) const
+{
+  size_t field = FindField(name);
+  return field == npos ? npos : GetFieldOffset(field);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+size_t B4cRecordReader::GetFieldCount(const std::string& name) const
+{
+  size_t field = FindField(name);
+  return field == npos ? 0 : GetFieldCount(field);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,140 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cRecordReader.hh
+/// \brief Definition of the B4cRecordReader class
+
+#ifndef B4cRecordReader_h
+#define B4cRecordReader_h 1
+
+#include "B4cRecordFormat.hh"
+
+#include <cstddef>
+#include <string>
+
+/// Reader of the fixed-record event files (B4cRecordFormat.hh)
+///
+/// The file is memory-mapped read-only and the records are exposed 
+/// without copy as a contiguous GetNofRecords() x GetNofValues() 
+/// row-major array of doubles; a field (e.g. "gap_layers") is a block
+/// of GetFieldCount() values at GetFieldOffset() in each record.
+/// Refresh() maps again a file which is still being written, to see the
+/// records appended since it was opened. It does not depend on Geant4:
+///
+///   B4cRecordReader reader;
+///   if ( reader.Open("records_r0.b4r") ) {
+///     size_t gap = reader.GetFieldOffset("gap_layers");
+///     for ( size_t i=0; i<reader.GetNofRecords(); ++i ) {
+///       const double* gapLayers = reader.GetRecord(i) + gap;
+///       ...
+///     }
+///   }
+
+class B4cRecordReader
+{
+  public:
+    B4cRecordReader();
+    ~B4cRecordReader();
+
+    // map a file, false if it cannot be read or is not a record file
+    bool Open(const std::string& fileName);
+    void Close();
+    bool IsOpen() const;
+    // map again an open file, to see the records appended since
+    bool Refresh();
+
+    // records
+    size_t GetNofRecords() const;
+    size_t GetNofValues() const;
+    const double* GetData() const;
+    const double* GetRecord(size_t index) const;
+
+    // fields, the offset of an unknown field is npos
+    static const size_t npos = static_cast<size_t>(-1);
+    size_t GetNofFields() const;
+    std::string GetFieldName(size_t field) const;
+    size_t GetFieldOffset(size_t field) const;
+    size_t GetFieldCount(size_t field) const;
+    size_t GetFieldOffset(const std::string& name) const;
+    size_t GetFieldCount(const std::string& name) const;
+
+  private:
+    // methods
+    bool Map();
+    void Unmap();
+    size_t FindField(const std::string& name) const;
+
+    // data members
+    std::string  fFileName;
+    int          fDescriptor;
+    void*        fMapping;
+    size_t       fMappingSize;
+    const B4cRecordHeader* fHeader;
+    size_t       fNofRecords;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline bool B4cRecordReader::IsOpen() const {
+  return fHeader != 0;
+}
+
+inline size_t B4cRecordReader::GetNofRecords() const {
+  return fNofRecords;
+}
+
+inline size_t B4cRecordReader::GetNofValues() const {
+  return fHeader ? fHeader->nofValues : 0;
+}
+
+inline const double* B4cRecordReader::GetData() const {
+  return fHeader 
+    ? reinterpret_cast<const double*>(
+        static_cast<const char*>(fMapping) + fHeader->headerSize)
+    : 0;
+}
+
+inline const double* B4cRecordReader::GetRecord(size_t index) const {
+  return GetData() + index*GetNofValues();
+}
+
+inline size_t B4cRecordReader::GetNofFields() const {
+  return fHeader ? fHeader->nofFields : 0;
+}
+
+inline size_t B4cRecordReader::GetFieldOffset(size_t field) const {
+  return fHeader->fields[field].offset;
+}
+
+inline size_t B4cRecordReader::GetFieldCount(size_t field) const {
+  return fHeader->fields[field].count;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
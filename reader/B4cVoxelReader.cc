@@ -0,0 +1,234 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cVoxelReader.cc
+/// \brief Implementation of the B4cVoxelReader class
+
+#include "B4cVoxelReader.hh"
+
+#include <algorithm>
+#include <cstring>
+
+#include <zlib.h>
+
+namespace {
+  const size_t kNoChunk = static_cast<size_t>(-1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cVoxelReader::B4cVoxelReader()
+ : fFile(0),
+   fHeader(),
+   fIndex(),
+   fFirstEntries(),
+   fNofEvents(0),
+   fChunk(kNoChunk),
+   fCompressed(),
+   fPayload(),
+   fEventIDs(0),
+   fNofEventVoxels(0),
+   fVoxels(0),
+   fEdeps(0),
+   fFirstVoxels()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cVoxelReader::~B4cVoxelReader()
+{
+  Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool B4cVoxelReader::Open(const std::string& fileName)
+{
+  Close();
+
+  fFile = std::fopen(fileName.c_str(), "rb");
+  if ( ! fFile ) return false;
+
+  if ( std::fread(&fHeader, sizeof(fHeader), 1, fFile) != 1 ||
+       std::memcmp(fHeader.magic, kVoxelMagic, sizeof(kVoxelMagic)) != 0 ||
+       fHeader.version != kVoxelVersion ) {
+    Close();
+    return false;
+  }
+
+  // A file which was not closed has no index
+  bool indexed = fHeader.indexOffset ? ReadIndex() : ScanChunks();
+  if ( ! indexed ) {
+    Close();
+    return false;
+  }
+
+  fFirstEntries.clear();
+  fNofEvents = 0;
+  for ( size_t i=0; i<fIndex.size(); ++i ) {
+    fFirstEntries.push_back(fNofEvents);
+    fNofEvents += fIndex[i].nofEvents;
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cVoxelReader::Close()
+{
+  if ( fFile ) std::fclose(fFile);
+  fFile = 0;
+  fIndex.clear();
+  fFirstEntries.clear();
+  fNofEvents = 0;
+  fChunk = kNoChunk;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool B4cVoxelReader::ReadIndex()
+{
+  fIndex.resize(fHeader.nofChunks);
+  if ( fIndex.empty() ) return true;
+  return std::fseek(fFile, fHeader.indexOffset, SEEK_SET) == 0 &&
+         std::fread(&fIndex[0], sizeof(B4cVoxelChunk), fIndex.size(), fFile)
+           == fIndex.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool B4cVoxelReader::ScanChunks()
+{
+  // The chunks follow each other after the header; a truncated last 
+  // chunk is ignored
+  fIndex.clear();
+  long offset = sizeof(fHeader);
+  B4cVoxelChunk chunk;
+  while ( std::fseek(fFile, offset, SEEK_SET) == 0 &&
+          std::fread(&chunk, sizeof(chunk), 1, fFile) == 1 ) {
+    if ( chunk.payloadOffset != offset + sizeof(chunk) ) break;
+    offset = chunk.payloadOffset + chunk.payloadSize;
+    if ( std::fseek(fFile, offset - 1, SEEK_SET) != 0 || 
+         std::fgetc(fFile) == EOF ) break;
+    fIndex.push_back(chunk);
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool B4cVoxelReader::LoadChunk(size_t chunk)
+{
+  if ( chunk == fChunk ) return true;
+  fChunk = kNoChunk;
+
+  const B4cVoxelChunk& info = fIndex[chunk];
+  fCompressed.resize(info.payloadSize);
+  if ( std::fseek(fFile, info.payloadOffset, SEEK_SET) != 0 ||
+       std::fread(&fCompressed[0], 1, info.payloadSize, fFile) 
+         != info.payloadSize ) return false;
+
+  size_t nofEvents = info.nofEvents;
+  size_t nofVoxels = info.nofVoxels;
+  uLongf size = nofEvents*(sizeof(int32_t) + sizeof(uint32_t))
+              + nofVoxels*(sizeof(uint32_t) + sizeof(float));
+  fPayload.resize(size);
+  if ( uncompress(&fPayload[0], &size, &fCompressed[0], info.payloadSize) 
+         != Z_OK || size != fPayload.size() ) return false;
+
+  const unsigned char* position = &fPayload[0];
+  fEventIDs = reinterpret_cast<const int32_t*>(position);
+  position += nofEvents*sizeof(int32_t);
+  fNofEventVoxels = reinterpret_cast<const uint32_t*>(position);
+  position += nofEvents*sizeof(uint32_t);
+  fVoxels = reinterpret_cast<const uint32_t*>(position);
+  position += nofVoxels*sizeof(uint32_t);
+  fEdeps = reinterpret_cast<const float*>(position);
+
+  fFirstVoxels.resize(nofEvents);
+  size_t first = 0;
+  for ( size_t i=0; i<nofEvents; ++i ) {
+    fFirstVoxels[i] = first;
+    first += fNofEventVoxels[i];
+  }
+  if ( first != nofVoxels ) return false;
+
+  fChunk = chunk;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cVoxelReader::GetEvent(size_t event, std::vector<uint32_t>& voxels,
+                              std::vector<float>& edeps) const
+{
+  const uint32_t* firstVoxel = fVoxels + fFirstVoxels[event];
+  const float* firstEdep = fEdeps + fFirstVoxels[event];
+  voxels.assign(firstVoxel, firstVoxel + fNofEventVoxels[event]);
+  edeps.assign(firstEdep, firstEdep + fNofEventVoxels[event]);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool B4cVoxelReader::ReadEntry(size_t entry, std::vector<uint32_t>& voxels,
+                               std::vector<float>& edeps, int* eventID)
+{
+  if ( entry >= fNofEvents ) return false;
+
+  size_t chunk 
+    = std::upper_bound(fFirstEntries.begin(), fFirstEntries.end(), entry)
+      - fFirstEntries.begin() - 1;
+  if ( ! LoadChunk(chunk) ) return false;
+
+  size_t event = entry - fFirstEntries[chunk];
+  GetEvent(event, voxels, edeps);
+  if ( eventID ) *eventID = fEventIDs[event];
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool B4cVoxelReader::ReadEvent(int eventID, std::vector<uint32_t>& voxels,
+                               std::vector<float>& edeps)
+{
+  // The event numbers increase in a file, but are not contiguous in 
+  // multi-threaded mode
+  for ( size_t chunk=0; chunk<fIndex.size(); ++chunk ) {
+    if ( eventID < fIndex[chunk].firstEventID ||
+         eventID > fIndex[chunk].lastEventID ) continue;
+    if ( ! LoadChunk(chunk) ) return false;
+    const int32_t* last = fEventIDs + fIndex[chunk].nofEvents;
+    const int32_t* found = std::lower_bound(fEventIDs, last, eventID);
+    if ( found == last || *found != eventID ) return false;
+    GetEvent(found - fEventIDs, voxels, edeps);
+    return true;
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
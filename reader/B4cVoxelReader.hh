@@ -0,0 +1,146 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cVoxelReader.hh
+/// \brief Definition of the B4cVoxelReader class
+
+#ifndef B4cVoxelReader_h
+#define B4cVoxelReader_h 1
+
+#include "B4cVoxelFormat.hh"
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/// Reader of the voxelised shower image files (B4cVoxelFormat.hh)
+///
+/// Open() reads the header and the chunk index; if the file was not 
+/// closed by the writer, the index is rebuilt from the chunk headers.
+/// An event is read by its entry number in the file or by its event 
+/// number; only its chunk is decompressed, and the last chunk read is 
+/// kept for the next events. It does not depend on Geant4:
+///
+///   B4cVoxelReader reader;
+///   std::vector<uint32_t> voxels;
+///   std::vector<float> edeps;
+///   if ( reader.Open("voxels_r0.b4v") && 
+///        reader.ReadEvent(42, voxels, edeps) ) {
+///     // voxel = (layer*GetNofVoxelsY() + iy)*GetNofVoxelsX() + ix
+///   }
+
+class B4cVoxelReader
+{
+  public:
+    B4cVoxelReader();
+    ~B4cVoxelReader();
+
+    // false if the file cannot be read or is not an image file
+    bool Open(const std::string& fileName);
+    void Close();
+    bool IsOpen() const;
+
+    // grid
+    size_t GetNofVoxelsX() const;
+    size_t GetNofVoxelsY() const;
+    size_t GetNofLayers() const;
+    size_t GetNofEmLayers() const;
+    double GetSizeXY() const;
+
+    // events
+    size_t GetNofEvents() const;
+    size_t GetNofChunks() const;
+    bool ReadEntry(size_t entry, std::vector<uint32_t>& voxels,
+                   std::vector<float>& edeps, int* eventID = 0);
+    bool ReadEvent(int eventID, std::vector<uint32_t>& voxels,
+                   std::vector<float>& edeps);
+
+  private:
+    // methods
+    bool ReadIndex();
+    bool ScanChunks();
+    bool LoadChunk(size_t chunk);
+    void GetEvent(size_t event, std::vector<uint32_t>& voxels,
+                  std::vector<float>& edeps) const;
+
+    // data members
+    std::FILE*     fFile;
+    B4cVoxelHeader fHeader;
+    std::vector<B4cVoxelChunk> fIndex;
+    std::vector<size_t> fFirstEntries;  ///< first entry of each chunk
+    size_t         fNofEvents;
+
+    // decompressed chunk
+    size_t                     fChunk;
+    std::vector<unsigned char> fCompressed;
+    std::vector<unsigned char> fPayload;
+    const int32_t*  fEventIDs;
+    const uint32_t* fNofEventVoxels;
+    const uint32_t* fVoxels;
+    const float*    fEdeps;
+    std::vector<size_t> fFirstVoxels;   ///< first voxel of each event
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline bool B4cVoxelReader::IsOpen() const {
+  return fFile != 0;
+}
+
+inline size_t B4cVoxelReader::GetNofVoxelsX() const {
+  return fHeader.nofVoxelsX;
+}
+
+inline size_t B4cVoxelReader::GetNofVoxelsY() const {
+  return fHeader.nofVoxelsY;
+}
+
+inline size_t B4cVoxelReader::GetNofLayers() const {
+  return fHeader.nofLayers;
+}
+
+inline size_t B4cVoxelReader::GetNofEmLayers() const {
+  return fHeader.nofEmLayers;
+}
+
+inline double B4cVoxelReader::GetSizeXY() const {
+  return fHeader.sizeXY;
+}
+
+inline size_t B4cVoxelReader::GetNofEvents() const {
+  return fNofEvents;
+}
+
+inline size_t B4cVoxelReader::GetNofChunks() const {
+  return fIndex.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
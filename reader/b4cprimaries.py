@@ -0,0 +1,114 @@
+"""Writer and reader of the exampleB4c primary event files (/B4/replay/).
+
+The layout is described in include/B4cPrimaryFormat.hh. An event is a
+list of particles (pdg, px, py, pz, x, y, z, t), the momenta in MeV, the
+vertex relative to the beam entry point in mm and the time in ns:
+
+    events = [[(11, 0., 0., 5000., 0., 0., 0., 0.),
+               (-11, 0., 0., 5000., 0., 0., 0., 0.)],
+              [(211, 100., 0., 2000., 0., 0., 0., 0.)]]
+    b4cprimaries.write("jets.b4p", events)
+    b4cprimaries.from_hepevt("taus.hepevt", "taus.b4p")
+
+    primaries = b4cprimaries.open("jets.b4p")
+    particles = primaries.event(1)         # structured array of PARTICLE
+
+The particles of the file are memory-mapped, without copy.
+"""
+
+import io
+
+import numpy as np
+
+MAGIC = b"B4CPRI01"
+VERSION = 1
+HEADER_SIZE = 4096
+
+HEADER = np.dtype([("magic", "S8"), ("version", "<u4"),
+                   ("headerSize", "<u4"), ("nofEvents", "<u8"),
+                   ("nofParticles", "<u8")])
+PARTICLE = np.dtype([("pdg", "<i4"), ("reserved", "<i4"),
+                     ("px", "<f8"), ("py", "<f8"), ("pz", "<f8"),
+                     ("x", "<f8"), ("y", "<f8"), ("z", "<f8"),
+                     ("t", "<f8")])
+
+
+def write(filename, events):
+    """Write the events, each a sequence of (pdg, px, py, pz, x, y, z, t)
+    tuples."""
+    index = np.zeros(len(events) + 1, dtype="<u8")
+    rows = []
+    for i, particles in enumerate(events):
+        for pdg, px, py, pz, x, y, z, t in particles:
+            rows.append((pdg, 0, px, py, pz, x, y, z, t))
+        index[i + 1] = len(rows)
+    header = np.zeros(1, dtype=HEADER)
+    header["magic"] = MAGIC
+    header["version"] = VERSION
+    header["headerSize"] = HEADER_SIZE
+    header["nofEvents"] = len(events)
+    header["nofParticles"] = len(rows)
+    with io.open(filename, "wb") as output:
+        output.write(header.tobytes())
+        output.write(b"\0" * (HEADER_SIZE - HEADER.itemsize))
+        output.write(index.tobytes())
+        output.write(np.array(rows, dtype=PARTICLE).tobytes())
+
+
+def read_hepevt(filename):
+    """Final-state particles (ISTHEP = 1) of the events of an ASCII HEPEVT
+    file, at the beam entry point."""
+    events = []
+    with io.open(filename, "r") as hepevt:
+        tokens = hepevt.read().split()
+    position = 0
+    while position < len(tokens):
+        nof_entries = int(tokens[position])
+        position += 1
+        particles = []
+        for _ in range(nof_entries):
+            entry = tokens[position:position + 8]
+            position += 8
+            if int(entry[0]) != 1:
+                continue
+            px, py, pz = [float(p) * 1000. for p in entry[4:7]]
+            particles.append((int(entry[1]), px, py, pz, 0., 0., 0., 0.))
+        events.append(particles)
+    return events
+
+
+def from_hepevt(hepevt, filename):
+    """Convert an ASCII HEPEVT file to a binary primary event file."""
+    write(filename, read_hepevt(hepevt))
+
+
+class PrimaryFile(object):
+    """Events of one file."""
+
+    def __init__(self, filename):
+        header = np.fromfile(filename, dtype=HEADER, count=1)
+        if len(header) != 1 or header["magic"][0] != MAGIC or \
+           header["version"][0] != VERSION:
+            raise IOError("%s is not a B4c primary event file" % filename)
+        header = header[0]
+        nof_events = int(header["nofEvents"])
+        nof_particles = int(header["nofParticles"])
+        offset = int(header["headerSize"])
+        self.index = np.memmap(filename, dtype="<u8", mode="r",
+                               offset=offset, shape=(nof_events + 1,))
+        offset += self.index.nbytes
+        if nof_particles == 0:
+            self.particles = np.zeros(0, dtype=PARTICLE)
+        else:
+            self.particles = np.memmap(filename, dtype=PARTICLE, mode="r",
+                                       offset=offset, shape=(nof_particles,))
+
+    def __len__(self):
+        return len(self.index) - 1
+
+    def event(self, i):
+        return self.particles[int(self.index[i]):int(self.index[i + 1])]
+
+
+def open(filename):
+    return PrimaryFile(filename)
@@ -0,0 +1,63 @@
+"""Reader of the exampleB4c fixed-record event files (/B4/records/).
+
+The layout is described in include/B4cRecordFormat.hh. The records are
+memory-mapped, without copy, as a (nofRecords, nofValues) float64 array
+and each field is a view of its columns:
+
+    records = b4crecords.open("records_r0_t0.b4r")
+    gap_layers = records["gap_layers"]     # (nofRecords, nofLayers)
+    energy = records["primary_ekin"]       # (nofRecords,)
+
+Only the records counted in the header are mapped, so a file which is
+still being written can be opened again to see the new records.
+"""
+
+import numpy as np
+
+MAGIC = b"B4CREC01"
+VERSION = 1
+MAX_FIELDS = 32
+
+FIELD = np.dtype([("name", "S24"), ("offset", "<u4"), ("count", "<u4")])
+HEADER = np.dtype([("magic", "S8"), ("version", "<u4"),
+                   ("headerSize", "<u4"), ("nofValues", "<u4"),
+                   ("nofFields", "<u4"), ("nofRecords", "<u8"),
+                   ("fields", FIELD, (MAX_FIELDS,))])
+
+
+class RecordFile(object):
+    """Records of one file: data is the array, fields maps the field
+    names to their (offset, count)."""
+
+    def __init__(self, filename):
+        header = np.fromfile(filename, dtype=HEADER, count=1)
+        if len(header) != 1 or header["magic"][0] != MAGIC or \
+           header["version"][0] != VERSION:
+            raise IOError("%s is not a B4c record file" % filename)
+        header = header[0]
+        self.filename = filename
+        self.fields = {}
+        for field in header["fields"][:int(header["nofFields"])]:
+            self.fields[field["name"].decode()] = \
+                (int(field["offset"]), int(field["count"]))
+        nof_values = int(header["nofValues"])
+        nof_records = int(header["nofRecords"])
+        if nof_records == 0:
+            self.data = np.zeros((0, nof_values))
+        else:
+            self.data = np.memmap(filename, dtype="<f8", mode="r",
+                                  offset=int(header["headerSize"]),
+                                  shape=(nof_records, nof_values))
+
+    def __len__(self):
+        return self.data.shape[0]
+
+    def __getitem__(self, name):
+        offset, count = self.fields[name]
+        if not name.endswith("_layers"):
+            return self.data[:, offset]
+        return self.data[:, offset:offset + count]
+
+
+def open(filename):
+    return RecordFile(filename)
@@ -0,0 +1,127 @@
+"""Reader of the exampleB4c voxelised shower image files (/B4/voxels/).
+
+The layout is described in include/B4cVoxelFormat.hh. Each event is a
+sparse COO image: the voxel indices, (layer*ny + iy)*nx + ix, and their
+energy deposits in MeV:
+
+    images = b4cvoxels.open("voxels_r0_t0.b4v")
+    voxels, edeps, event_id = images.entry(0)
+    voxels, edeps = images.event(42)
+    dense = images.dense(voxels, edeps)    # (layers, ny, nx)
+
+Only the chunk of the requested event is decompressed.
+"""
+
+import io
+import zlib
+
+import numpy as np
+
+MAGIC = b"B4CVOX01"
+VERSION = 1
+
+HEADER = np.dtype([("magic", "S8"), ("version", "<u4"),
+                   ("nofVoxelsX", "<u4"), ("nofVoxelsY", "<u4"),
+                   ("nofLayers", "<u4"), ("sizeXY", "<f8"),
+                   ("nofEmLayers", "<u4"), ("reserved", "<u4"),
+                   ("nofEvents", "<u8"), ("nofChunks", "<u8"),
+                   ("indexOffset", "<u8")])
+CHUNK = np.dtype([("firstEventID", "<i4"), ("lastEventID", "<i4"),
+                  ("nofEvents", "<u4"), ("nofVoxels", "<u4"),
+                  ("payloadOffset", "<u8"), ("payloadSize", "<u8")])
+
+
+class VoxelFile(object):
+    """Shower images of one file."""
+
+    def __init__(self, filename):
+        self.file = io.open(filename, "rb")
+        header = np.frombuffer(self.file.read(HEADER.itemsize), HEADER)
+        if len(header) != 1 or header["magic"][0] != MAGIC or \
+           header["version"][0] != VERSION:
+            raise IOError("%s is not a B4c voxel file" % filename)
+        header = header[0]
+        self.shape = (int(header["nofLayers"]), int(header["nofVoxelsY"]),
+                      int(header["nofVoxelsX"]))
+        self.size_xy = float(header["sizeXY"])
+        self.nof_em_layers = int(header["nofEmLayers"])
+        if header["indexOffset"]:
+            self.file.seek(int(header["indexOffset"]))
+            self.index = np.frombuffer(
+                self.file.read(CHUNK.itemsize*int(header["nofChunks"])), CHUNK)
+        else:
+            self.index = self._scan()
+        self.first_entries = np.concatenate(
+            ([0], np.cumsum(self.index["nofEvents"], dtype=np.int64)))
+        self._chunk = None
+
+    def __len__(self):
+        return int(self.first_entries[-1])
+
+    def _scan(self):
+        # file not closed by the writer: follow the chunk headers
+        chunks = []
+        offset = HEADER.itemsize
+        while True:
+            self.file.seek(offset)
+            data = self.file.read(CHUNK.itemsize)
+            if len(data) < CHUNK.itemsize:
+                break
+            chunk = np.frombuffer(data, CHUNK)[0]
+            if chunk["payloadOffset"] != offset + CHUNK.itemsize:
+                break
+            offset = int(chunk["payloadOffset"] + chunk["payloadSize"])
+            self.file.seek(offset - 1)
+            if not self.file.read(1):
+                break
+            chunks.append(chunk)
+        return np.array(chunks, dtype=CHUNK)
+
+    def _load(self, chunk):
+        if self._chunk is not None and self._chunk[0] == chunk:
+            return self._chunk[1:]
+        info = self.index[chunk]
+        self.file.seek(int(info["payloadOffset"]))
+        payload = zlib.decompress(self.file.read(int(info["payloadSize"])))
+        nof_events = int(info["nofEvents"])
+        nof_voxels = int(info["nofVoxels"])
+        position = 0
+        arrays = []
+        for dtype, count in (("<i4", nof_events), ("<u4", nof_events),
+                             ("<u4", nof_voxels), ("<f4", nof_voxels)):
+            arrays.append(np.frombuffer(payload, dtype, count, position))
+            position += 4*count
+        first_voxels = np.concatenate(
+            ([0], np.cumsum(arrays[1], dtype=np.int64)))
+        self._chunk = (chunk, arrays, first_voxels)
+        return self._chunk[1:]
+
+    def _get(self, chunk, event):
+        arrays, first_voxels = self._load(chunk)
+        begin, end = first_voxels[event], first_voxels[event + 1]
+        return arrays[2][begin:end], arrays[3][begin:end], int(arrays[0][event])
+
+    def entry(self, entry):
+        """Voxels, energies and event number of the entry-th event."""
+        chunk = int(np.searchsorted(self.first_entries, entry, "right")) - 1
+        return self._get(chunk, entry - int(self.first_entries[chunk]))
+
+    def event(self, event_id):
+        """Voxels and energies of an event by its event number."""
+        for chunk, info in enumerate(self.index):
+            if info["firstEventID"] <= event_id <= info["lastEventID"]:
+                event_ids = self._load(chunk)[0][0]
+                event = int(np.searchsorted(event_ids, event_id))
+                if event < len(event_ids) and event_ids[event] == event_id:
+                    return self._get(chunk, event)[:2]
+        raise KeyError(event_id)
+
+    def dense(self, voxels, edeps):
+        """Dense (layers, ny, nx) image of a sparse event."""
+        image = np.zeros(np.prod(self.shape), dtype=np.float32)
+        image[voxels] = edeps
+        return image.reshape(self.shape)
+
+
+def open(filename):
+    return VoxelFile(filename)
@@ -0,0 +1,176 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4Analysis.cc
+/// \brief Implementation of the B4Analysis class
+
+#include "B4Analysis.hh"
+
+#include "G4RootAnalysisManager.hh"
+#include "G4CsvAnalysisManager.hh"
+#include "G4XmlAnalysisManager.hh"
+#include "G4Version.hh"
+#if defined(B4_USE_HDF5) && G4VERSION_NUMBER >= 1040
+#include "G4Hdf5AnalysisManager.hh"
+#define B4_HAS_HDF5 1
+#endif
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal G4VAnalysisManager* B4Analysis::fgManager = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String& B4Analysis::Backend()
+{
+  static G4String backend = "root";
+  return backend;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* B4Analysis::GetCandidates()
+{
+#ifdef B4_HAS_HDF5
+  return "root csv xml hdf5";
+#else
+  return "root csv xml";
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4Analysis::SetBackend(const G4String& name)
+{
+  G4String candidates = G4String(" ") + GetCandidates() + " ";
+  if ( candidates.find(" " + name + " ") == std::string::npos ) {
+    G4ExceptionDescription msg;
+    msg << "Analysis backend " << name << " is not available (" 
+        << GetCandidates() << "), keeping " << Backend();
+    G4Exception("B4Analysis::SetBackend()",
+      "MyCode0011", JustWarning, msg);
+    return false;
+  }
+  if ( fgManager && name != Backend() ) {
+    G4ExceptionDescription msg;
+    msg << "The " << Backend() << " analysis manager is already in use,"
+        << " the backend cannot be changed to " << name;
+    G4Exception("B4Analysis::SetBackend()",
+      "MyCode0011", JustWarning, msg);
+    return false;
+  }
+  Backend() = name;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const G4String& B4Analysis::GetBackend()
+{
+  return Backend();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String B4Analysis::GetFileExtension()
+{
+  return "." + Backend();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4VAnalysisManager* B4Analysis::GetManager()
+{
+  if ( fgManager ) return fgManager;
+
+  const G4String& backend = Backend();
+  if ( backend == "csv" ) {
+    fgManager = G4CsvAnalysisManager::Instance();
+  }
+  else if ( backend == "xml" ) {
+    fgManager = G4XmlAnalysisManager::Instance();
+  }
+#ifdef B4_HAS_HDF5
+  else if ( backend == "hdf5" ) {
+    fgManager = G4Hdf5AnalysisManager::Instance();
+  }
+#endif
+  else {
+    fgManager = G4RootAnalysisManager::Instance();
+  }
+  return fgManager;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4Analysis::DeleteManager()
+{
+  delete fgManager;
+  fgManager = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4Analysis::SetNtupleMerging(G4bool merging)
+{
+#if G4VERSION_NUMBER >= 1030
+  if ( Backend() == "root" ) {
+    static_cast<G4RootAnalysisManager*>(GetManager())
+      ->SetNtupleMerging(merging);
+  }
+#else
+  (void)merging;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4Analysis::SetBasketSize(G4int basketSize)
+{
+#if G4VERSION_NUMBER >= 1030
+  if ( Backend() == "root" && basketSize > 0 ) {
+    static_cast<G4RootAnalysisManager*>(GetManager())
+      ->SetBasketSize(basketSize);
+  }
+#else
+  (void)basketSize;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4Analysis::SetCompressionLevel(G4int level)
+{
+#if G4VERSION_NUMBER >= 1030
+  GetManager()->SetCompressionLevel(level);
+#else
+  (void)level;
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -29,23 +29,73 @@
 /// \brief Implementation of the B4PrimaryGeneratorAction class
 
 #include "B4PrimaryGeneratorAction.hh"
+#include "B4cParticleMix.hh"
+#include "B4cPileUp.hh"
 
 #include "G4RunManager.hh"
 #include "G4LogicalVolumeStore.hh"
 #include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
 #include "G4Box.hh"
 #include "G4Event.hh"
 #include "G4ParticleGun.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
+#include "G4GenericMessenger.hh"
+#include "G4Run.hh"
 #include "G4SystemOfUnits.hh"
 #include "Randomize.hh"
 
+#include <algorithm>
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  // SplitMix64 finaliser, used to decorrelate the per-event seeds
+  unsigned long long MixSeed(unsigned long long x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+  }
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 B4PrimaryGeneratorAction::B4PrimaryGeneratorAction()
  : G4VUserPrimaryGeneratorAction(),
-   fParticleGun(0)
+   fParticleGun(0),
+   fMessenger(0),
+   fBeamMessenger(0),
+   fReplayMessenger(0),
+   fEventSeed(12345),
+   fReseedEvents(false),
+   fFrontFace(false),
+   fRunID(-1),
+   fGunZ(0.),
+   fSpectrum(),
+   fSpectrumShape("mono"),
+   fSpectrumFile("spectrum.txt"),
+   fMinEnergy(1.*GeV),
+   fMaxEnergy(100.*GeV),
+   fEnergySpread(0.01),
+   fSpectralIndex(2.),
+   fSpectrumBins(1000),
+   fSigmaX(0.),
+   fSigmaY(0.),
+   fDivergenceX(0.),
+   fDivergenceY(0.),
+   fReplayFileName(),
+   fReplayFirstEvent(0),
+   fReplayPrefetch(1000),
+   fReplayWrap(false),
+   fReplayWrapped(false),
+   fReplayFile(),
+   fPrefetchBegin(0),
+   fPrefetchEnd(0)
 {
   G4int nofParticles = 1;
   fParticleGun = new G4ParticleGun(nofParticles);
@@ -57,6 +107,10 @@ B4PrimaryGeneratorAction::B4PrimaryGeneratorAction()
   fParticleGun->SetParticleDefinition(particleDefinition);
   fParticleGun->SetParticleMomentumDirection(G4ThreeVector(0.,0.,1.));
   fParticleGun->SetParticleEnergy(500.*MeV);
+
+  // commands
+  //
+  DefineCommands();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -64,8 +118,94 @@ B4PrimaryGeneratorAction::B4PrimaryGeneratorAction()
 B4PrimaryGeneratorAction::~B4PrimaryGeneratorAction()
 {
   delete fParticleGun;
+  delete fMessenger;
+  delete fBeamMessenger;
+  delete fReplayMessenger;
 }
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4PrimaryGeneratorAction::DefineCommands()
+{
+  fMessenger 
+    = new G4GenericMessenger(this, "/B4/gun/", "Primary generator control");
+  fMessenger->DeclareProperty("eventSeed", fEventSeed,
+    "Base seed of the per-event random sequences.");
+  fMessenger->DeclareProperty("reseedEvents", fReseedEvents,
+    "Reseed the engine from (eventSeed, run ID, event ID) at each event;\n"
+    "the engine seeds (/random/setSeeds) are then ignored.");
+  fMessenger->DeclareProperty("frontFace", fFrontFace,
+    "Place the gun at the calorimeter front face instead of the world\n"
+    "upstream face (next run).");
+
+  fBeamMessenger 
+    = new G4GenericMessenger(this, "/B4/beam/", "Beam model control");
+  fBeamMessenger->DeclareProperty("spectrum", fSpectrumShape,
+    "Energy spectrum of the beam, applied at the next run:\n"
+    " mono:     the /gun/energy,\n"
+    " flat:     uniform between minEnergy and maxEnergy,\n"
+    " gauss:    /gun/energy with the relative energySpread,\n"
+    " powerlaw: E^-index between minEnergy and maxEnergy,\n"
+    " table:    histogram read from the file.")
+    .SetCandidates("mono flat gauss powerlaw table");
+  fBeamMessenger->DeclareProperty("file", fSpectrumFile,
+    "Table spectrum file, one bin per line: lowEdge highEdge weight (MeV).");
+  fBeamMessenger->DeclarePropertyWithUnit("minEnergy", "GeV", fMinEnergy,
+    "Lower end of the flat and powerlaw spectra.")
+    .SetRange("minEnergy>0");
+  fBeamMessenger->DeclarePropertyWithUnit("maxEnergy", "GeV", fMaxEnergy,
+    "Upper end of the flat and powerlaw spectra.")
+    .SetRange("maxEnergy>0");
+  fBeamMessenger->DeclareProperty("energySpread", fEnergySpread,
+    "Relative sigma of the gauss spectrum.")
+    .SetRange("energySpread>0");
+  fBeamMessenger->DeclareProperty("index", fSpectralIndex,
+    "Spectral index of the powerlaw spectrum.");
+  fBeamMessenger->DeclareProperty("bins", fSpectrumBins,
+    "Bins of the alias table of the analytic spectra.")
+    .SetRange("bins>0");
+  fBeamMessenger->DeclarePropertyWithUnit("sigmaX", "mm", fSigmaX,
+    "Sigma of the Gaussian beam spot in x.")
+    .SetRange("sigmaX>=0");
+  fBeamMessenger->DeclarePropertyWithUnit("sigmaY", "mm", fSigmaY,
+    "Sigma of the Gaussian beam spot in y.")
+    .SetRange("sigmaY>=0");
+  fBeamMessenger->DeclarePropertyWithUnit("divergenceX", "mrad", fDivergenceX,
+    "Sigma of the Gaussian beam divergence in x.")
+    .SetRange("divergenceX>=0");
+  fBeamMessenger->DeclarePropertyWithUnit("divergenceY", "mrad", fDivergenceY,
+    "Sigma of the Gaussian beam divergence in y.")
+    .SetRange("divergenceY>=0");
+
+  fReplayMessenger 
+    = new G4GenericMessenger(this, "/B4/replay/", "Primary event replay");
+  fReplayMessenger->DeclareProperty("file", fReplayFileName,
+    "Replay the primaries of this file (binary or HEPEVT) from the next\n"
+    "run.");
+  fReplayMessenger->DeclareMethod("off", 
+    &B4PrimaryGeneratorAction::StopReplay,
+    "Return to the particle gun from the next run.");
+  fReplayMessenger->DeclareProperty("firstEvent", fReplayFirstEvent,
+    "File event replayed by the first event of a run.")
+    .SetRange("firstEvent>=0");
+  fReplayMessenger->DeclareProperty("prefetch", fReplayPrefetch,
+    "Number of events of a binary file read ahead.")
+    .SetRange("prefetch>=0");
+  fReplayMessenger->DeclareProperty("wrap", fReplayWrap,
+    "Replay the file again from its first event once it is exhausted;\n"
+    "otherwise (default) the run is stopped at the end of the file.");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4PrimaryGeneratorAction::StopReplay()
+{
+  // the file is closed at the beginning of the next run
+  fReplayFileName = "";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 G4ParticleGun* B4PrimaryGeneratorAction::getGun()
 {
 	return fParticleGun;
@@ -73,21 +213,174 @@ G4ParticleGun* B4PrimaryGeneratorAction::getGun()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+G4double B4PrimaryGeneratorAction::GetNominalEnergy() const
+{
+  return fParticleGun->GetParticleEnergy();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void B4PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
   // This function is called at the begining of event
 
+  if ( fReseedEvents ) ReseedEvent(anEvent);
+
+  // The world and the beam spectrum are looked up at the first event
+  // of each run
+  G4int runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  if ( runID != fRunID ) {
+    fRunID = runID;
+    BeginOfRun();
+  }
+
+  // The signal primaries replayed from a file (/B4/replay/), or the 
+  // signal primary, with the species of a mixed run (/B4/mix/) tagged 
+  // for the event action
+  B4cParticleMix* mix = B4cParticleMix::GetInstance();
+  G4int species = -1;
+  if ( fReplayFile.IsOpen() ) {
+    ReplayPrimaries(anEvent);
+    // the file is exhausted
+    if ( anEvent->IsAborted() ) return;
+  }
+  else {
+    if ( mix && B4cParticleMix::IsEnabled() ) species = mix->SampleSpecies();
+    ShootPrimary(anEvent, species, 0.);
+  }
+
+  // The pile-up overlays (/B4/pileup/), one vertex each
+  B4cPileUp* pileUp = B4cPileUp::GetInstance();
+  if ( pileUp && B4cPileUp::IsEnabled() ) {
+    G4int nofOverlays = pileUp->SampleNofOverlays();
+    for ( G4int i=0; i<nofOverlays; ++i ) {
+      if ( species >= 0 ) species = mix->DrawSpecies();
+      ShootPrimary(anEvent, species, pileUp->SampleTimeOffset());
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4PrimaryGeneratorAction::ShootPrimary(G4Event* event, G4int species,
+                                            G4double time)
+{
+  // The gun settings of the /gun/ commands
+  G4ParticleDefinition* particle = fParticleGun->GetParticleDefinition();
+  G4double energy = fParticleGun->GetParticleEnergy();
+  G4ThreeVector direction = fParticleGun->GetParticleMomentumDirection();
+
+  // The species drawn in a mixed run
+  if ( species >= 0 ) {
+    const B4cParticleMix::Species& mixSpecies 
+      = B4cParticleMix::GetSpecies(species);
+    fParticleGun->SetParticleDefinition(mixSpecies.particle);
+    fParticleGun->SetParticleEnergy(mixSpecies.energy);
+  }
+  // or sample the beam spectrum
+  else if ( ! fSpectrum.IsEmpty() ) {
+    fParticleGun->SetParticleEnergy(fSpectrum.Sample());
+  }
+
+  // Sample the beam spot and divergence
+  G4double x = ( fSigmaX > 0. ) ? G4RandGauss::shoot(0., fSigmaX) : 0.;
+  G4double y = ( fSigmaY > 0. ) ? G4RandGauss::shoot(0., fSigmaY) : 0.;
+  fParticleGun->SetParticlePosition(G4ThreeVector(x, y, fGunZ));
+
+  if ( fDivergenceX > 0. || fDivergenceY > 0. ) {
+    G4double thetaX 
+      = ( fDivergenceX > 0. ) ? G4RandGauss::shoot(0., fDivergenceX) : 0.;
+    G4double thetaY 
+      = ( fDivergenceY > 0. ) ? G4RandGauss::shoot(0., fDivergenceY) : 0.;
+    G4ThreeVector smeared 
+      = G4ThreeVector(std::tan(thetaX), std::tan(thetaY), 1.).unit();
+    fParticleGun->SetParticleMomentumDirection(smeared.rotateUz(direction));
+  }
+
+  fParticleGun->SetParticleTime(time);
+  fParticleGun->GeneratePrimaryVertex(event);
+
+  fParticleGun->SetParticleDefinition(particle);
+  fParticleGun->SetParticleEnergy(energy);
+  fParticleGun->SetParticleMomentumDirection(direction);
+  fParticleGun->SetParticleTime(0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4PrimaryGeneratorAction::ReplayPrimaries(G4Event* event)
+{
+  G4int nofEvents = fReplayFile.GetNofEvents();
+  G4long fileEvent = G4long(fReplayFirstEvent) + event->GetEventID();
+
+  // Once the file is exhausted, its events are replayed again only on 
+  // request: the duplicated events are not independent
+  if ( fileEvent >= nofEvents ) {
+    if ( ! fReplayWrapped ) {
+      fReplayWrapped = true;
+      G4ExceptionDescription msg;
+      msg << "The " << nofEvents << " events of " << fReplayFileName 
+          << " are exhausted at event " << event->GetEventID() 
+          << " (first file event " << fReplayFirstEvent << ")." << G4endl;
+      if ( fReplayWrap ) {
+        msg << "They are replayed again from the first one.";
+      }
+      else {
+        msg << "The run is stopped; /B4/replay/wrap true replays them again.";
+      }
+      G4Exception("B4PrimaryGeneratorAction::ReplayPrimaries()",
+        "MyCode0031", JustWarning, msg);
+    }
+    if ( ! fReplayWrap ) {
+      // this event has no primaries and is not accounted
+      event->SetEventAborted();
+      G4RunManager::GetRunManager()->AbortRun(true);
+      return;
+    }
+  }
+  G4int index = fileEvent % nofEvents;
+
+  // Read the next events ahead when half of the window is consumed
+  if ( index < fPrefetchBegin || 2*index >= fPrefetchBegin + fPrefetchEnd ) {
+    fReplayFile.Prefetch(index, fReplayPrefetch);
+    fPrefetchBegin = index;
+    fPrefetchEnd = index + fReplayPrefetch;
+  }
+
+  // The consecutive particles at the same point share a vertex
+  const B4cPrimaryRecord* particles = fReplayFile.GetParticles(index);
+  G4PrimaryVertex* vertex = 0;
+  for ( G4int i=0; i<fReplayFile.GetNofParticles(index); ++i ) {
+    const B4cPrimaryRecord& particle = particles[i];
+    if ( ! vertex || 
+         particle.x != particles[i-1].x || particle.y != particles[i-1].y ||
+         particle.z != particles[i-1].z || particle.t != particles[i-1].t ) {
+      G4ThreeVector position(particle.x*mm, particle.y*mm, 
+                             particle.z*mm + fGunZ);
+      vertex = new G4PrimaryVertex(position, particle.t*ns);
+      event->AddPrimaryVertex(vertex);
+    }
+    vertex->SetPrimary(
+      new G4PrimaryParticle(particle.pdg, particle.px*MeV, particle.py*MeV,
+                            particle.pz*MeV));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4PrimaryGeneratorAction::BeginOfRun()
+{
   // In order to avoid dependence of PrimaryGeneratorAction
   // on DetectorConstruction class we get world volume
-  // from G4LogicalVolumeStore
+  // from G4LogicalVolumeStore; the geometry may only change between runs
   //
-  G4double worldZHalfLength = 0;
+  fGunZ = 0;
   G4LogicalVolume* worlLV
     = G4LogicalVolumeStore::GetInstance()->GetVolume("World");
   G4Box* worldBox = 0;
   if ( worlLV) worldBox = dynamic_cast< G4Box*>(worlLV->GetSolid()); 
   if ( worldBox ) {
-    worldZHalfLength = worldBox->GetZHalfLength();  
+    fGunZ = - worldBox->GetZHalfLength();  
   }
   else  {
     G4ExceptionDescription msg;
@@ -97,13 +390,85 @@ void B4PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
     G4Exception("B4PrimaryGeneratorAction::GeneratePrimaries()",
       "MyCode0002", JustWarning, msg);
   } 
-  
-  // Set gun position
-  fParticleGun
-    ->SetParticlePosition(G4ThreeVector(0., 0., -worldZHalfLength));
 
-  fParticleGun->GeneratePrimaryVertex(anEvent);
+  // The front face of the calorimeter: the most upstream face of the
+  // daughters of the world
+  //
+  if ( worldBox && fFrontFace ) {
+    G4double frontZ = - fGunZ;
+    for ( G4int i=0; i<G4int(worlLV->GetNoDaughters()); ++i ) {
+      G4VPhysicalVolume* daughter = worlLV->GetDaughter(i);
+      G4Box* box 
+        = dynamic_cast<G4Box*>(daughter->GetLogicalVolume()->GetSolid());
+      if ( ! box ) continue;
+      frontZ = std::min(frontZ, 
+                        daughter->GetTranslation().z() - box->GetZHalfLength());
+    }
+    if ( frontZ < - fGunZ ) fGunZ = frontZ;
+  }
+
+  // Open the file to replay
+  //
+  fReplayWrapped = false;
+  if ( fReplayFileName != fReplayFile.GetFileName() ) {
+    fReplayFile.Close();
+    fPrefetchBegin = fPrefetchEnd = 0;
+    if ( fReplayFileName.size() && ! fReplayFile.Open(fReplayFileName) ) {
+      G4ExceptionDescription msg;
+      msg << "Cannot read the primary events of " << fReplayFileName 
+          << "." << G4endl;
+      msg << "The particle gun is used.";
+      G4Exception("B4PrimaryGeneratorAction::BeginOfRun()",
+        "MyCode0017", JustWarning, msg);
+    }
+  }
+
+  // Build the alias table of the beam spectrum
+  //
+  G4bool ok = true;
+  if      ( fSpectrumShape == "mono" ) fSpectrum.Clear();
+  else if ( fSpectrumShape == "flat" ) {
+    ok = fSpectrum.SetFlat(fMinEnergy, fMaxEnergy, fSpectrumBins);
+  }
+  else if ( fSpectrumShape == "gauss" ) {
+    ok = fSpectrum.SetGauss(fParticleGun->GetParticleEnergy(), fEnergySpread, 
+                            fSpectrumBins);
+  }
+  else if ( fSpectrumShape == "powerlaw" ) {
+    ok = fSpectrum.SetPowerLaw(fMinEnergy, fMaxEnergy, fSpectralIndex, 
+                               fSpectrumBins);
+  }
+  else if ( fSpectrumShape == "table" ) {
+    ok = fSpectrum.ReadTable(fSpectrumFile);
+  }
+  if ( ! ok ) {
+    G4ExceptionDescription msg;
+    msg << "Invalid " << fSpectrumShape << " beam spectrum";
+    if ( fSpectrumShape == "table" ) msg << " in " << fSpectrumFile;
+    msg << "." << G4endl;
+    msg << "The beam of this run is mono-energetic.";
+    G4Exception("B4PrimaryGeneratorAction::BeginOfRun()",
+      "MyCode0015", JustWarning, msg);
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void B4PrimaryGeneratorAction::ReseedEvent(const G4Event* event)
+{
+  // The seeds depend only on the base seed, the run and the event number,
+  // not on the state left in the engine by the previous event of this thread
+  G4int runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  unsigned long long key = MixSeed((unsigned int)fEventSeed);
+  key = MixSeed(key ^ (unsigned int)runID);
+  key = MixSeed(key ^ (unsigned int)event->GetEventID());
+
+  // both seeds must lie in [1, 2147483398] for the Ranecu engine
+  long seeds[3];
+  seeds[0] = (long)((key & 0xFFFFFFFFULL) % 2147483398ULL) + 1;
+  seeds[1] = (long)((key >> 32) % 2147483398ULL) + 1;
+  seeds[2] = 0;
+  G4Random::setTheSeeds(seeds);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
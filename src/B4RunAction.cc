@@ -31,31 +31,335 @@
 #include "B4cDetectorConstruction.hh"
 #include "B4PrimaryGeneratorAction.hh"
 #include "B4RunAction.hh"
+#include "B4cRun.hh"
+#include "B4cCalorimeterSD.hh"
+#include "B4cSteppingAction.hh"
+#include "B4cShowerLibraryRecorder.hh"
+#include "B4cParameterisedShowerModel.hh"
+#include "B4cFastSimulationPhysics.hh"
+#include "B4cNtupleSchema.hh"
+#include "B4cAsyncWriter.hh"
+#include "B4cRecordFile.hh"
+#include "B4cVoxelFile.hh"
+#include "B4cResponseSummary.hh"
+#include "B4cAdaptiveRun.hh"
+#include "B4cParticleMix.hh"
+#include "B4cPileUp.hh"
 #include "B4Analysis.hh"
 
 #include "G4Run.hh"
+#include "G4LogicalVolume.hh"
 #include "G4RunManager.hh"
 #include "G4UnitsTable.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4ParticleGun.hh"
+#include "G4Version.hh"
+#include "G4Threading.hh"
+#include "G4GenericMessenger.hh"
+
+#include <algorithm>
+#include <iomanip>
+#include <cmath>
+
+#include <cctype>
+#include <dirent.h>
+#include <sys/stat.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  // Whether name is an output file of the base name with the extension:
+  // the base file, its thread files (_t<n>) and, for csv, its histogram
+  // and ntuple files (_h1_, _h2_, _nt_); "result_10" is not a file of
+  // "result_1"
+  G4bool IsOutputFile(const std::string& name, const std::string& base,
+                      const std::string& extension)
+  {
+    if ( name.size() < base.size() + extension.size() ||
+         name.compare(0, base.size(), base) != 0 ||
+         name.compare(name.size() - extension.size(), extension.size(),
+                      extension) != 0 ) return false;
+
+    std::string suffix 
+      = name.substr(base.size(), 
+                    name.size() - base.size() - extension.size());
+    if ( suffix.empty() ) return true;
+    if ( suffix.compare(0, 4, "_h1_") == 0 ||
+         suffix.compare(0, 4, "_h2_") == 0 ||
+         suffix.compare(0, 4, "_nt_") == 0 ) return true;
+    if ( suffix.size() < 3 || suffix.compare(0, 2, "_t") != 0 ) return false;
+    for ( size_t i=2; i<suffix.size(); ++i ) {
+      if ( ! std::isdigit(static_cast<unsigned char>(suffix[i])) ) return false;
+    }
+    return true;
+  }
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 B4RunAction::B4RunAction()
- : G4UserRunAction()
+ : G4UserRunAction(),
+   fNtupleSchema(new B4cNtupleSchema),
+   fNtupleMessenger(0),
+   fWriter(new B4cAsyncWriter),
+   fOutputMessenger(0),
+   fRecordFile(new B4cRecordFile),
+   fRecordMessenger(0),
+   fVoxelFile(new B4cVoxelFile),
+   fVoxelMessenger(0),
+   fResponseSummary(new B4cResponseSummary),
+   fSummaryMessenger(0),
+   fAdaptiveRun(new B4cAdaptiveRun),
+   fAdaptiveMessenger(0),
+   fParticleMix(new B4cParticleMix),
+   fMixMessenger(0),
+   fPileUp(new B4cPileUp),
+   fPileUpMessenger(0),
+   fAnalysisMessenger(0),
+   fNavMessenger(0),
+   fTimer()
 { 
+  fSecondsPerEvent[0] = fSecondsPerEvent[1] = 0.;
+
+  // Schema of the result ntuple, shared by all threads
+  if ( G4Threading::IsMasterThread() ) {
+    B4cNtupleSchema::Options& options = B4cNtupleSchema::GetOptions();
+    fNtupleMessenger = new G4GenericMessenger(&options, "/B4/ntuple/",
+      "Result ntuple schema control (before the first run)");
+    fNtupleMessenger->DeclareProperty("layers", options.layers,
+      "Save the per-layer energy deposits (vector columns).")
+      .SetToBeBroadcasted(false);
+    fNtupleMessenger->DeclareProperty("totals", options.totals,
+      "Save the energy deposit per sub-detector.")
+      .SetToBeBroadcasted(false);
+    fNtupleMessenger->DeclareProperty("trackLengths", options.trackLengths,
+      "Save the charged track length per sub-detector.")
+      .SetToBeBroadcasted(false);
+    fNtupleMessenger->DeclareProperty("primary", options.primary,
+      "Save the kinematics of the primary particle.")
+      .SetToBeBroadcasted(false);
+    fNtupleMessenger->DeclareProperty("basketSize", options.basketSize,
+      "Basket size of the ntuple branches in bytes (0 = default).")
+      .SetToBeBroadcasted(false);
+    fNtupleMessenger->DeclareProperty("compression", options.compression,
+      "Compression level of the output file.")
+      .SetParameterName("level", false)
+      .SetRange("level>=0 && level<=9")
+      .SetToBeBroadcasted(false);
+
+    B4cAsyncWriter::Options& outputOptions = B4cAsyncWriter::GetOptions();
+    fOutputMessenger = new G4GenericMessenger(&outputOptions, "/B4/output/",
+      "Asynchronous event output control");
+    fOutputMessenger->DeclareProperty("async", outputOptions.enable,
+      "Pass the event records to a writer thread instead of filling the\n"
+      "histograms and result ntuple in the event action.")
+      .SetToBeBroadcasted(false);
+    fOutputMessenger->DeclareProperty("queueSize", outputOptions.queueSize,
+      "Number of event records in the ring buffer of each writer.")
+      .SetParameterName("queueSize", false)
+      .SetRange("queueSize>0")
+      .SetToBeBroadcasted(false);
+    fOutputMessenger->DeclareProperty("file", outputOptions.fileName,
+      "Base name of the event record files.")
+      .SetToBeBroadcasted(false);
+
+    B4cRecordFile::Options& recordOptions = B4cRecordFile::GetOptions();
+    fRecordMessenger = new G4GenericMessenger(&recordOptions, "/B4/records/",
+      "Fixed-record event file control");
+    fRecordMessenger->DeclareProperty("enable", recordOptions.enable,
+      "Write the layer energies, totals and primary particle of each event\n"
+      "in a memory-mappable file of fixed-size records.")
+      .SetToBeBroadcasted(false);
+    fRecordMessenger->DeclareProperty("chunkSize", recordOptions.chunkSize,
+      "Number of records appended to the file at once.")
+      .SetParameterName("chunkSize", false)
+      .SetRange("chunkSize>0")
+      .SetToBeBroadcasted(false);
+    fRecordMessenger->DeclareProperty("file", recordOptions.fileName,
+      "Base name of the record files.")
+      .SetToBeBroadcasted(false);
+
+    B4cVoxelFile::Options& voxelOptions = B4cVoxelFile::GetOptions();
+    fVoxelMessenger = new G4GenericMessenger(&voxelOptions, "/B4/voxels/",
+      "Voxelised shower image output control");
+    fVoxelMessenger->DeclareProperty("enable", voxelOptions.enable,
+      "Write the sparse shower image of each event on the voxel grid\n"
+      "of /B4/sd/voxelsX and voxelsY.")
+      .SetToBeBroadcasted(false);
+    fVoxelMessenger->DeclareProperty("chunkSize", voxelOptions.chunkSize,
+      "Maximum number of events per compressed chunk.")
+      .SetParameterName("chunkSize", false)
+      .SetRange("chunkSize>0")
+      .SetToBeBroadcasted(false);
+    fVoxelMessenger->DeclareProperty("maxVoxels", voxelOptions.maxVoxels,
+      "Number of voxels which closes a chunk (memory bound).")
+      .SetParameterName("maxVoxels", false)
+      .SetRange("maxVoxels>0")
+      .SetToBeBroadcasted(false);
+    fVoxelMessenger->DeclareProperty("compression", voxelOptions.compression,
+      "zlib compression level of the chunks.")
+      .SetParameterName("level", false)
+      .SetRange("level>=0 && level<=9")
+      .SetToBeBroadcasted(false);
+    fVoxelMessenger->DeclareProperty("file", voxelOptions.fileName,
+      "Base name of the shower image files.")
+      .SetToBeBroadcasted(false);
+
+    B4cResponseSummary::Options& summaryOptions 
+      = B4cResponseSummary::GetOptions();
+    fSummaryMessenger = new G4GenericMessenger(&summaryOptions, 
+      "/B4/summary/", "Response summary control");
+    fSummaryMessenger->DeclareProperty("json", summaryOptions.json,
+      "Write the response summary of each run in a JSON file (off by\n"
+      "default).")
+      .SetToBeBroadcasted(false);
+    fSummaryMessenger->DeclareProperty("file", summaryOptions.fileName,
+      "Base name of the JSON files.")
+      .SetToBeBroadcasted(false);
+
+    B4cAdaptiveRun::Options& adaptiveOptions = B4cAdaptiveRun::GetOptions();
+    fAdaptiveMessenger = new G4GenericMessenger(&adaptiveOptions, 
+      "/B4/adaptive/", "Adaptive run length control");
+    fAdaptiveMessenger->DeclareProperty("precision", adaptiveOptions.precision,
+      "Stop the run when the relative error of the selected quantity\n"
+      "is below this value for every primary species;\n"
+      "the number of events of /run/beamOn is the maximum; 0 = off.")
+      .SetParameterName("precision", false)
+      .SetRange("precision>=0")
+      .SetToBeBroadcasted(false);
+    fAdaptiveMessenger->DeclareProperty("quantity", adaptiveOptions.quantity,
+      "Quantity of the visible energy whose precision is checked.")
+      .SetCandidates("mean resolution")
+      .SetToBeBroadcasted(false);
+    fAdaptiveMessenger->DeclareProperty("interval", adaptiveOptions.interval,
+      "Events of a thread between two checks of the precision.")
+      .SetParameterName("events", false)
+      .SetRange("events>0")
+      .SetToBeBroadcasted(false);
+    fAdaptiveMessenger->DeclareProperty("minEvents", adaptiveOptions.minEvents,
+      "Events of each primary species needed before the run can stop.")
+      .SetParameterName("events", false)
+      .SetRange("events>=2")
+      .SetToBeBroadcasted(false);
+
+    fMixMessenger = new G4GenericMessenger(fParticleMix, "/B4/mix/",
+      "Mixed-species runs");
+    fMixMessenger->DeclareMethod("add", &B4cParticleMix::AddSpecies,
+      "Add a species to the mixture: <particle> <energy> <unit> [weight];\n"
+      "the species of each event is drawn according to the weights.\n"
+      "The histograms of the species are booked at the first run.")
+      .SetToBeBroadcasted(false);
+    fMixMessenger->DeclareMethod("clear", &B4cParticleMix::ClearSpecies,
+      "Remove all species: the /gun/ particle and energy are used again.")
+      .SetToBeBroadcasted(false);
+
+    B4cPileUp::Options& pileUpOptions = B4cPileUp::GetOptions();
+    fPileUpMessenger = new G4GenericMessenger(&pileUpOptions, "/B4/pileup/",
+      "Pile-up control");
+    fPileUpMessenger->DeclareProperty("mean", pileUpOptions.mean,
+      "Mean number of overlay primaries per event (Poisson), 0 = off;\n"
+      "the pile-up ntuple columns are booked at the first run.")
+      .SetParameterName("mean", false)
+      .SetRange("mean>=0")
+      .SetToBeBroadcasted(false);
+    fPileUpMessenger->DeclarePropertyWithUnit("timeWindow", "ns", 
+      pileUpOptions.timeWindow,
+      "Time offsets of the overlays are uniform in [0, timeWindow].")
+      .SetParameterName("timeWindow", false)
+      .SetRange("timeWindow>=0")
+      .SetToBeBroadcasted(false);
+
+    fAnalysisMessenger = new G4GenericMessenger(this, "/B4/analysis/",
+      "Analysis backend control");
+    fAnalysisMessenger->DeclareMethod("backend", 
+      &B4RunAction::SetAnalysisBackend,
+      "Select the analysis backend before the first run;\n"
+      "the /analysis/ settings made before are lost.")
+      .SetCandidates(B4Analysis::GetCandidates())
+      .SetToBeBroadcasted(false);
+
+    B4cSteppingAction::Options& navOptions = B4cSteppingAction::GetOptions();
+    fNavMessenger = new G4GenericMessenger(&navOptions, "/B4/nav/",
+      "Navigation benchmark");
+    fNavMessenger->DeclareProperty("timing", navOptions.timing,
+      "Count and time the steps in each logical volume; the master\n"
+      "prints them at the end of run.")
+      .SetToBeBroadcasted(false);
+  }
+
   // set printing event number per each event
   G4RunManager::GetRunManager()->SetPrintProgress(1);     
 
-  // Create analysis manager
-  // The choice of analysis technology is done via selectin of a namespace
-  // in B4Analysis.hh
-  G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+  // Create analysis manager of the selected backend, so that the 
+  // /analysis/ commands are available; the histograms and ntuples are
+  // booked at the first run; the default file name can be changed 
+  // with /analysis/setFileName
+  B4Analysis::GetManager()->SetFileName("result");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4RunAction::~B4RunAction()
+{
+  delete fNtupleMessenger;
+  delete fNtupleSchema;
+  delete fOutputMessenger;
+  delete fAnalysisMessenger;
+  delete fNavMessenger;
+  delete fWriter;
+  delete fRecordMessenger;
+  delete fRecordFile;
+  delete fVoxelMessenger;
+  delete fVoxelFile;
+  delete fSummaryMessenger;
+  delete fResponseSummary;
+  delete fAdaptiveMessenger;
+  delete fAdaptiveRun;
+  delete fMixMessenger;
+  delete fParticleMix;
+  delete fPileUpMessenger;
+  delete fPileUp;
+  B4Analysis::DeleteManager();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunAction::SetAnalysisBackend(const G4String& backend)
+{
+  if ( backend == B4Analysis::GetBackend() ) return;
+
+  if ( fNtupleSchema->IsBooked() ) {
+    G4ExceptionDescription msg;
+    msg << "The analysis backend is selected before the first run,"
+        << " keeping " << B4Analysis::GetBackend();
+    G4Exception("B4RunAction::SetAnalysisBackend()",
+      "MyCode0011", JustWarning, msg);
+    return;
+  }
+
+  // Nothing is booked yet, the manager of the previous backend is replaced
+  G4String fileName = B4Analysis::GetManager()->GetFileName();
+  B4Analysis::DeleteManager();
+  B4Analysis::SetBackend(backend);
+  B4Analysis::GetManager()->SetFileName(fileName);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunAction::Book()
+{
+  // The histograms and ntuples are booked once, with the backend and 
+  // schema selected before the first run
+  if ( fNtupleSchema->IsBooked() ) return;
+
+  G4VAnalysisManager* analysisManager = B4Analysis::GetManager();
   G4cout << "Using " << analysisManager->GetType() << G4endl;
 
   // Create directories 
   analysisManager->SetVerboseLevel(1);
   analysisManager->SetFirstHistoId(1);
+  // Write the worker ntuple rows into the master file (root)
+  B4Analysis::SetNtupleMerging(true);
 
   //Obtain geometry
    B4cDetectorConstruction* construct = (B4cDetectorConstruction*) G4RunManager::GetRunManager()->GetUserDetectorConstruction();
@@ -66,52 +370,392 @@ B4RunAction::B4RunAction()
 	0., construct->GetCalorimeterSizeXY()/2., "mm", "Radius from center");
   analysisManager->CreateH1("em_layers","EM deposited energy per layer / MeV", construct->GetNumberOfLayers(), 
 	1, construct->GetNumberOfLayers()+1, "layer");
+  analysisManager->CreateH2("em_trans_layers",
+    "EM deposited energy per layer and radius / MeV",
+    construct->GetNumberOfLayers(), 1, construct->GetNumberOfLayers()+1,
+    100, 0., construct->GetCalorimeterSizeXY()/2., "none", "mm");
 
-  // Creating ntuple
+  // Total and visible energy of each species of a mixed run
   //
-  analysisManager->CreateNtuple("result", "Total Deposited Energy / MeV");
+  for ( G4int i=0; i<B4cParticleMix::GetNofSpecies(); ++i ) {
+    const B4cParticleMix::Species& species = B4cParticleMix::GetSpecies(i);
+    G4String label = B4cParticleMix::GetLabel(i);
+    G4int id = analysisManager->CreateH1(label + "_total",
+      label + ": deposited energy / MeV", 110, 0., 1.1*species.energy, "MeV");
+    analysisManager->CreateH1(label + "_visible",
+      label + ": gap energy / MeV", 100, 0., species.energy, "MeV");
+    if ( i == 0 ) {
+      fParticleMix->SetHistoIds(id, B4cParticleMix::GetNofSpecies());
+    }
+  }
 
-  analysisManager->CreateNtupleDColumn("em_total");
+  // Result ntuple, one row per event
+  //
+  fNtupleSchema->Book(0);
 
+  // Fired readout cells, one row per cell (detector: 0 = EM gap, 1 = HCAL)
+  //
+  analysisManager->CreateNtuple("cells", "Fired readout cells / MeV");
+  analysisManager->CreateNtupleIColumn("event");
+  analysisManager->CreateNtupleIColumn("detector");
+  analysisManager->CreateNtupleIColumn("layer");
+  analysisManager->CreateNtupleIColumn("ix");
+  analysisManager->CreateNtupleIColumn("iy");
+  analysisManager->CreateNtupleDColumn("edep");
   analysisManager->FinishNtuple();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-B4RunAction::~B4RunAction()
+G4Run* B4RunAction::GenerateRun()
 {
-  delete G4AnalysisManager::Instance();  
+  const B4cDetectorConstruction* construct
+    = static_cast<const B4cDetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+
+  return new B4cRun(construct->GetNumberOfLayers());
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void B4RunAction::BeginOfRunAction(const G4Run* /*run*/)
+void B4RunAction::BeginOfRunAction(const G4Run* run)
 { 
   //inform the runManager to save random number seed
   //G4RunManager::GetRunManager()->SetRandomNumberStore(true);
   
   // Get analysis manager
-  G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+  G4VAnalysisManager* analysisManager = B4Analysis::GetManager();
 
-  // Open an output file
+  // Adapt the binning to the current geometry, which may have been rebuilt
+  // with other parameters since the histograms were booked
   //
-  G4String fileName = "result";
-  analysisManager->OpenFile(fileName);
+  const B4cDetectorConstruction* construct
+    = static_cast<const B4cDetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  // The radial bins match the ones of the sensitive detectors
+  G4int nofRadialBins = std::max(B4cCalorimeterSD::GetOptions().radialBins, 1);
+  G4double radialRange = construct->GetCalorimeterSizeXY()/2.;
+  analysisManager->SetH1(1, nofRadialBins, 0., radialRange, "mm");
+  G4int nofLayers = std::max(construct->GetNumberOfLayers(), 1);
+  analysisManager->SetH1(2, nofLayers, 1, nofLayers+1);
+  analysisManager->SetH2(1, nofLayers, 1, nofLayers+1,
+                            nofRadialBins, 0., radialRange, "none", "mm");
+
+  // The fast simulation process is active only in the runs with a fast
+  // simulation model
+  //
+  B4cFastSimulationPhysics::UpdateActivation();
+
+  // The master begins the run before the workers: start the adaptive
+  // run length (/B4/adaptive/) of all threads
+  //
+  if ( IsMaster() ) B4cAdaptiveRun::Reset();
+  fAdaptiveRun->BeginOfRun();
+
+  // Book the ntuples and open an output file
+  //
+  Book();
+  analysisManager->OpenFile();
+
+  // Start the writer of the event records in the event threads
+  //
+  G4bool eventThread 
+    = ! IsMaster() || 
+      G4RunManager::GetRunManager()->GetRunManagerType() 
+        == G4RunManager::sequentialRM;
+  if ( B4cAsyncWriter::GetOptions().enable && eventThread ) {
+    // the layer vectors of the schema span the layers of their section
+    const B4cCalorimeterStack& stack = construct->GetStack();
+    G4int vectorCapacity[B4cNtupleSchema::kNofVectors] = {
+      stack.GetNofLayers(B4cCalorimeterStack::kEm),
+      stack.GetNofLayers(B4cCalorimeterStack::kEm),
+      stack.GetNofLayers(B4cCalorimeterStack::kFe),
+      stack.GetNofLayers(B4cCalorimeterStack::kW) };
+    fWriter->Start(construct->GetNumberOfLayers(), nofRadialBins, 
+                   radialRange/nofRadialBins, vectorCapacity);
+  }
+  if ( B4cRecordFile::GetOptions().enable && eventThread ) {
+    // the EM layers of the plates read out in at least one EM module
+    const B4cCalorimeterStack& stack = construct->GetStack();
+    G4int nofEmLayers = construct->GetNumberOfLayers();
+    fRecordFile->Open(run->GetRunID(),
+      stack.GetNofReadoutLayers(B4cCalorimeterStack::kEm, false) > 0 
+        ? nofEmLayers : 0,
+      stack.GetNofReadoutLayers(B4cCalorimeterStack::kEm, true) > 0 
+        ? nofEmLayers : 0,
+      construct->GetNumberOfFeLayers(), construct->GetNumberOfWLayers());
+  }
+  if ( B4cVoxelFile::GetOptions().enable && eventThread ) {
+    const B4cCalorimeterSD::Options& sdOptions = B4cCalorimeterSD::GetOptions();
+    fVoxelFile->Open(run->GetRunID(), sdOptions.voxelsX, sdOptions.voxelsY,
+      construct->GetNumberOfLayers(), 
+      construct->GetStack().GetNofLayers(),
+      construct->GetCalorimeterSizeXY());
+  }
+
+  fTimer.Start();
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void B4RunAction::EndOfRunAction(const G4Run* /*run*/)
+void B4RunAction::EndOfRunAction(const G4Run* run)
 {
-  // print histogram statistics
+  // print run statistics (merged over all workers on the master)
+  //
+  const B4cRun* b4Run = static_cast<const B4cRun*>(run);
+  G4int nofEvents = b4Run->GetNumberOfEvent();
+  if ( nofEvents > 0 ) {
+    G4cout
+      << G4endl
+      << "--------------------End of " << ( IsMaster() ? "Global" : "Local" )
+      << " Run------------------------" << G4endl
+      << " The run consists of " << nofEvents << " events" << G4endl
+      << " Absorber : mean = "
+      << G4BestUnit(b4Run->GetMean(B4cRun::kAbso), "Energy")
+      << " rms = " << G4BestUnit(b4Run->GetRms(B4cRun::kAbso), "Energy")
+      << G4endl
+      << " Gap      : mean = "
+      << G4BestUnit(b4Run->GetMean(B4cRun::kGap), "Energy")
+      << " rms = " << G4BestUnit(b4Run->GetRms(B4cRun::kGap), "Energy")
+      << G4endl
+      << " HCAL     : mean = "
+      << G4BestUnit(b4Run->GetMean(B4cRun::kHcal), "Energy")
+      << " rms = " << G4BestUnit(b4Run->GetRms(B4cRun::kHcal), "Energy")
+      << G4endl
+      << " Total    : mean = "
+      << G4BestUnit(b4Run->GetMean(B4cRun::kTotal), "Energy")
+      << " rms = " << G4BestUnit(b4Run->GetRms(B4cRun::kTotal), "Energy")
+      << G4endl
+      << "------------------------------------------------------------"
+      << G4endl;
+  }
+
+  // print the cost per step in the sensitive detectors (/B4/sd/timing)
+  //
+  if ( b4Run->GetNofTimedSDSteps() > 0. ) {
+    G4cout
+      << " Sensitive detectors ("
+      << ( B4cCalorimeterSD::GetOptions().flat ? "flat buffers" : "hits" )
+      << "): " << b4Run->GetNofTimedSDSteps() << " steps, "
+      << 1.e9*b4Run->GetTimedSDSeconds()/b4Run->GetNofTimedSDSteps()
+      << " ns per step" << G4endl;
+  }
+
+  // print the number of steps per region (/B4/region/)
+  //
+  G4double nofSteps = 0.;
+  for ( G4int i=0; i<B4cRun::kNofRegions; ++i ) {
+    nofSteps += b4Run->GetNofRegionSteps(i);
+  }
+  if ( nofSteps > 0. ) {
+    G4cout << " Steps per region:";
+    for ( G4int i=0; i<B4cRun::kNofRegions; ++i ) {
+      G4cout 
+        << " " << B4cRun::GetRegionName(i) << " "
+        << b4Run->GetNofRegionSteps(i) << " (" 
+        << std::setprecision(3) << 100.*b4Run->GetNofRegionSteps(i)/nofSteps
+        << std::setprecision(6) << "%)";
+    }
+    G4cout << G4endl;
+  }
+
+  // print the steps and time per logical volume (/B4/nav/timing), 
+  // the slowest volumes first
+  //
+  const std::map<const G4LogicalVolume*, B4cRun::VolumeSteps>& volumeSteps
+    = b4Run->GetVolumeSteps();
+  if ( ! volumeSteps.empty() ) {
+    std::vector<std::pair<G4double, const G4LogicalVolume*> > volumes;
+    G4double nofVolumeSteps = 0.;
+    G4double seconds = 0.;
+    std::map<const G4LogicalVolume*, B4cRun::VolumeSteps>::const_iterator it;
+    for ( it = volumeSteps.begin(); it != volumeSteps.end(); ++it ) {
+      volumes.push_back(std::make_pair(it->second.seconds, it->first));
+      nofVolumeSteps += it->second.steps;
+      seconds += it->second.seconds;
+    }
+    std::sort(volumes.rbegin(), volumes.rend());
+    G4cout 
+      << " Steps per volume: " << nofVolumeSteps << " steps, " 
+      << seconds << " s" << G4endl;
+    for ( size_t i=0; i<volumes.size(); ++i ) {
+      const B4cRun::VolumeSteps& steps 
+        = volumeSteps.find(volumes[i].second)->second;
+      G4double nsPerStep 
+        = steps.timedSteps > 0. ? 1.e9*steps.seconds/steps.timedSteps : 0.;
+      G4cout 
+        << "   " << std::setw(20) << volumes[i].second->GetName() 
+        << std::setw(12) << steps.steps << " (" 
+        << std::setprecision(3) << 100.*steps.steps/nofVolumeSteps << "%) "
+        << nsPerStep << " ns/step " 
+        << steps.seconds << " s" << std::setprecision(6) << G4endl;
+    }
+  }
+
+  // print the back-pressure of the asynchronous writers (/B4/output/)
+  //
+  if ( b4Run->GetNofWriterRecords() > 0. ) {
+    G4cout
+      << " Async writer: " << b4Run->GetNofWriterRecords() << " records,"
+      << " queue depth mean " << b4Run->GetMeanWriterDepth()
+      << " max " << b4Run->GetMaxWriterDepth()
+      << " of " << B4cAsyncWriter::GetOptions().queueSize << ", "
+      << b4Run->GetNofWriterStalls() << " stalls ("
+      << b4Run->GetWriterStallSeconds() << " s)" << G4endl;
+  }
+
+  // compare the runs with and without parameterised showers (/B4/param/)
+  //
+  fTimer.Stop();
+  if ( IsMaster() && nofEvents > 0 ) PrintParameterisationReport(b4Run);
+
+  // response per species, e/pi and resolution (/B4/summary/)
+  //
+  if ( IsMaster() && nofEvents > 0 ) fResponseSummary->Report(b4Run);
+
+  // events needed for the target precision (/B4/adaptive/)
+  //
+  if ( IsMaster() && nofEvents > 0 && B4cAdaptiveRun::IsEnabled() ) {
+    B4cAdaptiveRun::Print(b4Run);
+  }
+
+  // pass the recorded showers (/B4/showerLib/) of this thread to the
+  // master, which writes the library or the validation report
   //
-  G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
+  B4cShowerLibraryRecorder* recorder = B4cShowerLibraryRecorder::GetInstance();
+  if ( recorder ) recorder->EndOfRun();
+  if ( IsMaster() ) B4cShowerLibraryRecorder::WriteResults();
+
+  G4VAnalysisManager* analysisManager = B4Analysis::GetManager();
+
+  // drain the writer of this thread, which has filled its histograms
+  // and ntuple
+  //
+  if ( fWriter->IsRunning() ) {
+    fWriter->Stop();
+  }
+
+  // append the last records of this thread
+  //
+  fRecordFile->Close();
+  if ( fVoxelFile->IsOpen() && fVoxelFile->GetNofEvents() > 0. ) {
+    G4cout
+      << " Shower images: "
+      << fVoxelFile->GetNofVoxels()/fVoxelFile->GetNofEvents()
+      << " voxels/event, " 
+      << fVoxelFile->GetNofBytes()/fVoxelFile->GetNofEvents()
+      << " bytes/event" << G4endl;
+  }
+  fVoxelFile->Close();
 
   // save histograms & ntuple
   //
   analysisManager->Write();
   analysisManager->CloseFile();
 
+  // output throughput of the analysis backend: the files of all threads
+  // are closed when the master ends the run
+  //
+  if ( IsMaster() && nofEvents > 0 ) {
+    G4double seconds = fTimer.GetRealElapsed();
+    G4double bytes = GetOutputSize(analysisManager->GetFileName());
+    G4cout
+      << " Analysis " << B4Analysis::GetBackend() << ": " 
+      << ( seconds > 0. ? nofEvents/seconds : 0. ) << " events/s, "
+      << bytes/nofEvents << " bytes/event" << G4endl;
+  }
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunAction::PrintParameterisationReport(const B4cRun* run)
+{
+  // Keep the time per event and gap profile of this run
+  G4int nofEvents = run->GetNumberOfEvent();
+  G4int kind = B4cParameterisedShowerModel::GetOptions().enable ? 1 : 0;
+  fSecondsPerEvent[kind] = fTimer.GetRealElapsed()/nofEvents;
+  fLayerProfile[kind].resize(run->GetNofEmLayers());
+  for ( G4int i=0; i<run->GetNofEmLayers(); ++i ) {
+    fLayerProfile[kind][i] = run->GetEmLayerEdep(i)/nofEvents;
+  }
+
+  // Both runs are needed, with the same EM section
+  if ( fSecondsPerEvent[0] <= 0. || fSecondsPerEvent[1] <= 0. ||
+       fLayerProfile[0].size() != fLayerProfile[1].size() ) return;
+
+  G4cout
+    << G4endl
+    << "--------------------Parameterised EM showers--------------------"
+    << G4endl
+    << " Time per event: full " << fSecondsPerEvent[0]*1.e3 
+    << " ms, parameterised " << fSecondsPerEvent[1]*1.e3
+    << " ms, speedup " << fSecondsPerEvent[0]/fSecondsPerEvent[1] << G4endl
+    << std::setw(7) << "layer" << std::setw(14) << "full (MeV)" 
+    << std::setw(14) << "param (MeV)" << std::setw(12) << "deviation" 
+    << G4endl;
+
+  G4double fullTotal = 0.;
+  G4double paramTotal = 0.;
+  G4double maxDeviation = 0.;
+  for ( size_t i=0; i<fLayerProfile[0].size(); ++i ) {
+    G4double full = fLayerProfile[0][i];
+    G4double param = fLayerProfile[1][i];
+    fullTotal += full;
+    paramTotal += param;
+    G4cout 
+      << std::setw(7) << i+1 << std::setw(14) << full/MeV 
+      << std::setw(14) << param/MeV;
+    if ( full > 0. ) {
+      G4double deviation = (param - full)/full;
+      maxDeviation = std::max(maxDeviation, std::fabs(deviation));
+      G4cout << std::setw(11) << 100.*deviation << "%";
+    }
+    G4cout << G4endl;
+  }
+  G4cout << std::setw(7) << "total" << std::setw(14) << fullTotal/MeV 
+         << std::setw(14) << paramTotal/MeV;
+  if ( fullTotal > 0. ) {
+    G4cout << std::setw(11) << 100.*(paramTotal - fullTotal)/fullTotal 
+           << "%";
+  }
+  G4cout 
+    << G4endl
+    << " Largest layer deviation: " << 100.*maxDeviation << "%" << G4endl
+    << "----------------------------------------------------------------"
+    << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4RunAction::GetOutputSize(const G4String& fileName) const
+{
+  // Sum of the files of the backend of the output file name: the thread
+  // files and, for csv, one file per histogram and ntuple
+  std::string path = fileName;
+  std::string directory = ".";
+  std::string::size_type slash = path.rfind('/');
+  if ( slash != std::string::npos ) {
+    directory = path.substr(0, slash);
+    path = path.substr(slash + 1);
+  }
+  std::string::size_type dot = path.rfind('.');
+  if ( dot != std::string::npos ) path = path.substr(0, dot);
+  std::string extension = B4Analysis::GetFileExtension();
+
+  G4double size = 0.;
+  DIR* dir = opendir(directory.c_str());
+  if ( ! dir ) return size;
+  while ( struct dirent* entry = readdir(dir) ) {
+    std::string name = entry->d_name;
+    if ( ! IsOutputFile(name, path, extension) ) continue;
+    struct stat status;
+    if ( stat((directory + "/" + name).c_str(), &status) == 0 ) {
+      size += status.st_size;
+    }
+  }
+  closedir(dir);
+  return size;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -32,6 +32,9 @@
 #include "B4PrimaryGeneratorAction.hh"
 #include "B4RunAction.hh"
 #include "B4cEventAction.hh"
+#include "B4cSteppingAction.hh"
+#include "B4cStackingAction.hh"
+#include "B4cShowerLibraryRecorder.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -58,6 +61,8 @@ void B4cActionInitialization::Build() const
   SetUserAction(new B4PrimaryGeneratorAction);
   SetUserAction(new B4RunAction);
   SetUserAction(new B4cEventAction);
+  SetUserAction(new B4cSteppingAction(new B4cShowerLibraryRecorder));
+  SetUserAction(new B4cStackingAction);
 }  
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,178 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cAdaptiveRun.cc
+/// \brief Implementation of the B4cAdaptiveRun class
+
+#include "B4cAdaptiveRun.hh"
+#include "B4cRun.hh"
+
+#include "G4RunManager.hh"
+#include "G4AutoLock.hh"
+
+#include <algorithm>
+#include <atomic>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  // Accumulators of all threads, reset at the beginning of each run
+  G4Mutex adaptiveMutex = G4MUTEX_INITIALIZER;
+  std::map<B4cRun::SpeciesKey, B4cRunningStatistics> sharedStatistics;
+  std::atomic<bool> targetReached(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cAdaptiveRun::Options::Options()
+ : precision(0.),
+   quantity("mean"),
+   interval(100),
+   minEvents(100)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cAdaptiveRun::Options& B4cAdaptiveRun::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal B4cAdaptiveRun* B4cAdaptiveRun::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cAdaptiveRun::B4cAdaptiveRun()
+ : fPending(),
+   fNofPendingEvents(0)
+{
+  fgInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cAdaptiveRun::~B4cAdaptiveRun()
+{
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAdaptiveRun::Reset()
+{
+  // The master begins the run before the workers start their events
+  G4AutoLock lock(&adaptiveMutex);
+  sharedStatistics.clear();
+  targetReached = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAdaptiveRun::BeginOfRun()
+{
+  // drop the events not flushed before the previous run was stopped
+  fPending.clear();
+  fNofPendingEvents = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAdaptiveRun::AddEvent(const B4cRun::SpeciesKey& key, 
+                              G4double visibleEdep)
+{
+  fPending[key].Add(visibleEdep);
+  if ( ++fNofPendingEvents >= GetOptions().interval ) Flush();
+
+  // Another thread may have reached the target
+  if ( targetReached ) G4RunManager::GetRunManager()->AbortRun(true);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAdaptiveRun::Flush()
+{
+  const Options& options = GetOptions();
+
+  G4AutoLock lock(&adaptiveMutex);
+  std::map<B4cRun::SpeciesKey, B4cRunningStatistics>::const_iterator it;
+  for ( it = fPending.begin(); it != fPending.end(); ++it ) {
+    sharedStatistics[it->first].Merge(it->second);
+  }
+  fPending.clear();
+  fNofPendingEvents = 0;
+
+  // All the species seen must have enough events and be precise enough
+  if ( sharedStatistics.empty() ) return;
+  for ( it = sharedStatistics.begin(); it != sharedStatistics.end(); ++it ) {
+    if ( it->second.GetN() < options.minEvents ) return;
+    if ( GetPrecision(it->second) > options.precision ) return;
+  }
+  targetReached = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cAdaptiveRun::GetPrecision(const B4cRunningStatistics& visible)
+{
+  if ( GetOptions().quantity == "resolution" ) {
+    G4double resolution = visible.GetRelativeRms();
+    return ( resolution > 0. ) 
+           ? visible.GetRelativeRmsError()/resolution : DBL_MAX;
+  }
+  G4double mean = visible.GetMean();
+  return ( mean > 0. ) ? visible.GetMeanError()/mean : DBL_MAX;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAdaptiveRun::Print(const B4cRun* run)
+{
+  const Options& options = GetOptions();
+
+  // the precision of the merged run, which includes the events not yet
+  // flushed when the target was reached
+  G4double worst = 0.;
+  const std::map<B4cRun::SpeciesKey, B4cRun::Response>& responses 
+    = run->GetResponses();
+  std::map<B4cRun::SpeciesKey, B4cRun::Response>::const_iterator it;
+  for ( it = responses.begin(); it != responses.end(); ++it ) {
+    worst = std::max(worst, GetPrecision(it->second.visible));
+  }
+
+  G4cout
+    << " Adaptive run: " << run->GetNumberOfEvent() << " events of "
+    << G4RunManager::GetRunManager()->GetNumberOfEventsToBeProcessed()
+    << ", relative error of the " << options.quantity << " " << worst
+    << ( targetReached ? " (target " : " (target not reached, ")
+    << options.precision << ")" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
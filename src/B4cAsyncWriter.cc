@@ -0,0 +1,318 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cAsyncWriter.cc
+/// \brief Implementation of the B4cAsyncWriter class
+
+#include "B4cAsyncWriter.hh"
+#include "B4Analysis.hh"
+
+#include "G4Threading.hh"
+#include "G4Timer.hh"
+
+#include <chrono>
+#include <sstream>
+
+namespace {
+  const char kFileMagic[8] = { 'B', '4', 'C', 'E', 'V', 'T', '0', '2' };
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cAsyncWriter::Options::Options()
+ : enable(false),
+   queueSize(1024),
+   fileName("events")
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cAsyncWriter::Options& B4cAsyncWriter::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal B4cAsyncWriter* B4cAsyncWriter::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cAsyncWriter::B4cAsyncWriter()
+ : fRunning(false),
+   fNofLayers(0),
+   fNofRadialBins(0),
+   fRadialBinWidth(0.),
+   fRecordSize(0),
+   fCapacity(0),
+   fSlots(),
+   fHead(0),
+   fTail(0),
+   fStop(false),
+   fThread(),
+   fAnalysisMutex(),
+   fFile(0),
+   fFileBuffer(),
+   fAnalysisManager(0),
+   fSchema(0)
+{
+  for ( G4int i=0; i<B4cNtupleSchema::kNofVectors; ++i ) {
+    fVectorOffset[i] = 0;
+    fVectorCapacity[i] = 0;
+  }
+  fgInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cAsyncWriter::~B4cAsyncWriter()
+{
+  Stop();
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAsyncWriter::Start(G4int nofLayers, G4int nofRadialBins,
+                           G4double radialBinWidth,
+                           const G4int vectorCapacity[])
+{
+  if ( fRunning ) Stop();
+
+  const Options& options = GetOptions();
+
+  std::ostringstream fileName;
+  fileName << options.fileName;
+  if ( G4Threading::G4GetThreadId() >= 0 ) {
+    fileName << "_t" << G4Threading::G4GetThreadId();
+  }
+  fileName << ".bin";
+  fFile = std::fopen(fileName.str().c_str(), "wb");
+  if ( ! fFile ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open " << fileName.str() 
+        << ", the event records are not written.";
+    G4Exception("B4cAsyncWriter::Start()",
+      "MyCode0010", JustWarning, msg);
+    return;
+  }
+  fFileBuffer.resize(1 << 20);
+  std::setvbuf(fFile, &fFileBuffer[0], _IOFBF, fFileBuffer.size());
+
+  // The writer thread fills the analysis manager and the ntuple schema
+  // of this thread
+  fAnalysisManager = B4Analysis::GetManager();
+  fSchema = B4cNtupleSchema::GetInstance();
+
+  // Record layout, fixed for the run
+  fNofLayers = std::max(nofLayers, 0);
+  fNofRadialBins = std::max(nofRadialBins, 0);
+  fRadialBinWidth = radialBinWidth;
+  fRecordSize = kNofHeaderValues + fNofLayers*(1 + fNofRadialBins);
+  for ( G4int i=0; i<B4cNtupleSchema::kNofVectors; ++i ) {
+    fVectorOffset[i] = fRecordSize;
+    fVectorCapacity[i] 
+      = ( fSchema && fSchema->HasVector(i) ) 
+        ? std::max(vectorCapacity[i], 0) : 0;
+    fRecordSize += fVectorCapacity[i];
+  }
+  fCapacity = std::max(options.queueSize, 1);
+  fSlots.assign(fCapacity*fRecordSize, 0.);
+
+  G4int layout[3] = { G4int(fRecordSize), fNofLayers, fNofRadialBins };
+  std::fwrite(kFileMagic, sizeof(kFileMagic), 1, fFile);
+  std::fwrite(layout, sizeof(layout), 1, fFile);
+  std::fwrite(&fRadialBinWidth, sizeof(fRadialBinWidth), 1, fFile);
+
+  fHead.store(0);
+  fTail.store(0);
+  fStop.store(false);
+  fThread = std::thread(&B4cAsyncWriter::Run, this);
+  fRunning = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAsyncWriter::Stop()
+{
+  if ( ! fRunning ) return;
+
+  // The writer drains the buffer before it returns
+  fStop.store(true, std::memory_order_release);
+  fThread.join();
+  std::fclose(fFile);
+  fFile = 0;
+  fRunning = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double* B4cAsyncWriter::AcquireSlot(G4double& depth, G4double& stallSeconds)
+{
+  size_t head = fHead.load(std::memory_order_relaxed);
+  size_t tail = fTail.load(std::memory_order_acquire);
+  stallSeconds = 0.;
+  if ( head - tail >= fCapacity ) {
+    // Back-pressure: wait for the writer to free a slot
+    G4Timer timer;
+    timer.Start();
+    do {
+      std::this_thread::yield();
+      tail = fTail.load(std::memory_order_acquire);
+    } while ( head - tail >= fCapacity );
+    timer.Stop();
+    stallSeconds = std::max(timer.GetRealElapsed(), 1.e-9);
+  }
+  depth = head - tail;
+  return &fSlots[(head % fCapacity)*fRecordSize];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAsyncWriter::Run()
+{
+  while ( true ) {
+    size_t tail = fTail.load(std::memory_order_relaxed);
+    size_t head = fHead.load(std::memory_order_acquire);
+    if ( tail == head ) {
+      // the last records may be committed just before the stop request
+      if ( fStop.load(std::memory_order_acquire) &&
+           fHead.load(std::memory_order_acquire) == tail ) break;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      continue;
+    }
+    for ( ; tail != head; ++tail ) {
+      Process(&fSlots[(tail % fCapacity)*fRecordSize]);
+      fTail.store(tail + 1, std::memory_order_release);
+    }
+  }
+  std::fflush(fFile);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAsyncWriter::Process(const G4double* record)
+{
+  std::fwrite(record, sizeof(G4double), fRecordSize, fFile);
+
+  std::lock_guard<std::mutex> lock(fAnalysisMutex);
+  FillHistograms(record);
+  FillNtuple(record);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAsyncWriter::FillHistograms(const G4double* record) const
+{
+  // Same entries as in the synchronous mode of the event action: one per
+  // read-out layer and one per non-empty radial bin of a layer
+  const G4double* layerEdep = record + GetLayerOffset();
+  const G4double* radialEdep = record + GetRadialOffset();
+  for ( G4int i=0; i<fNofLayers; ++i ) {
+    if ( layerEdep[i] < 0. ) continue;
+    fAnalysisManager->FillH1(2, i+1, layerEdep[i]);
+    if ( layerEdep[i] <= 0. ) continue;
+    for ( G4int bin=0; bin<fNofRadialBins; ++bin ) {
+      G4double edep = radialEdep[i*fNofRadialBins + bin];
+      if ( edep <= 0. ) continue;
+      G4double r = (bin + 0.5)*fRadialBinWidth;
+      fAnalysisManager->FillH1(1, r, edep);
+      fAnalysisManager->FillH2(1, i+1, r, edep);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cAsyncWriter::FillNtuple(const G4double* record) const
+{
+  // Same columns as B4cEventAction::FillResultNtuple()
+  if ( ! fSchema || ! fSchema->IsBooked() ) return;
+
+  G4double absoEdep = record[kAbsoEdep];
+  G4double gapEdep = record[kGapEdep];
+  G4double hcalEdep = record[kHcalEdep];
+  G4double totalEdep = absoEdep + gapEdep + hcalEdep;
+
+  fSchema->Fill(B4cNtupleSchema::kEmTotal, absoEdep + gapEdep);
+  fSchema->Fill(B4cNtupleSchema::kEmRMean, record[kEmRMean]);
+  fSchema->Fill(B4cNtupleSchema::kEmRRms, record[kEmRRms]);
+  fSchema->Fill(B4cNtupleSchema::kKilledTime, record[kKilledTime]);
+  fSchema->Fill(B4cNtupleSchema::kKilledEkin, record[kKilledEkin]);
+
+  fSchema->Fill(B4cNtupleSchema::kAbsoEdep, absoEdep);
+  fSchema->Fill(B4cNtupleSchema::kGapEdep, gapEdep);
+  fSchema->Fill(B4cNtupleSchema::kHcalEdep, hcalEdep);
+  fSchema->Fill(B4cNtupleSchema::kTotalEdep, totalEdep);
+
+  fSchema->Fill(B4cNtupleSchema::kAbsoLength, record[kAbsoLength]);
+  fSchema->Fill(B4cNtupleSchema::kGapLength, record[kGapLength]);
+  fSchema->Fill(B4cNtupleSchema::kHcalLength, record[kHcalLength]);
+
+  // species of a mixed run, also histogrammed per species
+  if ( record[kSpecies] >= 0. ) {
+    fSchema->Fill(B4cNtupleSchema::kSpecies, G4int(record[kSpecies]));
+    fSchema->Fill(B4cNtupleSchema::kBeamEnergy, record[kBeamEnergy]);
+    if ( record[kSpeciesTotalH1] >= 0. ) {
+      fAnalysisManager->FillH1(G4int(record[kSpeciesTotalH1]), totalEdep);
+      fAnalysisManager->FillH1(G4int(record[kSpeciesVisibleH1]), gapEdep);
+    }
+  }
+
+  // pile-up
+  if ( record[kHasPileUp] > 0. ) {
+    fSchema->Fill(B4cNtupleSchema::kNofPrimaries, 
+                  G4int(record[kNofPrimaries]));
+    fSchema->Fill(B4cNtupleSchema::kSignalEdep, record[kSignalEdep]);
+    fSchema->Fill(B4cNtupleSchema::kPileUpEdep, 
+                  totalEdep - record[kSignalEdep]);
+  }
+
+  if ( record[kHasPrimary] > 0. ) {
+    fSchema->Fill(B4cNtupleSchema::kPrimaryPdg, G4int(record[kPrimaryPdg]));
+    fSchema->Fill(B4cNtupleSchema::kPrimaryEkin, record[kPrimaryEkin]);
+    fSchema->Fill(B4cNtupleSchema::kPrimaryX, record[kPrimaryX]);
+    fSchema->Fill(B4cNtupleSchema::kPrimaryY, record[kPrimaryY]);
+    fSchema->Fill(B4cNtupleSchema::kPrimaryDirX, record[kPrimaryDirX]);
+    fSchema->Fill(B4cNtupleSchema::kPrimaryDirY, record[kPrimaryDirY]);
+    fSchema->Fill(B4cNtupleSchema::kPrimaryDirZ, record[kPrimaryDirZ]);
+  }
+
+  // the vectors of the schema are used only by this thread while it runs
+  for ( G4int i=0; i<B4cNtupleSchema::kNofVectors; ++i ) {
+    if ( ! fSchema->HasVector(i) ) continue;
+    const G4double* layers = record + fVectorOffset[i];
+    G4int size = std::min(G4int(record[kVectorSize + i]), fVectorCapacity[i]);
+    fSchema->GetVector(i).assign(layers, layers + size);
+  }
+
+  fSchema->AddRow();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,235 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cBeamSpectrum.cc
+/// \brief Implementation of the B4cBeamSpectrum class
+
+#include "B4cBeamSpectrum.hh"
+
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  struct PowerLaw {
+    G4double index;
+    G4double operator()(G4double energy) const { 
+      return std::pow(energy, -index); 
+    }
+  };
+
+  struct Gauss {
+    G4double mean;
+    G4double sigma;
+    G4double operator()(G4double energy) const {
+      G4double x = (energy - mean)/sigma;
+      return std::exp(-0.5*x*x);
+    }
+  };
+
+  struct Flat {
+    G4double operator()(G4double) const { return 1.; }
+  };
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cBeamSpectrum::B4cBeamSpectrum()
+ : fLowEdges(),
+   fWidths(),
+   fProbabilities(),
+   fAliases(),
+   fMean(0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cBeamSpectrum::~B4cBeamSpectrum()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cBeamSpectrum::Clear()
+{
+  fLowEdges.clear();
+  fWidths.clear();
+  fProbabilities.clear();
+  fAliases.clear();
+  fMean = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cBeamSpectrum::SetHistogram(const std::vector<G4double>& lowEdges,
+                                     const std::vector<G4double>& highEdges,
+                                     const std::vector<G4double>& weights)
+{
+  Clear();
+
+  G4int nofBins = weights.size();
+  G4double sum = 0.;
+  for ( G4int i=0; i<nofBins; ++i ) {
+    if ( weights[i] < 0. || highEdges[i] < lowEdges[i] ) return false;
+    sum += weights[i];
+    fMean += weights[i]*0.5*(lowEdges[i] + highEdges[i]);
+  }
+  if ( nofBins == 0 || sum <= 0. ) return false;
+  fMean /= sum;
+
+  fLowEdges = lowEdges;
+  fWidths.resize(nofBins);
+  for ( G4int i=0; i<nofBins; ++i ) fWidths[i] = highEdges[i] - lowEdges[i];
+
+  // Vose's alias method: the bins below the average probability are 
+  // filled up with the excess of the ones above it
+  fProbabilities.resize(nofBins);
+  fAliases.resize(nofBins);
+  std::vector<G4int> small;
+  std::vector<G4int> large;
+  for ( G4int i=0; i<nofBins; ++i ) {
+    fProbabilities[i] = weights[i]*nofBins/sum;
+    fAliases[i] = i;
+    if ( fProbabilities[i] < 1. ) small.push_back(i);
+    else                          large.push_back(i);
+  }
+  while ( small.size() && large.size() ) {
+    G4int less = small.back();
+    small.pop_back();
+    G4int more = large.back();
+    fAliases[less] = more;
+    fProbabilities[more] -= 1. - fProbabilities[less];
+    if ( fProbabilities[more] < 1. ) {
+      large.pop_back();
+      small.push_back(more);
+    }
+  }
+  // the remaining bins are full up to rounding errors
+  for ( size_t i=0; i<small.size(); ++i ) fProbabilities[small[i]] = 1.;
+  for ( size_t i=0; i<large.size(); ++i ) fProbabilities[large[i]] = 1.;
+
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cBeamSpectrum::ReadTable(const G4String& fileName)
+{
+  Clear();
+
+  std::ifstream input(fileName);
+  if ( ! input ) return false;
+
+  std::vector<G4double> lowEdges;
+  std::vector<G4double> highEdges;
+  std::vector<G4double> weights;
+  std::string line;
+  while ( std::getline(input, line) ) {
+    line = line.substr(0, line.find('#'));
+    std::istringstream fields(line);
+    G4double lowEdge, highEdge, weight;
+    if ( ! ( fields >> lowEdge ) ) continue;
+    if ( ! ( fields >> highEdge >> weight ) ) return false;
+    lowEdges.push_back(lowEdge*MeV);
+    highEdges.push_back(highEdge*MeV);
+    weights.push_back(weight);
+  }
+  return SetHistogram(lowEdges, highEdges, weights);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+template <class Density>
+G4bool B4cBeamSpectrum::Tabulate(G4double minEnergy, G4double maxEnergy, 
+                                 G4int nofBins, Density density)
+{
+  Clear();
+  if ( nofBins < 1 || maxEnergy <= minEnergy ) return false;
+
+  // the density at the bin centres
+  std::vector<G4double> lowEdges(nofBins);
+  std::vector<G4double> highEdges(nofBins);
+  std::vector<G4double> weights(nofBins);
+  G4double width = (maxEnergy - minEnergy)/nofBins;
+  for ( G4int i=0; i<nofBins; ++i ) {
+    lowEdges[i] = minEnergy + i*width;
+    highEdges[i] = lowEdges[i] + width;
+    weights[i] = density(lowEdges[i] + 0.5*width);
+  }
+  return SetHistogram(lowEdges, highEdges, weights);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cBeamSpectrum::SetFlat(G4double minEnergy, G4double maxEnergy, 
+                                G4int nofBins)
+{
+  return Tabulate(minEnergy, maxEnergy, nofBins, Flat());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cBeamSpectrum::SetGauss(G4double mean, G4double relativeSpread,
+                                 G4int nofBins)
+{
+  Gauss gauss;
+  gauss.mean = mean;
+  gauss.sigma = relativeSpread*mean;
+  if ( gauss.sigma <= 0. ) return false;
+  return Tabulate(std::max(mean - 5.*gauss.sigma, 0.), 
+                  mean + 5.*gauss.sigma, nofBins, gauss);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cBeamSpectrum::SetPowerLaw(G4double minEnergy, G4double maxEnergy, 
+                                    G4double index, G4int nofBins)
+{
+  PowerLaw powerLaw;
+  powerLaw.index = index;
+  if ( minEnergy <= 0. ) return false;
+  return Tabulate(minEnergy, maxEnergy, nofBins, powerLaw);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cBeamSpectrum::Sample() const
+{
+  G4int nofBins = fLowEdges.size();
+  G4double u = G4UniformRand()*nofBins;
+  G4int bin = std::min(G4int(u), nofBins - 1);
+  if ( u - bin >= fProbabilities[bin] ) bin = fAliases[bin];
+  return fLowEdges[bin] + G4UniformRand()*fWidths[bin];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -29,12 +29,34 @@
 /// \brief Implementation of the B4cCalorimeterSD class
 
 #include "B4cCalorimeterSD.hh"
+#include "B4cRun.hh"
+#include "B4cPileUp.hh"
 #include "G4HCofThisEvent.hh"
 #include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4VTouchable.hh"
+#include "G4NavigationHistory.hh"
+#include "G4AffineTransform.hh"
 #include "G4ThreeVector.hh"
 #include "G4SDManager.hh"
+#include "G4RunManager.hh"
+#include "G4EventManager.hh"
+#include "G4TrackingManager.hh"
 #include "G4ios.hh"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <climits>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cCalorimeterSD::Options& B4cCalorimeterSD::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 B4cCalorimeterSD::B4cCalorimeterSD(
@@ -43,9 +65,34 @@ B4cCalorimeterSD::B4cCalorimeterSD(
                             G4int nofCells)
  : G4VSensitiveDetector(name),
    fHitsCollection(0),
-   fNofCells(nofCells)
+   fNofCells(0),
+   fHCID(-1),
+   fFlat(true),
+   fTiming(false),
+   fNofRadialBins(0),
+   fRadialRange(0.),
+   fInvRadialBinWidth(0.),
+   fTotalEdep(0.),
+   fTotalTrackLength(0.),
+   fNofCellsX(1),
+   fNofCellsY(1),
+   fHalfSizeXY(0.),
+   fInvCellWidthX(0.),
+   fInvCellWidthY(0.),
+   fCellMap(),
+   fNofVoxelsX(0),
+   fNofVoxelsY(0),
+   fVoxelLayerOffset(0),
+   fInvVoxelWidthX(0.),
+   fInvVoxelWidthY(0.),
+   fVoxelMap(),
+   fPileUp(false),
+   fPrimaryEdep(),
+   fNofTimedSteps(0.),
+   fTimedSeconds(0.)
 {
   collectionName.insert(hitsCollectionName);
+  SetNofCells(nofCells);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -56,16 +103,128 @@ B4cCalorimeterSD::~B4cCalorimeterSD()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void B4cCalorimeterSD::SetNofCells(G4int nofCells)
+{
+  // The buffers are (re)allocated here only, never per event
+  fNofCells = std::max(nofCells, 0);
+  fEdep.assign(fNofCells, 0.);
+  fTrackLength.assign(fNofCells, 0.);
+  fEdepX.assign(fNofCells, 0.);
+  fEdepY.assign(fNofCells, 0.);
+  fEdepR.assign(fNofCells, 0.);
+  fEdepR2.assign(fNofCells, 0.);
+  fRadialEdep.assign(fNofCells*(fNofRadialBins+1), 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::SetRadialRange(G4double rMax)
+{
+  fRadialRange = rMax;
+  SetNofRadialBins(fNofRadialBins);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::SetNofRadialBins(G4int nofBins)
+{
+  fNofRadialBins = std::max(nofBins, 0);
+  fInvRadialBinWidth 
+    = ( fRadialRange > 0. ) ? fNofRadialBins/fRadialRange : 0.;
+  fRadialEdep.assign(fNofCells*(fNofRadialBins+1), 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::SetCellGrid(G4int nofCellsX, G4int nofCellsY,
+                                   G4double sizeXY)
+{
+  // The cell key must fit in G4int for all layers
+  if ( nofCellsX < 1 || nofCellsY < 1 || sizeXY <= 0. ||
+       G4double(nofCellsX)*nofCellsY*std::max(fNofCells, 1) > INT_MAX ) {
+    G4ExceptionDescription msg;
+    msg << "Invalid readout grid " << nofCellsX << " x " << nofCellsY
+        << " for " << fNofCells << " layers of " << SensitiveDetectorName;
+    G4Exception("B4cCalorimeterSD::SetCellGrid()",
+      "MyCode0007", FatalException, msg);
+    return;
+  }
+
+  fNofCellsX = nofCellsX;
+  fNofCellsY = nofCellsY;
+  fHalfSizeXY = sizeXY/2.;
+  fInvCellWidthX = fNofCellsX/sizeXY;
+  fInvCellWidthY = fNofCellsY/sizeXY;
+  fCellMap.Clear();
+  SetVoxelGrid(fNofVoxelsX, fNofVoxelsY);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::SetVoxelLayerOffset(G4int offset)
+{
+  fVoxelLayerOffset = std::max(offset, 0);
+  SetVoxelGrid(fNofVoxelsX, fNofVoxelsY);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::SetVoxelGrid(G4int nofVoxelsX, G4int nofVoxelsY)
+{
+  // No voxels if either number is 0; the key must fit in G4int for all
+  // layers of the stack up to this detector
+  if ( nofVoxelsX <= 0 || nofVoxelsY <= 0 ) {
+    fNofVoxelsX = fNofVoxelsY = 0;
+  }
+  else if ( G4double(nofVoxelsX)*nofVoxelsY
+              *(fVoxelLayerOffset + std::max(fNofCells, 1)) > INT_MAX ) {
+    G4ExceptionDescription msg;
+    msg << "Invalid voxel grid " << nofVoxelsX << " x " << nofVoxelsY
+        << " for " << fVoxelLayerOffset + fNofCells << " layers";
+    G4Exception("B4cCalorimeterSD::SetVoxelGrid()",
+      "MyCode0007", FatalException, msg);
+    return;
+  }
+  else {
+    fNofVoxelsX = nofVoxelsX;
+    fNofVoxelsY = nofVoxelsY;
+  }
+
+  G4double sizeXY = 2.*fHalfSizeXY;
+  fInvVoxelWidthX = ( sizeXY > 0. ) ? fNofVoxelsX/sizeXY : 0.;
+  fInvVoxelWidthY = ( sizeXY > 0. ) ? fNofVoxelsY/sizeXY : 0.;
+  fVoxelMap.Clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void B4cCalorimeterSD::Initialize(G4HCofThisEvent* hce)
 {
-  // Create hits collections (now create 2, one for all hits of the primary track)
+  const Options& options = GetOptions();
+  fFlat = options.flat;
+  fTiming = options.timing;
+  fPileUp = B4cPileUp::IsEnabled() && B4cPileUp::GetInstance();
+  fHitsCollection = 0;
+  if ( options.radialBins != fNofRadialBins ) {
+    SetNofRadialBins(options.radialBins);
+  }
+  if ( options.voxelsX != fNofVoxelsX || options.voxelsY != fNofVoxelsY ) {
+    SetVoxelGrid(options.voxelsX, options.voxelsY);
+  }
+
+  ResetBuffers();
+
+  if ( fFlat ) return;
+
+  // Create hits collection
   fHitsCollection 
     = new B4cCalorHitsCollection(SensitiveDetectorName, collectionName[0]); 
 
   // Add this collection in hce
-  G4int hcID 
-    = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
-  hce->AddHitsCollection( hcID, fHitsCollection ); 
+  if ( fHCID < 0 ) {
+    fHCID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
+  }
+  hce->AddHitsCollection( fHCID, fHitsCollection ); 
 
   // Create hits
   // fNofCells for cells + one more for total sums 
@@ -79,6 +238,89 @@ void B4cCalorimeterSD::Initialize(G4HCofThisEvent* hce)
 G4bool B4cCalorimeterSD::ProcessHits(G4Step* step, 
                                      G4TouchableHistory*)
 {  
+  if ( fPileUp ) {
+    AddPrimaryEdep(step->GetTrack()->GetTrackID(), 
+                   step->GetTotalEnergyDeposit());
+  }
+
+  if ( ! fTiming ) {
+    return fFlat ? AccumulateFlat(step) : AccumulateHits(step);
+  }
+
+  std::chrono::steady_clock::time_point start 
+    = std::chrono::steady_clock::now();
+  G4bool result = fFlat ? AccumulateFlat(step) : AccumulateHits(step);
+  std::chrono::duration<double> elapsed 
+    = std::chrono::steady_clock::now() - start;
+
+  fNofTimedSteps += 1.;
+  fTimedSeconds += elapsed.count();
+
+  return result;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cCalorimeterSD::AccumulateFlat(const G4Step* step)
+{
+  // energy deposit
+  G4double edep = step->GetTotalEnergyDeposit();
+  
+  // step length
+  G4double stepLength = 0.;
+  if ( step->GetTrack()->GetDefinition()->GetPDGCharge() != 0. ) {
+    stepLength = step->GetStepLength();
+  }
+
+  if ( edep==0. && stepLength == 0. ) return false;      
+
+  const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+  Accumulate(preStepPoint->GetTouchable(), preStepPoint->GetPosition(),
+             edep, stepLength);
+      
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::Accumulate(const G4VTouchable* touchable,
+                                  const G4ThreeVector& position,
+                                  G4double edep, G4double stepLength)
+{
+  // Get calorimeter cell id 
+  G4int layerNumber = touchable->GetReplicaNumber(1);
+  if ( layerNumber < 0 || layerNumber >= fNofCells ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot access layer " << layerNumber; 
+    G4Exception("B4cCalorimeterSD::Accumulate()",
+      "MyCode0004", FatalException, msg);
+  }         
+
+  // Add values
+  G4double x = position.x();
+  G4double y = position.y();
+  G4double r2 = x*x + y*y;
+  G4double r = std::sqrt(r2);
+  fEdep[layerNumber] += edep;
+  fTrackLength[layerNumber] += stepLength;
+  fEdepX[layerNumber] += edep*x;
+  fEdepY[layerNumber] += edep*y;
+  fEdepR[layerNumber] += edep*r;
+  fEdepR2[layerNumber] += edep*r2;
+
+  // Transverse profile
+  AddRadialEdep(layerNumber, r, edep);
+
+  // Readout cells and voxels
+  if ( HasCellGrid() || HasVoxels() ) {
+    AddReadoutEdep(touchable, position, layerNumber, edep);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cCalorimeterSD::AccumulateHits(const G4Step* step)
+{
   // energy deposit
   G4double edep = step->GetTotalEnergyDeposit();
   
@@ -114,15 +356,116 @@ G4bool B4cCalorimeterSD::ProcessHits(G4Step* step,
   G4ThreeVector vec = step->GetPreStepPoint()->GetPosition();
   hit->SetPosition(vec);
   hitTotal->Add(edep, stepLength); 
+
+  // Readout cells and voxels
+  if ( HasCellGrid() || HasVoxels() ) {
+    AddReadoutEdep(touchable, vec, layerNumber, edep);
+  }
       
   return true;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void B4cCalorimeterSD::EndOfEvent(G4HCofThisEvent*)
+void B4cCalorimeterSD::AddSpot(G4double edep, const G4ThreeVector& position,
+                               const G4VTouchable* touchable)
+{
+  // the spot comes from the track handled by the fast simulation model
+  if ( fPileUp ) {
+    const G4Track* track 
+      = G4EventManager::GetEventManager()->GetTrackingManager()->GetTrack();
+    if ( track ) AddPrimaryEdep(track->GetTrackID(), edep);
+  }
+
+  if ( fFlat ) {
+    Accumulate(touchable, position, edep, 0.);
+    return;
+  }
+
+  // Hits mode: the spot is accounted as a step without track length
+  G4int layerNumber = touchable->GetReplicaNumber(1);
+  B4cCalorHit* hit = (*fHitsCollection)[layerNumber];
+  B4cCalorHit* hitTotal 
+    = (*fHitsCollection)[fHitsCollection->entries()-1];
+  G4ThreeVector spotPosition = position;
+  hit->Add(edep, 0.);
+  hit->SetPosition(spotPosition);
+  hitTotal->Add(edep, 0.); 
+  if ( HasCellGrid() || HasVoxels() ) {
+    AddReadoutEdep(touchable, position, layerNumber, edep);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::AddReadoutEdep(const G4VTouchable* touchable,
+                                      const G4ThreeVector& position,
+                                      G4int layer, G4double edep)
+{
+  if ( edep <= 0. ) return;
+
+  // Cell and voxel indices from the position in the frame of the sensitive
+  // volume; the points on the outer boundaries go to the edge cells
+  G4ThreeVector localPosition 
+    = touchable->GetHistory()->GetTopTransform().TransformPoint(position);
+  G4double x = localPosition.x() + fHalfSizeXY;
+  G4double y = localPosition.y() + fHalfSizeXY;
+
+  if ( HasCellGrid() ) {
+    G4int ix = std::min(std::max(G4int(x*fInvCellWidthX), 0), fNofCellsX-1);
+    G4int iy = std::min(std::max(G4int(y*fInvCellWidthY), 0), fNofCellsY-1);
+    fCellMap.Add((layer*fNofCellsY + iy)*fNofCellsX + ix, edep);
+  }
+
+  if ( HasVoxels() ) {
+    G4int ix = std::min(std::max(G4int(x*fInvVoxelWidthX), 0), fNofVoxelsX-1);
+    G4int iy = std::min(std::max(G4int(y*fInvVoxelWidthY), 0), fNofVoxelsY-1);
+    G4int iz = fVoxelLayerOffset + layer;
+    fVoxelMap.Add((iz*fNofVoxelsY + iy)*fNofVoxelsX + ix, edep);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::AddPrimaryEdep(G4int trackID, G4double edep)
 {
-  if ( verboseLevel>1 ) { 
+  if ( edep <= 0. ) return;
+
+  // one accumulator per primary, grown as the primaries deposit energy
+  G4int primary = B4cPileUp::GetInstance()->GetPrimary(trackID);
+  if ( primary >= G4int(fPrimaryEdep.size()) ) {
+    fPrimaryEdep.resize(primary+1, 0.);
+  }
+  fPrimaryEdep[primary] += edep;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::EndOfEvent(G4HCofThisEvent* hce)
+{
+  if ( fFlat ) {
+    fTotalEdep = 0.;
+    fTotalTrackLength = 0.;
+    for ( G4int i=0; i<fNofCells; ++i ) {
+      fTotalEdep += fEdep[i];
+      fTotalTrackLength += fTrackLength[i];
+    }
+    if ( GetOptions().storeHits ) MaterialiseHits(hce);
+  }
+  else {
+    FillBuffersFromHits();
+  }
+
+  if ( fTiming && fNofTimedSteps > 0. ) {
+    B4cRun* run 
+      = static_cast<B4cRun*>(
+          G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    run->AddSDTiming(fNofTimedSteps, fTimedSeconds);
+    fNofTimedSteps = 0.;
+    fTimedSeconds = 0.;
+  }
+
+  if ( verboseLevel>1 && fHitsCollection ) { 
      G4int nofHits = fHitsCollection->entries();
      G4cout
        << G4endl 
@@ -133,3 +476,77 @@ void B4cCalorimeterSD::EndOfEvent(G4HCofThisEvent*)
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreeVector B4cCalorimeterSD::GetMeanPosition(G4int layer) const
+{
+  if ( fEdep[layer] <= 0. ) return G4ThreeVector();
+  return G4ThreeVector(fEdepX[layer]/fEdep[layer], 
+                       fEdepY[layer]/fEdep[layer], 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::ResetBuffers()
+{
+  std::fill(fEdep.begin(), fEdep.end(), 0.);
+  std::fill(fTrackLength.begin(), fTrackLength.end(), 0.);
+  std::fill(fEdepX.begin(), fEdepX.end(), 0.);
+  std::fill(fEdepY.begin(), fEdepY.end(), 0.);
+  std::fill(fEdepR.begin(), fEdepR.end(), 0.);
+  std::fill(fEdepR2.begin(), fEdepR2.end(), 0.);
+  std::fill(fRadialEdep.begin(), fRadialEdep.end(), 0.);
+  fCellMap.Clear();
+  fVoxelMap.Clear();
+  fPrimaryEdep.clear();
+  fTotalEdep = 0.;
+  fTotalTrackLength = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::FillBuffersFromHits()
+{
+  // The hit position is the one of the last step in the layer
+  for ( G4int i=0; i<fNofCells; ++i ) {
+    const B4cCalorHit* hit = (*fHitsCollection)[i];
+    G4ThreeVector position = hit->GetPosition();
+    fEdep[i] = hit->GetEdep();
+    fTrackLength[i] = hit->GetTrackLength();
+    fEdepX[i] = fEdep[i]*position.x();
+    fEdepY[i] = fEdep[i]*position.y();
+    fEdepR[i] = fEdep[i]*position.perp();
+    fEdepR2[i] = fEdep[i]*position.perp2();
+    AddRadialEdep(i, position.perp(), fEdep[i]);
+  }
+
+  const B4cCalorHit* hitTotal = (*fHitsCollection)[fNofCells];
+  fTotalEdep = hitTotal->GetEdep();
+  fTotalTrackLength = hitTotal->GetTrackLength();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterSD::MaterialiseHits(G4HCofThisEvent* hce)
+{
+  fHitsCollection 
+    = new B4cCalorHitsCollection(SensitiveDetectorName, collectionName[0]); 
+  if ( fHCID < 0 ) {
+    fHCID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
+  }
+  hce->AddHitsCollection( fHCID, fHitsCollection ); 
+
+  // One hit per layer, at the energy-weighted mean position, and one more
+  // for the totals
+  for ( G4int i=0; i<fNofCells; ++i ) {
+    B4cCalorHit* hit = new B4cCalorHit();
+    hit->Add(fEdep[i], fTrackLength[i]);
+    G4ThreeVector position = GetMeanPosition(i);
+    hit->SetPosition(position);
+    fHitsCollection->insert(hit);
+  }
+  B4cCalorHit* hitTotal = new B4cCalorHit();
+  hitTotal->Add(fTotalEdep, fTotalTrackLength);
+  fHitsCollection->insert(hitTotal);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,346 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cCalorimeterStack.cc
+/// \brief Implementation of the B4cCalorimeterStack class
+
+#include "B4cCalorimeterStack.hh"
+
+#include "G4Material.hh"
+#include "G4NistManager.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  const char* kSectionNames[B4cCalorimeterStack::kNofSections] 
+    = { "em", "fe", "w" };
+  const char* kReadoutNames[] = { "none", "absorber", "active", "both" };
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cCalorimeterStack::Module::Module()
+ : name(),
+   section(kEm),
+   nofLayers(0),
+   absorberMaterial(),
+   absorberThickness(0.),
+   activeMaterial(),
+   activeThickness(0.),
+   readout(kNone)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cCalorimeterStack::B4cCalorimeterStack()
+ : fModules()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cCalorimeterStack::~B4cCalorimeterStack()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cCalorimeterStack::Load(const G4String& fileName)
+{
+  std::ifstream input(fileName);
+  if ( ! input ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open stack file " << fileName;
+    G4Exception("B4cCalorimeterStack::Load()",
+      "MyCode0018", JustWarning, msg);
+    return false;
+  }
+
+  // The current stack is kept if the file is not valid
+  std::vector<Module> modules;
+  modules.swap(fModules);
+
+  std::string line;
+  G4int lineNumber = 0;
+  G4bool valid = true;
+  while ( valid && std::getline(input, line) ) {
+    ++lineNumber;
+    std::istringstream tokens(line);
+    std::string first;
+    if ( ! (tokens >> first) || first[0] == '#' ) continue;
+
+    Module module;
+    std::string section, absorber, active, readout;
+    module.name = first;
+    tokens >> section >> module.nofLayers 
+           >> absorber >> module.absorberThickness
+           >> active >> module.activeThickness >> readout;
+
+    G4int sectionIndex = -1;
+    for ( G4int i=0; i<kNofSections; ++i ) {
+      if ( section == kSectionNames[i] ) sectionIndex = i;
+    }
+    G4int readoutIndex = -1;
+    for ( G4int i=kNone; i<=kBoth; ++i ) {
+      if ( readout == kReadoutNames[i] ) readoutIndex = i;
+    }
+
+    if ( tokens.fail() || sectionIndex < 0 || readoutIndex < 0 ) {
+      G4ExceptionDescription msg;
+      msg << "Cannot parse line " << lineNumber << " of " << fileName 
+          << ": " << line;
+      G4Exception("B4cCalorimeterStack::Load()",
+        "MyCode0018", JustWarning, msg);
+      valid = false;
+      break;
+    }
+
+    module.section = Section(sectionIndex);
+    module.readout = readoutIndex;
+    if ( absorber != "-" ) module.absorberMaterial = absorber;
+    if ( active != "-" ) module.activeMaterial = active;
+    module.absorberThickness *= mm;
+    module.activeThickness *= mm;
+    valid = AddModule(module);
+  }
+
+  if ( valid && fModules.empty() ) {
+    G4ExceptionDescription msg;
+    msg << "No module in stack file " << fileName;
+    G4Exception("B4cCalorimeterStack::Load()",
+      "MyCode0018", JustWarning, msg);
+    valid = false;
+  }
+
+  if ( ! valid ) {
+    fModules.swap(modules);
+    return false;
+  }
+
+  G4cout << "Loaded " << fModules.size() << " calorimeter modules from " 
+         << fileName << G4endl;
+
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterStack::SetSampling(G4double absoThickness, 
+                                      G4double gapThickness, 
+                                      G4int nofLayers, 
+                                      G4double hadLayerThickness,
+                                      G4int feLayers, G4int wLayers)
+{
+  // The EM sampling calorimeter followed by the iron and the tungsten
+  // hadronic calorimeters; the modules without layers are left out
+  Clear();
+
+  Module em;
+  em.name = "EM";
+  em.section = kEm;
+  em.nofLayers = nofLayers;
+  em.absorberMaterial = "G4_Pb";
+  em.absorberThickness = std::max(absoThickness, 0.);
+  em.activeMaterial = "liquidArgon";
+  em.activeThickness = std::max(gapThickness, 0.);
+  em.readout = kBoth;
+  if ( nofLayers > 0 && em.GetLayerThickness() > 0. ) AddModule(em);
+
+  const char* names[] = { "Fe", "W" };
+  const char* materials[] = { "G4_Fe", "G4_W" };
+  const G4int layers[] = { feLayers, wLayers };
+  for ( G4int i=0; i<2; ++i ) {
+    if ( layers[i] <= 0 || hadLayerThickness <= 0. ) continue;
+    Module had;
+    had.name = names[i];
+    had.section = Section(kFe + i);
+    had.nofLayers = layers[i];
+    had.absorberMaterial = materials[i];
+    had.absorberThickness = hadLayerThickness;
+    had.readout = kAbsorber;
+    AddModule(had);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cCalorimeterStack::AddModule(const Module& module)
+{
+  G4ExceptionDescription msg;
+  if ( module.nofLayers <= 0 || module.absorberThickness < 0. ||
+       module.activeThickness < 0. || module.GetLayerThickness() <= 0. ) {
+    msg << "Module " << module.name << " has no layers";
+  }
+  else if ( ( module.absorberThickness > 0. && 
+              module.absorberMaterial.empty() ) ||
+            ( module.activeThickness > 0. && 
+              module.activeMaterial.empty() ) ) {
+    msg << "Module " << module.name << " has a plate without material";
+  }
+  else {
+    for ( size_t i=0; i<fModules.size(); ++i ) {
+      if ( fModules[i].name == module.name ) {
+        msg << "Module " << module.name << " is defined twice";
+      }
+    }
+  }
+
+  if ( ! msg.str().empty() ) {
+    G4Exception("B4cCalorimeterStack::AddModule()",
+      "MyCode0018", JustWarning, msg);
+    return false;
+  }
+
+  fModules.push_back(module);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCalorimeterStack::Clear()
+{
+  fModules.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4Material* B4cCalorimeterStack::FindMaterial(const G4String& name)
+{
+  // The materials defined by the detector construction first, the NIST
+  // materials are built on demand
+  G4Material* material = G4Material::GetMaterial(name, false);
+  if ( ! material ) {
+    material = G4NistManager::Instance()->FindOrBuildMaterial(name);
+  }
+  return material;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* B4cCalorimeterStack::GetSectionName(G4int section)
+{
+  return kSectionNames[section];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const B4cCalorimeterStack::Module* 
+B4cCalorimeterStack::GetFirstModule(Section section) const
+{
+  for ( size_t i=0; i<fModules.size(); ++i ) {
+    if ( fModules[i].section == section ) return &fModules[i];
+  }
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cCalorimeterStack::GetNofLayers() const
+{
+  G4int nofLayers = 0;
+  for ( size_t i=0; i<fModules.size(); ++i ) {
+    nofLayers += fModules[i].nofLayers;
+  }
+  return nofLayers;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cCalorimeterStack::GetNofLayers(Section section) const
+{
+  G4int nofLayers = 0;
+  for ( size_t i=0; i<fModules.size(); ++i ) {
+    if ( fModules[i].section == section ) nofLayers += fModules[i].nofLayers;
+  }
+  return nofLayers;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cCalorimeterStack::GetNofReadoutLayers(Section section, 
+                                               G4bool active) const
+{
+  G4int nofLayers = 0;
+  for ( size_t i=0; i<fModules.size(); ++i ) {
+    if ( fModules[i].section == section && fModules[i].HasReadout(active) ) {
+      nofLayers += fModules[i].nofLayers;
+    }
+  }
+  return nofLayers;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cCalorimeterStack::GetFirstLayer(G4int index) const
+{
+  G4int nofLayers = 0;
+  for ( G4int i=0; i<index; ++i ) nofLayers += fModules[i].nofLayers;
+  return nofLayers;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cCalorimeterStack::GetFirstSectionLayer(G4int index) const
+{
+  G4int nofLayers = 0;
+  for ( G4int i=0; i<index; ++i ) {
+    if ( fModules[i].section == fModules[index].section ) {
+      nofLayers += fModules[i].nofLayers;
+    }
+  }
+  return nofLayers;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cCalorimeterStack::GetThickness() const
+{
+  G4double thickness = 0.;
+  for ( size_t i=0; i<fModules.size(); ++i ) {
+    thickness += fModules[i].GetThickness();
+  }
+  return thickness;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cCalorimeterStack::GetThickness(Section section) const
+{
+  G4double thickness = 0.;
+  for ( size_t i=0; i<fModules.size(); ++i ) {
+    if ( fModules[i].section == section ) {
+      thickness += fModules[i].GetThickness();
+    }
+  }
+  return thickness;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,78 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cCellMap.cc
+/// \brief Implementation of the B4cCellMap class
+
+#include "B4cCellMap.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cCellMap::B4cCellMap()
+ : fSlots(64),
+   fFiredSlots(),
+   fMask(63)
+{
+  fFiredSlots.reserve(32);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cCellMap::~B4cCellMap()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCellMap::Clear()
+{
+  for ( std::size_t i=0; i<fFiredSlots.size(); ++i ) {
+    Slot& slot = fSlots[fFiredSlots[i]];
+    slot.key = -1;
+    slot.edep = 0.;
+  }
+  fFiredSlots.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cCellMap::Grow()
+{
+  // Double the table and re-insert the fired cells, keeping their order
+  std::vector<Slot> oldSlots(2*fSlots.size());
+  oldSlots.swap(fSlots);
+  fMask = fSlots.size() - 1;
+
+  for ( std::size_t i=0; i<fFiredSlots.size(); ++i ) {
+    const Slot& oldSlot = oldSlots[fFiredSlots[i]];
+    G4int slot = FindSlot(oldSlot.key);
+    fSlots[slot] = oldSlot;
+    fFiredSlots[i] = slot;
+  }
+  fFiredSlots.reserve(fSlots.size()/2);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -30,16 +30,26 @@
 
 #include "B4cDetectorConstruction.hh"
 #include "B4cCalorimeterSD.hh"
+#include "B4cShowerLibraryModel.hh"
+#include "B4cParameterisedShowerModel.hh"
+#include "B4cRegionSettings.hh"
+#include "B4cOverlapCache.hh"
 #include "G4Material.hh"
 #include "G4NistManager.hh"
 
 #include "G4Box.hh"
 #include "G4LogicalVolume.hh"
-#include "G4UserLimits.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
 #include "G4PVPlacement.hh"
 #include "G4PVReplica.hh"
 #include "G4GlobalMagFieldMessenger.hh"
 #include "G4AutoDelete.hh"
+#include "G4GenericMessenger.hh"
+#include "G4StateManager.hh"
+#include "G4UImanager.hh"
+#include "G4Timer.hh"
 
 #include "G4SDManager.hh"
 
@@ -49,70 +59,476 @@
 #include "G4PhysicalConstants.hh"
 #include "G4SystemOfUnits.hh"
 
+#include <algorithm>
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4ThreadLocal 
 G4GlobalMagFieldMessenger* B4cDetectorConstruction::fMagFieldMessenger = 0; 
+G4ThreadLocal 
+B4cShowerLibraryModel* B4cDetectorConstruction::fShowerLibraryModel = 0; 
+G4ThreadLocal B4cParameterisedShowerModel* 
+B4cDetectorConstruction::fParameterisedShowerModel = 0; 
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  // Return the calorimeter SD of this thread with the given name, creating
+  // it on the first call. The SD manager keeps calling the detectors
+  // registered first, so they must be reused when the geometry is rebuilt.
+  B4cCalorimeterSD* GetCalorimeterSD(const G4String& name,
+                                     const G4String& hitsCollectionName,
+                                     G4int nofCells, G4double radialRange,
+                                     G4int nofCellsX, G4int nofCellsY,
+                                     G4double sizeXY)
+  {
+    B4cCalorimeterSD* calorSD
+      = static_cast<B4cCalorimeterSD*>(
+          G4SDManager::GetSDMpointer()->FindSensitiveDetector(name, false));
+    if ( calorSD ) {
+      calorSD->SetNofCells(nofCells);
+    }
+    else {
+      calorSD = new B4cCalorimeterSD(name, hitsCollectionName, nofCells);
+    }
+    calorSD->SetRadialRange(radialRange);
+    calorSD->SetCellGrid(nofCellsX, nofCellsY, sizeXY);
+    return calorSD;
+  }
+
+  // Return the region with the given name, creating it on the first call.
+  // The regions are kept when the geometry is rebuilt.
+  G4Region* GetRegion(const G4String& name)
+  {
+    G4Region* region = G4RegionStore::GetInstance()->GetRegion(name, false);
+    if ( ! region ) region = new G4Region(name);
+    return region;
+  }
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-B4cDetectorConstruction::B4cDetectorConstruction(G4UserLimits* limits, G4double absoThickness_, G4double gapThickness_, G4int noLayers, G4double hadLayerThickness_, G4int feLayers_, G4int wLayers_)
+B4cDetectorConstruction::B4cDetectorConstruction(G4double absoThickness_, G4double gapThickness_, G4int noLayers, G4double hadLayerThickness_, G4int feLayers_, G4int wLayers_)
  : G4VUserDetectorConstruction(),
-   fLimits(limits),
-   fCheckOverlaps(true),
+   fEmRegionSettings(0),
+   fFeRegionSettings(0),
+   fWRegionSettings(0),
+   fOverlapCache(0),
+   fSDMessenger(0),
+   fDetMessenger(0),
+   fShowerLibMessenger(0),
+   fParamMessenger(0),
+   fPending(),
+   fStack(),
+   fCheckOverlaps(false),
+   fTightWorld(false),
+   fSmartless(),
    fNofLayers(noLayers),
    calorSizeXY(10*cm),
    absoThickness(absoThickness_),
    gapThickness(gapThickness_),
    hadLayerThickness(hadLayerThickness_),
    fFeLayers(feLayers_),
-   fWLayers(wLayers_)
+   fWLayers(wLayers_),
+   fGapNofCellsX(1),
+   fGapNofCellsY(1),
+   fFeNofCellsX(1),
+   fFeNofCellsY(1),
+   fWNofCellsX(1),
+   fWNofCellsY(1)
 
 {
-    layerThickness = absoThickness + gapThickness;
+  fStack.SetSampling(absoThickness, gapThickness, fNofLayers, 
+                     hadLayerThickness, fFeLayers, fWLayers);
+  ComputeParameters();
+
+  // Production cuts and user limits of the calorimeter sections; 
+  // the tracks below 2 MeV are killed in all of them by default
+  fEmRegionSettings = new B4cRegionSettings("/B4/region/em/",
+    "EM calorimeter region control", 0.7*mm, 2*MeV);
+  fFeRegionSettings = new B4cRegionSettings("/B4/region/fe/",
+    "Iron calorimeter region control", 0.7*mm, 2*MeV);
+  fWRegionSettings = new B4cRegionSettings("/B4/region/w/",
+    "Tungsten calorimeter region control", 0.7*mm, 2*MeV);
+
+  // Overlap check of the geometries not validated before
+  fOverlapCache = new B4cOverlapCache();
+
+  // Options of the calorimeter SDs; the SDs of all threads read them at
+  // each event, so the commands are not passed to the workers
+  B4cCalorimeterSD::Options& sdOptions = B4cCalorimeterSD::GetOptions();
+  fSDMessenger = new G4GenericMessenger(&sdOptions, "/B4/sd/",
+    "Calorimeter sensitive detectors control");
+  fSDMessenger->DeclareProperty("flat", sdOptions.flat,
+    "Accumulate steps in flat per-layer buffers instead of hits.")
+    .SetToBeBroadcasted(false);
+  fSDMessenger->DeclareProperty("storeHits", sdOptions.storeHits,
+    "Materialise the hits collections at the end of event (flat mode).")
+    .SetToBeBroadcasted(false);
+  fSDMessenger->DeclareProperty("timing", sdOptions.timing,
+    "Measure the time per step spent in the sensitive detectors.")
+    .SetToBeBroadcasted(false);
+  fSDMessenger->DeclareProperty("radialBins", sdOptions.radialBins,
+    "Number of radial bins of the transverse profile (next run).")
+    .SetParameterName("nofBins", false)
+    .SetRange("nofBins>0")
+    .SetToBeBroadcasted(false);
+  fSDMessenger->DeclareProperty("voxelsX", sdOptions.voxelsX,
+    "Number of voxels in x of the shower image, 0 = no image (next run).")
+    .SetParameterName("nofVoxels", false)
+    .SetRange("nofVoxels>=0")
+    .SetToBeBroadcasted(false);
+  fSDMessenger->DeclareProperty("voxelsY", sdOptions.voxelsY,
+    "Number of voxels in y of the shower image, 0 = no image (next run).")
+    .SetParameterName("nofVoxels", false)
+    .SetRange("nofVoxels>=0")
+    .SetToBeBroadcasted(false);
+
+  // Geometry parameters, applied together by /B4/det/update
+  fDetMessenger = new G4GenericMessenger(this, "/B4/det/",
+    "Calorimeter geometry control");
+  fDetMessenger->DeclarePropertyWithUnit("absorber", "mm", 
+    fPending.absoThickness, "Thickness of the EM absorber plates.")
+    .SetParameterName("thickness", false)
+    .SetRange("thickness>=0")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclarePropertyWithUnit("gap", "mm", 
+    fPending.gapThickness, "Thickness of the EM gaps.")
+    .SetParameterName("thickness", false)
+    .SetRange("thickness>=0")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclareProperty("emLayers", fPending.nofLayers,
+    "Number of EM layers.")
+    .SetParameterName("nofLayers", false)
+    .SetRange("nofLayers>=0")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclarePropertyWithUnit("hadronic", "mm", 
+    fPending.hadLayerThickness, "Thickness of the hadronic layers.")
+    .SetParameterName("thickness", false)
+    .SetRange("thickness>=0")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclareProperty("feLayers", fPending.feLayers,
+    "Number of iron layers (hadronic calorimeter).")
+    .SetParameterName("nofLayers", false)
+    .SetRange("nofLayers>=0")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclareProperty("wLayers", fPending.wLayers,
+    "Number of tungsten layers (hadronic calorimeter).")
+    .SetParameterName("nofLayers", false)
+    .SetRange("nofLayers>=0")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclarePropertyWithUnit("sizeXY", "cm", 
+    fPending.sizeXY, "Transverse size of the calorimeter.")
+    .SetParameterName("size", false)
+    .SetRange("size>0")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclareMethod("update", 
+    &B4cDetectorConstruction::UpdateGeometry,
+    "Apply the geometry parameters set above: only the geometry is\n"
+    "rebuilt, the physics tables and the analysis session are kept.\n"
+    "The stack read with /B4/det/stack is replaced.")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclareMethod("stack", 
+    &B4cDetectorConstruction::LoadStack,
+    "Read the calorimeter modules from a file, one per line:\n"
+    "name em|fe|w layers absorber thickness(mm) active thickness(mm)\n"
+    "none|absorber|active|both; the geometry is rebuilt as by update.")
+    .SetParameterName("fileName", false)
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclareProperty("tightWorld", fTightWorld,
+    "Fit the world to the calorimeter, 1 mm upstream and downstream,\n"
+    "instead of 1.2 times its thickness around the EM section; applied\n"
+    "at the next build (/B4/det/update or /B4/det/stack).")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclareMethod("smartless", 
+    &B4cDetectorConstruction::SetSmartless,
+    "Set the smartless value of the voxelisation of a logical volume,\n"
+    "e.g. a module (the mother of the layer replica): /B4/det/smartless EM 4;\n"
+    "applied now if the volume exists, and after each rebuild.")
+    .SetToBeBroadcasted(false);
+
+  // Transverse readout grids, applied to the SDs of all threads when the
+  // geometry is (re)built
+  fDetMessenger->DeclareMethod("gapCells", 
+    &B4cDetectorConstruction::SetGapCellGrid,
+    "Set the number of readout cells in x and y of the EM gap layers;\n"
+    "applied after /run/reinitializeGeometry.")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclareMethod("feCells", 
+    &B4cDetectorConstruction::SetFeCellGrid,
+    "Set the number of readout cells in x and y of the iron layers;\n"
+    "applied after /run/reinitializeGeometry.")
+    .SetToBeBroadcasted(false);
+  fDetMessenger->DeclareMethod("wCells", 
+    &B4cDetectorConstruction::SetWCellGrid,
+    "Set the number of readout cells in x and y of the tungsten layers;\n"
+    "applied after /run/reinitializeGeometry.")
+    .SetToBeBroadcasted(false);
+
+  // Options of the shower library models of all threads
+  B4cShowerLibraryModel::Options& showerLibOptions 
+    = B4cShowerLibraryModel::GetOptions();
+  fShowerLibMessenger = new G4GenericMessenger(&showerLibOptions, 
+    "/B4/showerLib/", "Frozen shower library control");
+  fShowerLibMessenger->DeclareMethod("mode", 
+    &B4cShowerLibraryModel::Options::SetMode,
+    "Shower library mode: off, replay, record or validate.")
+    .SetCandidates("off replay record validate")
+    .SetToBeBroadcasted(false);
+  fShowerLibMessenger->DeclareProperty("file", showerLibOptions.fileName,
+    "Shower library file.")
+    .SetToBeBroadcasted(false);
+  fShowerLibMessenger->DeclarePropertyWithUnit("maxEnergy", "MeV", 
+    showerLibOptions.maxEnergy,
+    "Energy below which the particles are replaced by library showers.")
+    .SetToBeBroadcasted(false);
+  fShowerLibMessenger->DeclarePropertyWithUnit("minEnergy", "MeV", 
+    showerLibOptions.minEnergy,
+    "Lowest energy of the recorded showers.")
+    .SetToBeBroadcasted(false);
+  fShowerLibMessenger->DeclareProperty("energyBins", 
+    showerLibOptions.nofEnergyBins,
+    "Number of logarithmic energy bins of the recorded library.")
+    .SetParameterName("nofBins", false)
+    .SetRange("nofBins>0")
+    .SetToBeBroadcasted(false);
+  fShowerLibMessenger->DeclareProperty("maxShowersPerBin", 
+    showerLibOptions.maxShowersPerBin,
+    "Maximum number of recorded showers per particle, energy bin and thread.")
+    .SetToBeBroadcasted(false);
+  fShowerLibMessenger->DeclarePropertyWithUnit("spotSize", "mm", 
+    showerLibOptions.spotSize,
+    "Size of the clusters of the recorded energy deposits.")
+    .SetToBeBroadcasted(false);
+
+  // Options of the parameterised shower models of all threads
+  B4cParameterisedShowerModel::Options& paramOptions 
+    = B4cParameterisedShowerModel::GetOptions();
+  fParamMessenger = new G4GenericMessenger(&paramOptions, 
+    "/B4/param/", "Parameterised EM showers control");
+  fParamMessenger->DeclareProperty("enable", paramOptions.enable,
+    "Replace the EM showers in the EM calorimeter by parameterised ones.")
+    .SetToBeBroadcasted(false);
+  fParamMessenger->DeclarePropertyWithUnit("minEnergy", "GeV", 
+    paramOptions.minEnergy,
+    "Energy above which the showers are parameterised.")
+    .SetToBeBroadcasted(false);
+  fParamMessenger->DeclareProperty("nofSpots", paramOptions.nofSpots,
+    "Number of energy spots per parameterised shower.")
+    .SetParameterName("nofSpots", false)
+    .SetRange("nofSpots>0")
+    .SetToBeBroadcasted(false);
+  fParamMessenger->DeclareProperty("eOverMip", paramOptions.eOverMip,
+    "e/mip ratio of the gap sampling fraction (next run).")
+    .SetToBeBroadcasted(false);
+}
 
-    if(fFeLayers <= 0 && fWLayers <= 0){
-    	hadLayerThickness = 0;
-    }
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-    if(hadLayerThickness <= 0){
-    	fFeLayers = 0;
-    	fWLayers = 0;
-    }
+B4cDetectorConstruction::~B4cDetectorConstruction()
+{ 
+  delete fSDMessenger;
+  delete fDetMessenger;
+  delete fShowerLibMessenger;
+  delete fParamMessenger;
+  delete fEmRegionSettings;
+  delete fFeRegionSettings;
+  delete fWRegionSettings;
+  delete fOverlapCache;
+}  
 
-    if(fNofLayers <= 0){
-    	absoThickness = 0;
-    	gapThickness = 0;
-    }
-    if(absoThickness <= 0 && gapThickness <= 0){
-    	fNofLayers = 0;
-    }
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-    if(fNofLayers == 0 && fFeLayers == 0 && fWLayers == 0){
-    	G4ExceptionDescription msg;
-        msg << "Calorimeter does not seem to have any layers";
-        G4Exception("B4DetectorConstruction::B4cDetectorConstruction()",
-          "MyCode0001", FatalException, msg);
-    }
+void B4cDetectorConstruction::SetGapCellGrid(G4int nofCellsX, G4int nofCellsY)
+{
+  fGapNofCellsX = std::max(nofCellsX, 1);
+  fGapNofCellsY = std::max(nofCellsY, 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cDetectorConstruction::SetFeCellGrid(G4int nofCellsX, G4int nofCellsY)
+{
+  fFeNofCellsX = std::max(nofCellsX, 1);
+  fFeNofCellsY = std::max(nofCellsY, 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cDetectorConstruction::SetWCellGrid(G4int nofCellsX, G4int nofCellsY)
+{
+  fWNofCellsX = std::max(nofCellsX, 1);
+  fWNofCellsY = std::max(nofCellsY, 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cDetectorConstruction::SetGeometry(
+                            G4double absoThickness_, G4double gapThickness_,
+                            G4int noLayers, G4double hadLayerThickness_,
+                            G4int feLayers_, G4int wLayers_)
+{
+  // The new values are used by the next Construct(), which the run manager
+  // calls after /run/reinitializeGeometry
+  absoThickness = absoThickness_;
+  gapThickness = gapThickness_;
+  fNofLayers = noLayers;
+  hadLayerThickness = hadLayerThickness_;
+  fFeLayers = feLayers_;
+  fWLayers = wLayers_;
+
+  fStack.SetSampling(absoThickness, gapThickness, fNofLayers, 
+                     hadLayerThickness, fFeLayers, fWLayers);
+  ComputeParameters();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cDetectorConstruction::SetCalorimeterSizeXY(G4double sizeXY)
+{
+  // used by the next Construct(), as SetGeometry()
+  calorSizeXY = sizeXY;
+
+  ComputeParameters();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cDetectorConstruction::UpdateGeometry()
+{
+  G4Timer timer;
+  timer.Start();
+
+  Parameters pending = fPending;
+
+  // A stack without layers cannot be built, the current geometry is kept
+  B4cCalorimeterStack stack;
+  stack.SetSampling(pending.absoThickness, pending.gapThickness, 
+                    pending.nofLayers, pending.hadLayerThickness, 
+                    pending.feLayers, pending.wLayers);
+  if ( stack.GetNofModules() == 0 ) {
+    G4ExceptionDescription msg;
+    msg << "The /B4/det/ parameters give a calorimeter without layers;" 
+        << G4endl;
+    msg << "the current geometry is kept.";
+    G4Exception("B4cDetectorConstruction::UpdateGeometry()",
+      "MyCode0021", JustWarning, msg);
+    return;
+  }
+
+  SetCalorimeterSizeXY(pending.sizeXY);
+  SetGeometry(pending.absoThickness, pending.gapThickness, pending.nofLayers,
+              pending.hadLayerThickness, pending.feLayers, pending.wLayers);
+
+  RebuildGeometry(timer);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cDetectorConstruction::LoadStack(const G4String& fileName)
+{
+  G4Timer timer;
+  timer.Start();
+
+  // the current stack is kept if the file is not valid
+  if ( ! fStack.Load(fileName) ) return;
+  ComputeParameters();
+
+  RebuildGeometry(timer);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-    if(fFeLayers > 0 && fWLayers > 0){
+void B4cDetectorConstruction::SetSmartless(const G4String& volumeName, 
+                                           G4double smartless)
+{
+  if ( smartless <= 0. ) {
+    G4ExceptionDescription msg;
+    msg << "Smartless of " << volumeName << " must be positive: " 
+        << smartless << "; command ignored.";
+    G4Exception("B4cDetectorConstruction::SetSmartless()",
+      "MyCode0020", JustWarning, msg);
+    return;
+  }
+  fSmartless[volumeName] = smartless;
+
+  // Before the first initialisation, it is applied when the geometry
+  // is built
+  if ( G4StateManager::GetStateManager()->GetCurrentState() 
+       == G4State_PreInit ) return;
+
+  G4LogicalVolume* volume 
+    = G4LogicalVolumeStore::GetInstance()->GetVolume(volumeName, false);
+  if ( ! volume ) return;
+
+  // The voxels are recomputed when the geometry is closed at the next run
+  volume->SetSmartless(smartless);
+  G4UImanager::GetUIpointer()->ApplyCommand("/run/geometryModified");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cDetectorConstruction::RebuildGeometry(G4Timer& timer)
+{
+  // Before the first initialisation, /run/initialize builds the geometry
+  if ( G4StateManager::GetStateManager()->GetCurrentState() 
+       == G4State_PreInit ) return;
+
+  // Rebuild the geometry now (in the workers at the next run); the 
+  // physics is already initialised and is not touched
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
+  UImanager->ApplyCommand("/run/reinitializeGeometry true");
+  UImanager->ApplyCommand("/run/initialize");
+
+  timer.Stop();
+  G4cout 
+    << " Geometry rebuilt in " << timer.GetRealElapsed() << " s: "
+    << fStack.GetNofModules() << " modules, " << fStack.GetNofLayers()
+    << " layers, " << calorThickness/cm << " cm deep, " 
+    << calorSizeXY/cm << " cm wide" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cDetectorConstruction::ComputeParameters()
+{
+    if(fStack.GetNofModules() == 0){
     	G4ExceptionDescription msg;
-        msg << "You have two different types of hadronic calorimeters!";
-        G4Exception("B4DetectorConstruction::B4cDetectorConstruction()",
-          "MyCode0001", FatalException, msg);
+        msg << "Calorimeter does not seem to have any layers";
+        G4Exception("B4cDetectorConstruction::ComputeParameters()",
+          "MyCode0022", FatalException, msg);
+        return;
     }
 
+    // The EM parameters are the ones of the first EM module, the numbers
+    // of layers are summed over the modules of each section
+    const B4cCalorimeterStack::Module* em 
+      = fStack.GetFirstModule(B4cCalorimeterStack::kEm);
+    const B4cCalorimeterStack::Module* had 
+      = fStack.GetFirstModule(B4cCalorimeterStack::kFe);
+    if(!had) had = fStack.GetFirstModule(B4cCalorimeterStack::kW);
+
+    fNofLayers = fStack.GetNofLayers(B4cCalorimeterStack::kEm);
+    absoThickness = em ? em->absorberThickness : 0.;
+    gapThickness = em ? em->activeThickness : 0.;
+    layerThickness = absoThickness + gapThickness;
+    fFeLayers = fStack.GetNofLayers(B4cCalorimeterStack::kFe);
+    fWLayers = fStack.GetNofLayers(B4cCalorimeterStack::kW);
+    hadLayerThickness = had ? had->GetLayerThickness() : 0.;
 
-    calorThickness = (fNofLayers * layerThickness) + ((fFeLayers + fWLayers) * hadLayerThickness);
+    calorThickness = fStack.GetThickness();
     worldSizeXY = 1.2 * calorSizeXY;
     worldSizeZ  = 1.2 * calorThickness;
-}
 
-//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
-
-B4cDetectorConstruction::~B4cDetectorConstruction()
-{ 
-}  
+    // the /B4/det/ commands start from the geometry set here
+    fPending.absoThickness = absoThickness;
+    fPending.gapThickness = gapThickness;
+    fPending.nofLayers = fNofLayers;
+    fPending.hadLayerThickness = hadLayerThickness;
+    fPending.feLayers = fFeLayers;
+    fPending.wLayers = fWLayers;
+    fPending.sizeXY = calorSizeXY;
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -136,6 +552,9 @@ void B4cDetectorConstruction::DefineMaterials()
   nistManager->FindOrBuildMaterial("G4_Fe");
   nistManager->FindOrBuildMaterial("G4_W");
   
+  // The materials below survive a geometry rebuild, define them only once
+  if ( G4Material::GetMaterial("Galactic", false) ) return;
+
   // Liquid argon material
   G4double a;  // mass of a mole;
   G4double z;  // z=mean number of protons;  
@@ -155,28 +574,14 @@ void B4cDetectorConstruction::DefineMaterials()
 
 G4VPhysicalVolume* B4cDetectorConstruction::DefineVolumes()
 {
-  // Geometry parameters
-  //fNofLayers = 10;
-
-  //Moved this to header file for retrieval later
-  /*
-  G4double absoThickness = 10.*mm;
-  G4double gapThickness =  5.*mm;
-  G4double calorSizeXY  = 10.*cm;
-
-  G4double layerThickness = absoThickness + gapThickness;
-  G4double calorThickness = fNofLayers * layerThickness;
-  G4double worldSizeXY = 1.2 * calorSizeXY;
-  G4double worldSizeZ  = 1.2 * calorThickness; */
-  
+  G4Timer timer;
+  timer.Start();
+  size_t nofVolumes = G4LogicalVolumeStore::GetInstance()->size();
+
   // Get materials
   G4Material* defaultMaterial = G4Material::GetMaterial("Galactic");
-  G4Material* absorberMaterial = G4Material::GetMaterial("G4_Pb"); //Lead or Copper?
-  G4Material* gapMaterial = G4Material::GetMaterial("liquidArgon");
-  G4Material* ironMaterial = G4Material::GetMaterial("G4_Fe");
-  G4Material* tungstenMaterial = G4Material::GetMaterial("G4_W");
   
-  if ( ! defaultMaterial || ! absorberMaterial || ! gapMaterial || ! ironMaterial || ! tungstenMaterial ) {
+  if ( ! defaultMaterial ) {
     G4ExceptionDescription msg;
     msg << "Cannot retrieve materials already defined."; 
     G4Exception("B4DetectorConstruction::DefineVolumes()",
@@ -184,17 +589,14 @@ G4VPhysicalVolume* B4cDetectorConstruction::DefineVolumes()
   }  
 
   //     
-  // World
+  // World: its half length is 1.2 times the calorimeter thickness, or
+  // the half calorimeter thickness + 1 mm in the tight world
   //
-
-  G4double emThickness = fNofLayers * layerThickness;
-  G4double feThickness = fFeLayers * hadLayerThickness;
-  G4double wThickness = fWLayers * hadLayerThickness;
-
-
+  G4double worldHalfZ 
+    = fTightWorld ? calorThickness/2 + 1*mm : worldSizeZ;
   G4VSolid* worldS 
     = new G4Box("World",           // its name
-                 worldSizeXY/2, worldSizeXY/2, worldSizeZ/*/2*/); // its size
+                 worldSizeXY/2, worldSizeXY/2, worldHalfZ); // its size
                          
   G4LogicalVolume* worldLV
     = new G4LogicalVolume(
@@ -213,294 +615,195 @@ G4VPhysicalVolume* B4cDetectorConstruction::DefineVolumes()
                  0,                // copy number
                  fCheckOverlaps);  // checking overlaps 
 
+  worldLV->SetVisAttributes (G4VisAttributes::Invisible);
 
-  G4LogicalVolume* calorLV = 0;
-  G4LogicalVolume* calorFeLV = 0;
-  G4LogicalVolume* calorWLV = 0;
-
-
-
-  //
-  // EM Calorimeter
-  //
-  if(fNofLayers > 0){
-	  //
-	  // Calorimeter
-	  //
-	  G4VSolid* calorimeterS
-	    = new G4Box("Calorimeter",     // its name
-	                 calorSizeXY/2, calorSizeXY/2, emThickness/2); // its size
-
-	 calorLV = new G4LogicalVolume(
-	                 calorimeterS,     // its solid
-	                 defaultMaterial,  // its material
-	                 "Calorimeter");   // its name
-
-	  new G4PVPlacement(
-	                 0,                // no rotation
-	                 G4ThreeVector(),  // at (0,0,0)
-	                 calorLV,          // its logical volume
-	                 "Calorimeter",    // its name
-	                 worldLV,          // its mother  volume
-	                 false,            // no boolean operation
-	                 0,                // copy number
-	                 fCheckOverlaps);  // checking overlaps
-
-	  //
-	  // Layer
-	  //
-	  G4VSolid* layerS
-		= new G4Box("Layer",           // its name
-					 calorSizeXY/2, calorSizeXY/2, layerThickness/2); //its size
-
-	  G4LogicalVolume* layerLV
-		= new G4LogicalVolume(
-					 layerS,           // its solid
-					 defaultMaterial,  // its material
-					 "Layer");         // its name
-
-	  new G4PVReplica(
-					 "Layer",          // its name
-					 layerLV,          // its logical volume
-					 calorLV,          // its mother
-					 kZAxis,           // axis of replication
-					 fNofLayers,        // number of replica
-					 layerThickness);  // width of replica
-
-	  //
-	  // Absorber
-	  //
-	  if(absoThickness > 0){
-	  G4VSolid* absorberS
-		= new G4Box("Abso",            // its name
-					 calorSizeXY/2, calorSizeXY/2, absoThickness/2); // its size
-
-	  G4LogicalVolume* absorberLV
-		= new G4LogicalVolume(
-					 absorberS,        // its solid
-					 absorberMaterial, // its material
-					 "AbsoLV");        // its name
-	  absorberLV->SetUserLimits(fLimits);
-
-	   new G4PVPlacement(
-					 0,                // no rotation
-					 G4ThreeVector(0., 0., -gapThickness/2), // its position
-					 absorberLV,       // its logical volume
-					 "Abso",           // its name
-					 layerLV,          // its mother  volume
-					 false,            // no boolean operation
-					 0,                // copy number
-					 fCheckOverlaps);  // checking overlaps
-	  }
-
-	   //
-	   // Gap
-	   //
-	   if(gapThickness > 0){
-	  G4VSolid* gapS
-		= new G4Box("Gap",             // its name
-					 calorSizeXY/2, calorSizeXY/2, gapThickness/2); // its size
-
-	  G4LogicalVolume* gapLV
-		= new G4LogicalVolume(
-					 gapS,             // its solid
-					 gapMaterial,      // its material
-					 "GapLV");         // its name
-	  gapLV->SetUserLimits(fLimits);
-
-	  new G4PVPlacement(
-					 0,                // no rotation
-					 G4ThreeVector(0., 0., absoThickness/2), // its position
-					 gapLV,            // its logical volume
-					 "Gap",            // its name
-					 layerLV,          // its mother  volume
-					 false,            // no boolean operation
-					 0,                // copy number
-					 fCheckOverlaps);  // checking overlaps
-	   }
-  }
-
-
-
-   //
-   // Iron Hadron Calorimeter
-   //
-   if(fFeLayers > 0){
-
-		  //
-		  // Calorimeter
-		  //
-		  G4VSolid* calorimeterFe
-		    = new G4Box("CalorimeterFe",     // its name
-		                 calorSizeXY/2, calorSizeXY/2, feThickness/2); // its size
-
-		  calorFeLV = new G4LogicalVolume(
-		                 calorimeterFe,     // its solid
-		                 defaultMaterial,  // its material
-		                 "CalorimeterFe");   // its name
-
-		  new G4PVPlacement(
-		                 0,               // no rotation
-		                 G4ThreeVector(0,0,emThickness/2 + feThickness/2), // behind the em Calorimeter
-		                 calorFeLV,          // its logical volume
-		                 "CalorimeterFe",    // its name
-		                 worldLV,          // its mother  volume
-		                 false,            // no boolean operation
-		                 0,                // copy number
-		                 fCheckOverlaps);  // checking overlaps
-
-		  //
-		  // Layer
-		  //
-	   G4VSolid* layerFe
-		 = new G4Box("FeLayer",           // its name
-					  calorSizeXY/2, calorSizeXY/2, hadLayerThickness/2); //its size
-
-	   G4LogicalVolume* layerFeLV
-		 = new G4LogicalVolume(
-					  layerFe,           // its solid
-					  defaultMaterial,  // its material
-					  "FeLayer");         // its name
-
-	   new G4PVReplica(
-					  "FeLayer",          // its name
-					  layerFeLV,          // its logical volume
-					  calorFeLV,          // its mother
-					  kZAxis,           // axis of replication
-					  fFeLayers,        // number of replica
-					  hadLayerThickness);  // width of replica
-
-	   G4VSolid* ironS
-	     = new G4Box("iron",            // its name
-	                  calorSizeXY/2, calorSizeXY/2, hadLayerThickness/2); // its size
-
-	   G4LogicalVolume* ironLV
-	     = new G4LogicalVolume(
-	                  ironS,        // its solid
-	                  ironMaterial, // its material
-	                  "ironLV");        // its name
-	   ironLV->SetUserLimits(fLimits);
-
-	    new G4PVPlacement(
-	                  0,                // no rotation
-	                  G4ThreeVector(0., 0., 0), // its position
-	                  ironLV,       // its logical volume
-	                  "iron",           // its name
-	                  layerFeLV,          // its mother  volume
-	                  false,            // no boolean operation
-	                  0,                // copy number
-	                  fCheckOverlaps);  // checking overlaps
-   }
-
-   //
-   // Tungsten Hadron Calorimeter
-   //
-   if(fWLayers > 0){
-
-		  //
-		  // Calorimeter
-		  //
-		  G4VSolid* calorimeterW
-		    = new G4Box("CalorimeterW",     // its name
-		                 calorSizeXY/2, calorSizeXY/2, wThickness/2); // its size
-
-		  calorWLV = new G4LogicalVolume(
-		                 calorimeterW,     // its solid
-		                 defaultMaterial,  // its material
-		                 "CalorimeterW");   // its name
-
-		  new G4PVPlacement(
-		                 0,               // no rotation
-		                 G4ThreeVector(0,0,(emThickness/2) + (feThickness) + (wThickness/2)), // behind other calos
-		                 calorWLV,          // its logical volume
-		                 "CalorimeterW",    // its name
-		                 worldLV,          // its mother  volume
-		                 false,            // no boolean operation
-		                 0,                // copy number
-		                 fCheckOverlaps);  // checking overlaps
-
-		  //
-		  // Layer
-		  //
-	   G4VSolid* layerW
-		 = new G4Box("WLayer",           // its name
-					  calorSizeXY/2, calorSizeXY/2, hadLayerThickness/2); //its size
-
-	   G4LogicalVolume* layerWLV
-		 = new G4LogicalVolume(
-					  layerW,           // its solid
-					  defaultMaterial,  // its material
-					  "WLayer");         // its name
-	   layerWLV->SetUserLimits(fLimits);
-
-	   new G4PVReplica(
-					  "WLayer",          // its name
-					  layerWLV,          // its logical volume
-					  calorWLV,          // its mother
-					  kZAxis,           // axis of replication
-					  fWLayers,        // number of replica
-					  hadLayerThickness);  // width of replica
-
-	   G4VSolid* tungstenS
-	     = new G4Box("tungsten",            // its name
-	                  calorSizeXY/2, calorSizeXY/2, hadLayerThickness/2); // its size
-
-	   G4LogicalVolume* tungstenLV
-	     = new G4LogicalVolume(
-	                  tungstenS,        // its solid
-	                  tungstenMaterial, // its material
-	                  "tungstenLV");        // its name
-
-	    new G4PVPlacement(
-	                  0,                // no rotation
-	                  G4ThreeVector(0., 0., 0), // its position
-	                  tungstenLV,       // its logical volume
-	                  "tungsten",           // its name
-	                  layerWLV,          // its mother  volume
-	                  false,            // no boolean operation
-	                  0,                // copy number
-	                  fCheckOverlaps);  // checking overlaps
-   }
+  // Production cuts and user limits, and colour, of each section
+  const char* regionNames[B4cCalorimeterStack::kNofSections]
+    = { "EMCalorimeter", "FeCalorimeter", "WCalorimeter" };
+  B4cRegionSettings* regionSettings[B4cCalorimeterStack::kNofSections]
+    = { fEmRegionSettings, fFeRegionSettings, fWRegionSettings };
+  const G4Colour colours[B4cCalorimeterStack::kNofSections]
+    = { G4Colour(0,0,1.0), G4Colour(1.0,0,0,1.0), G4Colour(0,1.0,0,1.0) };
 
   //
-  // print parameters
+  // Modules, one behind the other; the stack starts half the thickness 
+  // of the EM modules upstream of the origin, so that the EM calorimeter
+  // of the default stack is centred there, or it is centred in the tight
+  // world
   //
   G4cout
     << G4endl 
     << "------------------------------------------------------------" << G4endl
-    << "---> The calorimeter is " << fNofLayers << " layers of: [ "
-    << absoThickness/mm << "mm of " << absorberMaterial->GetName() 
-    << " + "
-    << gapThickness/mm << "mm of " << gapMaterial->GetName() << " ] " << G4endl
-    << "as well as " << fFeLayers << " layers of: "
-    << hadLayerThickness/mm << "mm of " << ironMaterial->GetName()
-    << " + "
-    << fWLayers << " layers of: " << hadLayerThickness/mm << "mm of "
-    << tungstenMaterial->GetName() << G4endl
-    << "------------------------------------------------------------" << G4endl;
-  
-  //                                        
-  // Visualization attributes
-  //
-  worldLV->SetVisAttributes (G4VisAttributes::Invisible);
+    << "---> The calorimeter is " << fStack.GetNofModules() 
+    << " modules of " << calorSizeXY/cm << " cm x " << calorSizeXY/cm 
+    << " cm:" << G4endl;
+
+  G4double zFront = fTightWorld 
+                  ? - calorThickness/2
+                  : - fStack.GetThickness(B4cCalorimeterStack::kEm)/2;
+  for ( G4int i=0; i<fStack.GetNofModules(); ++i ) {
+    const B4cCalorimeterStack::Module& module = fStack.GetModule(i);
+    G4double moduleThickness = module.GetThickness();
+    G4double moduleLayerThickness = module.GetLayerThickness();
+
+    //
+    // Module
+    //
+    G4VSolid* moduleS
+      = new G4Box(module.name,       // its name
+                   calorSizeXY/2, calorSizeXY/2, moduleThickness/2); // its size
+
+    G4LogicalVolume* moduleLV
+      = new G4LogicalVolume(
+                   moduleS,          // its solid
+                   defaultMaterial,  // its material
+                   module.name);     // its name
+
+    new G4PVPlacement(
+                   0,                // no rotation
+                   G4ThreeVector(0,0,zFront + moduleThickness/2), // behind the previous modules
+                   moduleLV,         // its logical volume
+                   module.name,      // its name
+                   worldLV,          // its mother  volume
+                   false,            // no boolean operation
+                   0,                // copy number
+                   fCheckOverlaps);  // checking overlaps
+    zFront += moduleThickness;
+
+    //
+    // Layer
+    //
+    G4String layerName = module.name + "Layer";
+    G4VSolid* layerS
+      = new G4Box(layerName,         // its name
+                   calorSizeXY/2, calorSizeXY/2, moduleLayerThickness/2); //its size
+
+    G4LogicalVolume* layerLV
+      = new G4LogicalVolume(
+                   layerS,           // its solid
+                   defaultMaterial,  // its material
+                   layerName);       // its name
+
+    new G4PVReplica(
+                   layerName,        // its name
+                   layerLV,          // its logical volume
+                   moduleLV,         // its mother
+                   kZAxis,           // axis of replication
+                   module.nofLayers, // number of replica
+                   moduleLayerThickness); // width of replica
+
+    //
+    // Absorber and active plates, the absorber first
+    //
+    const G4String* materialNames[] 
+      = { &module.absorberMaterial, &module.activeMaterial };
+    const G4double thicknesses[] 
+      = { module.absorberThickness, module.activeThickness };
+    for ( G4int active=0; active<2; ++active ) {
+      if ( thicknesses[active] <= 0 ) continue;
+
+      G4Material* material 
+        = B4cCalorimeterStack::FindMaterial(*materialNames[active]);
+      if ( ! material ) {
+        G4ExceptionDescription msg;
+        msg << "Cannot retrieve material " << *materialNames[active]
+            << " of module " << module.name; 
+        G4Exception("B4DetectorConstruction::DefineVolumes()",
+          "MyCode0001", FatalException, msg);
+        continue;
+      }
+
+      G4String plateName = module.name + ( active ? "Active" : "Absorber" );
+      G4VSolid* plateS
+        = new G4Box(plateName,         // its name
+                     calorSizeXY/2, calorSizeXY/2, thicknesses[active]/2); // its size
+
+      G4LogicalVolume* plateLV
+        = new G4LogicalVolume(
+                     plateS,           // its solid
+                     material,         // its material
+                     module.GetVolumeName(active)); // its name
+
+      // the user limits of the section apply to the sensitive plates
+      if ( module.HasReadout(active) ) {
+        regionSettings[module.section]->Apply(plateLV);
+      }
+
+      G4double z = active ? module.absorberThickness/2 
+                          : -module.activeThickness/2;
+      new G4PVPlacement(
+                     0,                // no rotation
+                     G4ThreeVector(0., 0., z), // its position
+                     plateLV,          // its logical volume
+                     plateName,        // its name
+                     layerLV,          // its mother  volume
+                     false,            // no boolean operation
+                     0,                // copy number
+                     fCheckOverlaps);  // checking overlaps
+    }
 
-  if(calorLV){
-	  G4VisAttributes* simpleBoxVisAtt= new G4VisAttributes(G4Colour(0,0,1.0));
-  	  simpleBoxVisAtt->SetVisibility(true);
-  	  calorLV->SetVisAttributes(simpleBoxVisAtt);
+    //
+    // Region: production cuts and stacking cuts of the section, envelope
+    // of the fast simulation models
+    //
+    G4Region* region = GetRegion(regionNames[module.section]);
+    region->AddRootLogicalVolume(moduleLV);
+    regionSettings[module.section]->Apply(region);
+
+    //                                        
+    // Visualization attributes
+    //
+    G4VisAttributes* simpleBoxVisAtt
+      = new G4VisAttributes(colours[module.section]);
+    simpleBoxVisAtt->SetVisibility(true);
+    moduleLV->SetVisAttributes(simpleBoxVisAtt);
+
+    //
+    // print parameters
+    //
+    G4cout
+      << "     " << module.name << " (" 
+      << B4cCalorimeterStack::GetSectionName(module.section) << "): " 
+      << module.nofLayers << " layers of: [ "
+      << module.absorberThickness/mm << "mm of " 
+      << ( module.absorberThickness > 0 ? module.absorberMaterial : "-" )
+      << " + "
+      << module.activeThickness/mm << "mm of " 
+      << ( module.activeThickness > 0 ? module.activeMaterial : "-" )
+      << " ]" << G4endl;
   }
 
-  if(calorFeLV){
-	  G4VisAttributes* simpleBoxVisAtt= new G4VisAttributes(G4Colour(1.0,0,0,1.0));
-  	  simpleBoxVisAtt->SetVisibility(true);
-  	  calorFeLV->SetVisAttributes(simpleBoxVisAtt);
-  }
+  timer.Stop();
+  G4cout
+    << "---> " << fStack.GetNofLayers() << " layers built in " 
+    << timer.GetRealElapsed()*1000. << " ms with " 
+    << G4LogicalVolumeStore::GetInstance()->size() - nofVolumes
+    << " logical volumes" << G4endl
+    << "------------------------------------------------------------" << G4endl;
 
-  if(calorWLV){
-	  G4VisAttributes* simpleBoxVisAtt= new G4VisAttributes(G4Colour(0,1.0,0,1.0));
-  	  simpleBoxVisAtt->SetVisibility(true);
-  	  calorWLV->SetVisAttributes(simpleBoxVisAtt);
+  //
+  // Voxelisation set with /B4/det/smartless
+  //
+  std::map<G4String, G4double>::const_iterator it;
+  for ( it = fSmartless.begin(); it != fSmartless.end(); ++it ) {
+    G4LogicalVolume* volume 
+      = G4LogicalVolumeStore::GetInstance()->GetVolume(it->first, false);
+    if ( ! volume ) {
+      G4ExceptionDescription msg;
+      msg << "Volume " << it->first << " not found, smartless not applied.";
+      G4Exception("B4cDetectorConstruction::DefineVolumes()",
+        "MyCode0020", JustWarning, msg);
+      continue;
+    }
+    volume->SetSmartless(it->second);
+    G4cout << "---> Smartless of " << it->first << ": " << it->second << G4endl;
   }
+
+  //
+  // Overlap check, skipped if this geometry was validated before
+  //
+  fOverlapCache->Validate();
+
   //
   // Always return the physical World
   //
@@ -514,34 +817,75 @@ void B4cDetectorConstruction::ConstructSDandField()
   // G4SDManager::GetSDMpointer()->SetVerboseLevel(1);
 
   // 
-  // Sensitive detectors
+  // Sensitive detectors: one per read-out plate of each module; the 
+  // layers follow the ones of the previous modules in the shower image
   //
-
-  //if(absoThickness > 0){
-  B4cCalorimeterSD* absoSD 
-    = new B4cCalorimeterSD("AbsorberSD", "AbsorberHitsCollection", fNofLayers);
-  SetSensitiveDetector("AbsoLV",absoSD);
-  //}
-
-  //if(gapThickness > 0){
-  B4cCalorimeterSD* gapSD 
-    = new B4cCalorimeterSD("GapSD", "GapHitsCollection", fNofLayers);
-  SetSensitiveDetector("GapLV",gapSD);
-  //}
-
-
-  if(fFeLayers > 0){
-	  B4cCalorimeterSD* ironSD
-	    = new B4cCalorimeterSD("HadronicSD", "HadronicHitsCollection", fFeLayers);
-	  SetSensitiveDetector("ironLV",ironSD);
+  for ( G4int i=0; i<fStack.GetNofModules(); ++i ) {
+    const B4cCalorimeterStack::Module& module = fStack.GetModule(i);
+    for ( G4int active=0; active<2; ++active ) {
+      if ( ! module.HasReadout(active) ) continue;
+
+      // readout grid of the EM active plates and of the hadronic plates
+      G4int nofCellsX = 1;
+      G4int nofCellsY = 1;
+      if ( module.section == B4cCalorimeterStack::kEm && active ) {
+        nofCellsX = fGapNofCellsX;
+        nofCellsY = fGapNofCellsY;
+      }
+      else if ( module.section == B4cCalorimeterStack::kFe ) {
+        nofCellsX = fFeNofCellsX;
+        nofCellsY = fFeNofCellsY;
+      }
+      else if ( module.section == B4cCalorimeterStack::kW ) {
+        nofCellsX = fWNofCellsX;
+        nofCellsY = fWNofCellsY;
+      }
+
+      B4cCalorimeterSD* calorSD 
+        = GetCalorimeterSD(module.GetSDName(active), 
+                           module.GetHitsCollectionName(active), 
+                           module.nofLayers, calorSizeXY/2, 
+                           nofCellsX, nofCellsY, calorSizeXY);
+      calorSD->SetVoxelLayerOffset(fStack.GetFirstLayer(i));
+      SetSensitiveDetector(module.GetVolumeName(active), calorSD);
+    }
   }
 
-  if(fWLayers > 0){
-	  B4cCalorimeterSD* tungstenSD
-	    = new B4cCalorimeterSD("HadronicSD", "HadronicHitsCollection", fWLayers);
-	  SetSensitiveDetector("tungstenLV",tungstenSD);
+  //
+  // Fast simulation: frozen shower library in the absorber plates of the 
+  // first EM and tungsten modules; the model of this thread is created once
+  // and kept when the geometry is rebuilt, only its trigger volumes are
+  // updated
+  //
+  if ( ! fShowerLibraryModel ) {
+    fShowerLibraryModel = new B4cShowerLibraryModel("showerLibrary");
+    G4AutoDelete::Register(fShowerLibraryModel);
   }
+  G4RegionStore* regionStore = G4RegionStore::GetInstance();
+  fShowerLibraryModel->AddEnvelope(
+    regionStore->GetRegion("EMCalorimeter", false));
+  fShowerLibraryModel->AddEnvelope(
+    regionStore->GetRegion("WCalorimeter", false));
+  G4LogicalVolumeStore* volumeStore = G4LogicalVolumeStore::GetInstance();
+  const B4cCalorimeterStack::Module* em 
+    = fStack.GetFirstModule(B4cCalorimeterStack::kEm);
+  const B4cCalorimeterStack::Module* tungsten 
+    = fStack.GetFirstModule(B4cCalorimeterStack::kW);
+  fShowerLibraryModel->SetTriggerVolumes(
+    em ? volumeStore->GetVolume(em->GetVolumeName(false), false) : 0,
+    tungsten ? volumeStore->GetVolume(tungsten->GetVolumeName(false), false) 
+             : 0);
 
+  //
+  // Fast simulation: parameterised showers in the EM calorimeter
+  //
+  if ( ! fParameterisedShowerModel ) {
+    fParameterisedShowerModel 
+      = new B4cParameterisedShowerModel("parameterisedShower");
+    G4AutoDelete::Register(fParameterisedShowerModel);
+  }
+  fParameterisedShowerModel->AddEnvelope(
+    regionStore->GetRegion("EMCalorimeter", false));
 
   // 
   // Magnetic field
@@ -549,6 +893,9 @@ void B4cDetectorConstruction::ConstructSDandField()
   // Create global magnetic field messenger.
   // Uniform magnetic field is then created automatically if
   // the field value is not zero.
+  // The messenger is kept when the geometry is rebuilt.
+  if ( fMagFieldMessenger ) return;
+
   G4ThreeVector fieldValue = G4ThreeVector();
   fMagFieldMessenger = new G4GlobalMagFieldMessenger(fieldValue);
   fMagFieldMessenger->SetVerboseLevel(1);
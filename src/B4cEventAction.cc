@@ -31,25 +31,39 @@
 #include "B4cEventAction.hh"
 #include "B4cCalorimeterSD.hh"
 #include "B4cCalorHit.hh"
+#include "B4cRun.hh"
+#include "B4cShowerLibraryRecorder.hh"
+#include "B4cStackingAction.hh"
+#include "B4cNtupleSchema.hh"
+#include "B4cAsyncWriter.hh"
+#include "B4cRecordFile.hh"
+#include "B4cVoxelFile.hh"
+#include "B4cAdaptiveRun.hh"
+#include "B4cParticleMix.hh"
+#include "B4cPileUp.hh"
 #include "B4Analysis.hh"
 #include "B4cDetectorConstruction.hh"
+#include "B4PrimaryGeneratorAction.hh"
 
 #include "G4RunManager.hh"
 #include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
 #include "G4SDManager.hh"
 #include "G4HCofThisEvent.hh"
 #include "G4UnitsTable.hh"
 
 #include "Randomize.hh"
 #include <iomanip>
+#include <cmath>
+#include <algorithm>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 B4cEventAction::B4cEventAction()
  : G4UserEventAction(),
-   fAbsHCID(-1),
-   fGapHCID(-1),
-   fHcalHCID(-1)
+   fRunID(-1),
+   fLayers()
 {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -59,26 +73,69 @@ B4cEventAction::~B4cEventAction()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-B4cCalorHitsCollection* 
-B4cEventAction::GetHitsCollection(G4int hcID,
-                                  const G4Event* event) const
+B4cCalorimeterSD* 
+B4cEventAction::GetCalorimeterSD(const G4String& sdName) const
 {
-  B4cCalorHitsCollection* hitsCollection 
-    = static_cast<B4cCalorHitsCollection*>(
-        event->GetHCofThisEvent()->GetHC(hcID));
+  B4cCalorimeterSD* calorSD 
+    = static_cast<B4cCalorimeterSD*>(
+        G4SDManager::GetSDMpointer()->FindSensitiveDetector(sdName, false));
   
-  if ( ! hitsCollection ) {
+  if ( ! calorSD ) {
     G4ExceptionDescription msg;
-    msg << "Cannot access hitsCollection ID " << hcID; 
-    G4Exception("B4cEventAction::GetHitsCollection()",
+    msg << "Cannot access sensitive detector " << sdName; 
+    G4Exception("B4cEventAction::GetCalorimeterSD()",
       "MyCode0003", FatalException, msg);
   }         
 
-  return hitsCollection;
+  return calorSD;
 }    
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void B4cEventAction::UpdateReadouts()
+{
+  const B4cDetectorConstruction* construct
+    = static_cast<const B4cDetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  const B4cCalorimeterStack& stack = construct->GetStack();
+
+  for ( G4int group=0; group<kNofGroups; ++group ) fReadouts[group].clear();
+
+  // the plates of a module share its layer numbers
+  G4int firstLayers[B4cCalorimeterStack::kNofSections] = { 0, 0, 0 };
+  G4int firstHadLayer = 0;
+  for ( G4int i=0; i<stack.GetNofModules(); ++i ) {
+    const B4cCalorimeterStack::Module& module = stack.GetModule(i);
+    G4bool em = module.section == B4cCalorimeterStack::kEm;
+    for ( G4int active=0; active<2; ++active ) {
+      if ( ! module.HasReadout(active) ) continue;
+      Readout readout;
+      readout.sd = GetCalorimeterSD(module.GetSDName(active));
+      readout.firstLayer = firstLayers[module.section];
+      readout.firstCellLayer = em ? readout.firstLayer : firstHadLayer;
+      G4int group = em ? ( active ? kGap : kAbso ) 
+                       : ( module.section == B4cCalorimeterStack::kFe 
+                           ? kFe : kW );
+      fReadouts[group].push_back(readout);
+    }
+    firstLayers[module.section] += module.nofLayers;
+    if ( ! em ) firstHadLayer += module.nofLayers;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cEventAction::AddTotals(G4int group, G4double& edep, 
+                               G4double& trackLength) const
+{
+  for ( size_t i=0; i<fReadouts[group].size(); ++i ) {
+    edep += fReadouts[group][i].sd->GetTotalEdep();
+    trackLength += fReadouts[group][i].sd->GetTotalTrackLength();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void B4cEventAction::PrintEventStatistics(
                               G4double absoEdep, G4double absoTrackLength,
                               G4double gapEdep, G4double gapTrackLength,
@@ -104,6 +161,32 @@ void B4cEventAction::PrintEventStatistics(
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+B4cRun::SpeciesKey 
+B4cEventAction::GetSpeciesKey(const G4PrimaryParticle* primary) const
+{
+  // The species drawn in a mixed run
+  B4cParticleMix* mix = B4cParticleMix::GetInstance();
+  if ( mix && B4cParticleMix::IsEnabled() && mix->GetEventSpecies() >= 0 ) {
+    G4int index = mix->GetEventSpecies();
+    const B4cParticleMix::Species& species 
+      = B4cParticleMix::GetSpecies(index);
+    return B4cRun::SpeciesKey(
+      index, species.particle->GetPDGEncoding(), species.energy);
+  }
+
+  // or the primary particle at the /gun/energy setting, which is also 
+  // the one of the events of a beam spectrum or of a replayed file
+  const B4PrimaryGeneratorAction* generator
+    = static_cast<const B4PrimaryGeneratorAction*>(
+        G4RunManager::GetRunManager()->GetUserPrimaryGeneratorAction());
+  G4double energy 
+    = generator ? generator->GetNominalEnergy() 
+                : primary->GetKineticEnergy();
+  return B4cRun::SpeciesKey(-1, primary->GetPDGcode(), energy);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void B4cEventAction::BeginOfEventAction(const G4Event* /*event*/)
 {}
 
@@ -111,53 +194,45 @@ void B4cEventAction::BeginOfEventAction(const G4Event* /*event*/)
 
 void B4cEventAction::EndOfEventAction(const G4Event* event)
 {  
-  // Get hits collections IDs (only once)
-  if ( fAbsHCID == -1 ) {
-    fAbsHCID 
-      = G4SDManager::GetSDMpointer()->GetCollectionID("AbsorberHitsCollection");
-    fGapHCID 
-      = G4SDManager::GetSDMpointer()->GetCollectionID("GapHitsCollection");
-    fHcalHCID
-      = G4SDManager::GetSDMpointer()->GetCollectionID("HadronicHitsCollection");
+  // An event without primaries, at the end of a replayed file
+  if ( event->IsAborted() ) return;
+
+  // Get the sensitive detectors of this thread (once per run, the 
+  // geometry may have been rebuilt with other modules in between)
+  G4int runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  if ( runID != fRunID ) {
+    fRunID = runID;
+    UpdateReadouts();
   }
 
-  B4cDetectorConstruction* construct = (B4cDetectorConstruction*) G4RunManager::GetRunManager()->GetUserDetectorConstruction();
-
-  //Possibility of element given as 0 for homogeneous detector
-  G4bool hasAbso = construct->GetAbsorberThickness() > 0;
-  G4bool hasGap = construct->GetGapThickness() > 0;
-  G4bool hasHCAL = construct->GetNumberOfHadronicLayers() > 0;
-
   G4double absoEdep = 0; G4double absoTrackLength = 0;
   G4double  gapEdep = 0; G4double  gapTrackLength = 0;
   G4double hcalEdep = 0; G4double hcalTrackLength = 0;
 
-  B4cCalorHitsCollection* absoHC = 0;
-  B4cCalorHitsCollection* gapHC = 0;
-  B4cCalorHitsCollection* hcalHC = 0;
-
-  if(hasAbso){ //Set proper values for absorber hits
-	  absoHC = GetHitsCollection(fAbsHCID, event);
-	  B4cCalorHit* absoHit = (*absoHC)[absoHC->entries()-1];
-	  absoEdep = absoHit->GetEdep();
-	  absoTrackLength = absoHit->GetTrackLength();
-  }
+  AddTotals(kAbso, absoEdep, absoTrackLength);
+  AddTotals(kGap, gapEdep, gapTrackLength);
+  AddTotals(kFe, hcalEdep, hcalTrackLength);
+  AddTotals(kW, hcalEdep, hcalTrackLength);
 
-  if(hasGap){ //Set proper values for gap hits
-	  gapHC = GetHitsCollection(fGapHCID, event);
-	  B4cCalorHit* gapHit = (*gapHC)[gapHC->entries()-1];
-	  gapEdep = gapHit->GetEdep();
-	  gapTrackLength = gapHit->GetTrackLength();
-  }
 
-  if(hasHCAL){ //Set proper values for HCAL
-	  hcalHC = GetHitsCollection(fHcalHCID, event);
-	  B4cCalorHit* hcalHit = (*hcalHC)[hcalHC->entries()-1];
-	  hcalEdep = hcalHit->GetEdep();
-	  hcalTrackLength = hcalHit->GetTrackLength();
+  // Accumulate the event in the run of this thread
+  //
+  B4cRun* run 
+    = static_cast<B4cRun*>(
+        G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  run->AddEvent(absoEdep, gapEdep, hcalEdep);
+  if(event->GetPrimaryVertex() && event->GetPrimaryVertex()->GetPrimary()){
+	  const G4PrimaryParticle* primary 
+	    = event->GetPrimaryVertex()->GetPrimary();
+	  B4cRun::SpeciesKey key = GetSpeciesKey(primary);
+	  run->AddResponse(key, primary->GetKineticEnergy(),
+	                   absoEdep, gapEdep, hcalEdep);
+	  // stop the run once the target precision is reached
+	  if ( B4cAdaptiveRun::IsEnabled() && B4cAdaptiveRun::GetInstance() ) {
+	    B4cAdaptiveRun::GetInstance()->AddEvent(key, gapEdep);
+	  }
   }
 
-
   // Print per event (modulo n)
   //
   G4int eventID = event->GetEventID();
@@ -175,35 +250,396 @@ void B4cEventAction::EndOfEventAction(const G4Event* event)
   //
 
   // get analysis manager
-  G4AnalysisManager* analysisManager = G4AnalysisManager::Instance();
-  
-
-  for(int i = 0; i < construct->GetNumberOfLayers(); i++){
-	  G4double x,y,r;
-	  G4double eDep = 0;
+  G4VAnalysisManager* analysisManager = B4Analysis::GetManager();
+
+  // With the asynchronous writer (/B4/output/async), the event summary is
+  // copied in a record and the writer thread fills the histograms and the
+  // result ntuple
+  B4cAsyncWriter* writer = B4cAsyncWriter::GetInstance();
+  G4double* record = 0;
+  if(writer && writer->IsRunning()){
+	  G4double depth, stallSeconds;
+	  record = writer->AcquireSlot(depth, stallSeconds);
+	  run->AddWriterRecord(depth, stallSeconds);
+  }
 
-	  //Passive material would not be known in real-world applications
-	  if(hasAbso){
-		  eDep += (*absoHC)[i]->GetEdep();
+  // Transverse profile: flush the radial bins of each EM layer, the 
+  // overflow bin (last) is not histogrammed
+  G4double gapEdepR = 0.;
+  G4double gapEdepR2 = 0.;
+  if(record){
+	  // reset the layer (-1 = not read out) and radial values of the
+	  // reused slot
+	  std::fill(record + writer->GetLayerOffset(),
+	            record + writer->GetRadialOffset(), -1.);
+	  std::fill(record + writer->GetRadialOffset(),
+	            record + writer->GetRadialOffset() 
+	              + writer->GetNofLayers()*writer->GetNofRadialBins(), 0.);
+  }
+  for(size_t j = 0; j < fReadouts[kGap].size(); j++){
+	const B4cCalorimeterSD* gapSD = fReadouts[kGap][j].sd;
+	for(G4int k = 0; k < gapSD->GetNofCells(); k++){
+	  G4int i = fReadouts[kGap][j].firstLayer + k;
+	  G4int lGap =  i + 1;
+	  G4double layerEdep = gapSD->GetEdep(k);
+	  run->AddEmLayerEdep(i, layerEdep);
+	  if(record && i < writer->GetNofLayers()){
+		  record[writer->GetLayerOffset() + i] = layerEdep;
+	  }
+	  else if(!record){
+		  analysisManager->FillH1(2, lGap, layerEdep);
+	  }
+	  if(layerEdep <= 0.) continue;
+
+	  gapEdepR += gapSD->GetEdepR(k);
+	  gapEdepR2 += gapSD->GetEdepR2(k);
+
+	  if(record){
+		  if(i >= writer->GetNofLayers()) continue;
+		  G4int nofBins = std::min(gapSD->GetNofRadialBins(), 
+		                           writer->GetNofRadialBins());
+		  G4double* radialEdep = record + writer->GetRadialOffset()
+		                         + i*writer->GetNofRadialBins();
+		  for(G4int bin = 0; bin < nofBins; bin++){
+			  radialEdep[bin] = gapSD->GetRadialEdep(k, bin);
+		  }
+		  continue;
 	  }
 
-	  if(hasGap){
-		  G4ThreeVector gPos = (*gapHC)[i]->GetPosition();
-		  x = gPos.getX(); y = gPos.getY(); 
-		  r = sqrt((x*x) + (y*y));
-		  analysisManager->FillH1(1,r,(*gapHC)[i]->GetEdep());
-		  eDep += (*absoHC)[i]->GetEdep();
+	  G4double binWidth = gapSD->GetRadialBinWidth();
+	  for(G4int bin = 0; bin < gapSD->GetNofRadialBins(); bin++){
+		  G4double binEdep = gapSD->GetRadialEdep(k, bin);
+		  if(binEdep <= 0.) continue;
+		  G4double r = (bin + 0.5)*binWidth;
+		  analysisManager->FillH1(1, r, binEdep);
+		  analysisManager->FillH2(1, lGap, r, binEdep);
 	  }
+	}
+  }
 
-	  G4int lGap =  i + 1;
-	  if(hasGap) analysisManager->FillH1(2, lGap, (*gapHC)[i]->GetEdep());
+  // Energy-weighted mean and rms radius in the EM gaps
+  G4double rMean = 0.;
+  G4double rRms = 0.;
+  if(gapEdep > 0.){
+	  rMean = gapEdepR/gapEdep;
+	  G4double r2Mean = gapEdepR2/gapEdep;
+	  rRms = std::sqrt(std::max(r2Mean - rMean*rMean, 0.));
   }
 
+  // Kinetic energy of the tracks killed by the stacking action
+  G4double killedTime = 0.;
+  G4double killedEkin = 0.;
+  B4cStackingAction* stackingAction = B4cStackingAction::GetInstance();
+  if(stackingAction){
+	  killedTime = stackingAction->GetKilledEnergy(B4cStackingAction::kTimeCut);
+	  killedEkin = stackingAction->GetKilledEnergy(B4cStackingAction::kEnergyCut);
+  }
 
-  // fill ntuple
+  if(record){
+	  // the writer fills the result ntuple row from the record
+	  record[B4cAsyncWriter::kEventID] = eventID;
+	  record[B4cAsyncWriter::kAbsoEdep] = absoEdep;
+	  record[B4cAsyncWriter::kGapEdep] = gapEdep;
+	  record[B4cAsyncWriter::kHcalEdep] = hcalEdep;
+	  record[B4cAsyncWriter::kAbsoLength] = absoTrackLength;
+	  record[B4cAsyncWriter::kGapLength] = gapTrackLength;
+	  record[B4cAsyncWriter::kHcalLength] = hcalTrackLength;
+	  record[B4cAsyncWriter::kEmRMean] = rMean;
+	  record[B4cAsyncWriter::kEmRRms] = rRms;
+	  record[B4cAsyncWriter::kKilledTime] = killedTime;
+	  record[B4cAsyncWriter::kKilledEkin] = killedEkin;
+	  FillWriterRecord(writer, record, event);
+	  writer->CommitSlot();
+  }
+  else{
+	  FillResultNtuple(event, absoEdep, gapEdep, hcalEdep,
+	                   absoTrackLength, gapTrackLength, hcalTrackLength,
+	                   rMean, rRms, killedTime, killedEkin);
+  }
 
-  analysisManager->FillNtupleDColumn(0, absoEdep + gapEdep);
-  analysisManager->AddNtupleRow();
+  // fill the fixed-size record of the event (/B4/records/)
+
+  B4cRecordFile* recordFile = B4cRecordFile::GetInstance();
+  if(recordFile && recordFile->IsOpen()){
+	  FillRecord(recordFile, event, absoEdep, gapEdep, hcalEdep);
+  }
+
+  // add the shower image of the event (/B4/voxels/)
+
+  B4cVoxelFile* voxelFile = B4cVoxelFile::GetInstance();
+  if(voxelFile && voxelFile->IsOpen()){
+	  voxelFile->BeginEvent(eventID);
+	  for(G4int group = 0; group < kNofGroups; group++){
+		  for(size_t i = 0; i < fReadouts[group].size(); i++){
+			  const B4cCalorimeterSD* voxelSD = fReadouts[group][i].sd;
+			  for(G4int j = 0; j < voxelSD->GetNofFiredVoxels(); j++){
+				  voxelFile->AddVoxel(voxelSD->GetFiredVoxelKey(j),
+				                      voxelSD->GetFiredVoxelEdep(j));
+			  }
+		  }
+	  }
+	  voxelFile->EndEvent();
+  }
+
+  // fill the fired readout cells, the writer thread may be filling the
+  // same analysis manager
+
+  if(record){
+	  std::lock_guard<std::mutex> lock(writer->GetAnalysisMutex());
+	  FillFiredCells(kGap, 0, eventID);
+	  FillFiredCells(kFe, 1, eventID);
+	  FillFiredCells(kW, 1, eventID);
+  }
+  else{
+	  FillFiredCells(kGap, 0, eventID);
+	  FillFiredCells(kFe, 1, eventID);
+	  FillFiredCells(kW, 1, eventID);
+  }
+
+  // close the showers followed by the shower library recorder
+
+  B4cShowerLibraryRecorder* recorder = B4cShowerLibraryRecorder::GetInstance();
+  if(recorder) recorder->EndOfEvent();
 }  
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cEventAction::FillFiredCells(G4int group, G4int detector, 
+                                    G4int eventID) const
+{
+  G4VAnalysisManager* analysisManager = B4Analysis::GetManager();
+  for ( size_t j=0; j<fReadouts[group].size(); ++j ) {
+    const B4cCalorimeterSD* calorSD = fReadouts[group][j].sd;
+    if ( ! calorSD->HasCellGrid() ) continue;
+
+    for ( G4int i=0; i<calorSD->GetNofFiredCells(); ++i ) {
+      G4int layer, ix, iy;
+      calorSD->GetFiredCell(i, layer, ix, iy);
+      layer += fReadouts[group][j].firstCellLayer;
+      analysisManager->FillNtupleIColumn(1, 0, eventID);
+      analysisManager->FillNtupleIColumn(1, 1, detector);
+      analysisManager->FillNtupleIColumn(1, 2, layer);
+      analysisManager->FillNtupleIColumn(1, 3, ix);
+      analysisManager->FillNtupleIColumn(1, 4, iy);
+      analysisManager->FillNtupleDColumn(1, 5, calorSD->GetFiredCellEdep(i));
+      analysisManager->AddNtupleRow(1);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cEventAction::FillResultNtuple(const G4Event* event,
+                              G4double absoEdep, G4double gapEdep,
+                              G4double hcalEdep, G4double absoTrackLength,
+                              G4double gapTrackLength, 
+                              G4double hcalTrackLength,
+                              G4double rMean, G4double rRms,
+                              G4double killedTime, G4double killedEkin) const
+{
+  // fill ntuple, the columns not selected in the schema are skipped
+
+  B4cNtupleSchema* schema = B4cNtupleSchema::GetInstance();
+  schema->Fill(B4cNtupleSchema::kEmTotal, absoEdep + gapEdep);
+  schema->Fill(B4cNtupleSchema::kEmRMean, rMean);
+  schema->Fill(B4cNtupleSchema::kEmRRms, rRms);
+  schema->Fill(B4cNtupleSchema::kKilledTime, killedTime);
+  schema->Fill(B4cNtupleSchema::kKilledEkin, killedEkin);
+
+  schema->Fill(B4cNtupleSchema::kAbsoEdep, absoEdep);
+  schema->Fill(B4cNtupleSchema::kGapEdep, gapEdep);
+  schema->Fill(B4cNtupleSchema::kHcalEdep, hcalEdep);
+  schema->Fill(B4cNtupleSchema::kTotalEdep, absoEdep + gapEdep + hcalEdep);
+
+  schema->Fill(B4cNtupleSchema::kAbsoLength, absoTrackLength);
+  schema->Fill(B4cNtupleSchema::kGapLength, gapTrackLength);
+  schema->Fill(B4cNtupleSchema::kHcalLength, hcalTrackLength);
+
+  // species of a mixed run, also histogrammed per species
+  B4cParticleMix* mix = B4cParticleMix::GetInstance();
+  if ( mix && B4cParticleMix::IsEnabled() && mix->GetEventSpecies() >= 0 ) {
+	  G4int index = mix->GetEventSpecies();
+	  schema->Fill(B4cNtupleSchema::kSpecies, index);
+	  schema->Fill(B4cNtupleSchema::kBeamEnergy, 
+	               B4cParticleMix::GetSpecies(index).energy);
+	  if ( mix->HasHistos(index) ) {
+		  G4VAnalysisManager* analysisManager = B4Analysis::GetManager();
+		  analysisManager->FillH1(mix->GetHistoId(index, false), 
+		                          absoEdep + gapEdep + hcalEdep);
+		  analysisManager->FillH1(mix->GetHistoId(index, true), gapEdep);
+	  }
+  }
+
+  // pile-up: the deposit of the signal primary and of the overlays
+  B4cPileUp* pileUp = B4cPileUp::GetInstance();
+  if ( pileUp && B4cPileUp::IsEnabled() ) {
+	  G4double signalEdep = 0.;
+	  for ( G4int group = 0; group < kNofGroups; group++ ) {
+		  for ( size_t i = 0; i < fReadouts[group].size(); i++ ) {
+			  signalEdep += fReadouts[group][i].sd->GetPrimaryEdep(0);
+		  }
+	  }
+	  schema->Fill(B4cNtupleSchema::kNofPrimaries, pileUp->GetNofPrimaries());
+	  schema->Fill(B4cNtupleSchema::kSignalEdep, signalEdep);
+	  schema->Fill(B4cNtupleSchema::kPileUpEdep, 
+	               absoEdep + gapEdep + hcalEdep - signalEdep);
+  }
+
+  if(schema->HasColumn(B4cNtupleSchema::kPrimaryPdg) && 
+     event->GetPrimaryVertex() && event->GetPrimaryVertex()->GetPrimary()){
+	  const G4PrimaryVertex* vertex = event->GetPrimaryVertex();
+	  const G4PrimaryParticle* primary = vertex->GetPrimary();
+	  G4ThreeVector direction = primary->GetMomentumDirection();
+	  schema->Fill(B4cNtupleSchema::kPrimaryPdg, primary->GetPDGcode());
+	  schema->Fill(B4cNtupleSchema::kPrimaryEkin, primary->GetKineticEnergy());
+	  schema->Fill(B4cNtupleSchema::kPrimaryX, vertex->GetX0());
+	  schema->Fill(B4cNtupleSchema::kPrimaryY, vertex->GetY0());
+	  schema->Fill(B4cNtupleSchema::kPrimaryDirX, direction.x());
+	  schema->Fill(B4cNtupleSchema::kPrimaryDirY, direction.y());
+	  schema->Fill(B4cNtupleSchema::kPrimaryDirZ, direction.z());
+  }
+
+  if(schema->HasVector(B4cNtupleSchema::kAbsoLayers)){
+	  FillLayers(kAbso, schema->GetVector(B4cNtupleSchema::kAbsoLayers));
+	  FillLayers(kGap, schema->GetVector(B4cNtupleSchema::kGapLayers));
+	  FillLayers(kFe, schema->GetVector(B4cNtupleSchema::kFeLayers));
+	  FillLayers(kW, schema->GetVector(B4cNtupleSchema::kWLayers));
+  }
+
+  schema->AddRow();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cEventAction::FillWriterRecord(B4cAsyncWriter* writer, 
+                                      G4double* record, const G4Event* event)
+{
+  // the columns of FillResultNtuple() other than the event summary
+
+  // species of a mixed run and its histograms
+  record[B4cAsyncWriter::kSpecies] = -1.;
+  record[B4cAsyncWriter::kSpeciesTotalH1] = -1.;
+  B4cParticleMix* mix = B4cParticleMix::GetInstance();
+  if ( mix && B4cParticleMix::IsEnabled() && mix->GetEventSpecies() >= 0 ) {
+	  G4int index = mix->GetEventSpecies();
+	  record[B4cAsyncWriter::kSpecies] = index;
+	  record[B4cAsyncWriter::kBeamEnergy] 
+	    = B4cParticleMix::GetSpecies(index).energy;
+	  if ( mix->HasHistos(index) ) {
+		  record[B4cAsyncWriter::kSpeciesTotalH1] 
+		    = mix->GetHistoId(index, false);
+		  record[B4cAsyncWriter::kSpeciesVisibleH1] 
+		    = mix->GetHistoId(index, true);
+	  }
+  }
+
+  // pile-up: the deposit of the signal primary
+  record[B4cAsyncWriter::kHasPileUp] = 0.;
+  B4cPileUp* pileUp = B4cPileUp::GetInstance();
+  if ( pileUp && B4cPileUp::IsEnabled() ) {
+	  G4double signalEdep = 0.;
+	  for ( G4int group = 0; group < kNofGroups; group++ ) {
+		  for ( size_t i = 0; i < fReadouts[group].size(); i++ ) {
+			  signalEdep += fReadouts[group][i].sd->GetPrimaryEdep(0);
+		  }
+	  }
+	  record[B4cAsyncWriter::kHasPileUp] = 1.;
+	  record[B4cAsyncWriter::kNofPrimaries] = pileUp->GetNofPrimaries();
+	  record[B4cAsyncWriter::kSignalEdep] = signalEdep;
+  }
+
+  // first primary
+  record[B4cAsyncWriter::kHasPrimary] = 0.;
+  if(event->GetPrimaryVertex() && event->GetPrimaryVertex()->GetPrimary()){
+	  const G4PrimaryVertex* vertex = event->GetPrimaryVertex();
+	  const G4PrimaryParticle* primary = vertex->GetPrimary();
+	  G4ThreeVector direction = primary->GetMomentumDirection();
+	  record[B4cAsyncWriter::kHasPrimary] = 1.;
+	  record[B4cAsyncWriter::kPrimaryPdg] = primary->GetPDGcode();
+	  record[B4cAsyncWriter::kPrimaryEkin] = primary->GetKineticEnergy();
+	  record[B4cAsyncWriter::kPrimaryX] = vertex->GetX0();
+	  record[B4cAsyncWriter::kPrimaryY] = vertex->GetY0();
+	  record[B4cAsyncWriter::kPrimaryDirX] = direction.x();
+	  record[B4cAsyncWriter::kPrimaryDirY] = direction.y();
+	  record[B4cAsyncWriter::kPrimaryDirZ] = direction.z();
+  }
+
+  // layer vectors, in the order of the schema vectors
+  const G4int groups[B4cNtupleSchema::kNofVectors] = { kAbso, kGap, kFe, kW };
+  for(G4int i = 0; i < B4cNtupleSchema::kNofVectors; i++){
+	  record[B4cAsyncWriter::kVectorSize + i] = 0.;
+	  if(writer->GetVectorCapacity(i) == 0) continue;
+	  FillLayers(groups[i], fLayers);
+	  G4int size = std::min(G4int(fLayers.size()), 
+	                        writer->GetVectorCapacity(i));
+	  std::copy(fLayers.begin(), fLayers.begin() + size, 
+	            record + writer->GetVectorOffset(i));
+	  record[B4cAsyncWriter::kVectorSize + i] = size;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cEventAction::FillLayers(G4int group,
+                                std::vector<G4double>& layers) const
+{
+  // Reuses the vector capacity, an absent group gives an empty vector;
+  // the plates of a module read out together add up in its layers
+  layers.clear();
+  for ( size_t j=0; j<fReadouts[group].size(); ++j ) {
+    const B4cCalorimeterSD* calorSD = fReadouts[group][j].sd;
+    G4int firstLayer = fReadouts[group][j].firstLayer;
+    if ( G4int(layers.size()) < firstLayer + calorSD->GetNofCells() ) {
+      layers.resize(firstLayer + calorSD->GetNofCells(), 0.);
+    }
+    for ( G4int i=0; i<calorSD->GetNofCells(); ++i ) {
+      layers[firstLayer + i] += calorSD->GetEdep(i);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cEventAction::FillRecord(B4cRecordFile* recordFile, 
+                                const G4Event* event, G4double absoEdep,
+                                G4double gapEdep, G4double hcalEdep) const
+{
+
+  G4double* record = recordFile->NewRecord();
+  record[recordFile->GetOffset(B4cRecordFile::kEventID)] 
+    = event->GetEventID();
+  if(event->GetPrimaryVertex() && event->GetPrimaryVertex()->GetPrimary()){
+	  const G4PrimaryParticle* primary 
+	    = event->GetPrimaryVertex()->GetPrimary();
+	  record[recordFile->GetOffset(B4cRecordFile::kPrimaryPdg)] 
+	    = primary->GetPDGcode();
+	  record[recordFile->GetOffset(B4cRecordFile::kPrimaryEkin)] 
+	    = primary->GetKineticEnergy();
+  }
+  record[recordFile->GetOffset(B4cRecordFile::kAbsoEdep)] = absoEdep;
+  record[recordFile->GetOffset(B4cRecordFile::kGapEdep)] = gapEdep;
+  record[recordFile->GetOffset(B4cRecordFile::kHcalEdep)] = hcalEdep;
+  record[recordFile->GetOffset(B4cRecordFile::kTotalEdep)] 
+    = absoEdep + gapEdep + hcalEdep;
+
+  const G4int layerFields[kNofGroups] = {
+    B4cRecordFile::kAbsoLayers, B4cRecordFile::kGapLayers,
+    B4cRecordFile::kFeLayers, B4cRecordFile::kWLayers };
+  for(G4int group = 0; group < kNofGroups; group++){
+	  G4double* layers = record + recordFile->GetOffset(layerFields[group]);
+	  G4int count = recordFile->GetCount(layerFields[group]);
+	  for(size_t i = 0; i < fReadouts[group].size(); i++){
+		  const B4cCalorimeterSD* layerSD = fReadouts[group][i].sd;
+		  G4int firstLayer = fReadouts[group][i].firstLayer;
+		  G4int nofLayers = std::min(layerSD->GetNofCells(), 
+		                             count - firstLayer);
+		  for(G4int layer = 0; layer < nofLayers; layer++){
+			  layers[firstLayer + layer] += layerSD->GetEdep(layer);
+		  }
+	  }
+  }
+
+  recordFile->CommitRecord();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
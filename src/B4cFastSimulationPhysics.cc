@@ -0,0 +1,93 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cFastSimulationPhysics.cc
+/// \brief Implementation of the B4cFastSimulationPhysics class
+
+#include "B4cFastSimulationPhysics.hh"
+#include "B4cShowerLibraryModel.hh"
+#include "B4cParameterisedShowerModel.hh"
+
+#include "G4FastSimulationManagerProcess.hh"
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ProcessManager.hh"
+#include "G4ProcessTable.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  const char* processName = "fastSimProcess_massGeom";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cFastSimulationPhysics::B4cFastSimulationPhysics(const G4String& name)
+ : G4VPhysicsConstructor(name)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cFastSimulationPhysics::~B4cFastSimulationPhysics()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cFastSimulationPhysics::ConstructParticle()
+{
+  // The particles are constructed by the other constructors
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cFastSimulationPhysics::ConstructProcess()
+{
+  // In the mass geometry the fast simulation process is a discrete 
+  // process, its ordering does not matter
+  G4FastSimulationManagerProcess* fastSimProcess 
+    = new G4FastSimulationManagerProcess(processName);
+
+  const char* particleNames[] = { "gamma", "e-", "e+" };
+  for ( G4int i=0; i<3; ++i ) {
+    G4ParticleDefinition* particle
+      = G4ParticleTable::GetParticleTable()->FindParticle(particleNames[i]);
+    particle->GetProcessManager()->AddDiscreteProcess(fastSimProcess);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cFastSimulationPhysics::UpdateActivation()
+{
+  G4bool active 
+    = B4cShowerLibraryModel::GetOptions().mode 
+        == B4cShowerLibraryModel::kReplay ||
+      B4cParameterisedShowerModel::GetOptions().enable;
+  G4ProcessTable::GetProcessTable()->SetProcessActivation(processName, active);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,193 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cNtupleSchema.cc
+/// \brief Implementation of the B4cNtupleSchema class
+
+#include "B4cNtupleSchema.hh"
+#include "B4cParticleMix.hh"
+#include "B4cPileUp.hh"
+#include "B4Analysis.hh"
+
+
+namespace {
+  // names and groups of the scalar columns
+  enum { kSummary, kTotals, kTrackLengths, kPrimary, kMix, kPileUp };
+
+  struct ColumnDef {
+    const char* name;
+    G4int group;
+    G4bool isInteger;
+  };
+
+  const ColumnDef kColumnDefs[B4cNtupleSchema::kNofColumns] = {
+    { "em_total", kSummary, false },
+    { "em_rmean", kSummary, false },
+    { "em_rrms", kSummary, false },
+    { "killed_time", kSummary, false },
+    { "killed_ekin", kSummary, false },
+    { "abso_edep", kTotals, false },
+    { "gap_edep", kTotals, false },
+    { "hcal_edep", kTotals, false },
+    { "total_edep", kTotals, false },
+    { "abso_length", kTrackLengths, false },
+    { "gap_length", kTrackLengths, false },
+    { "hcal_length", kTrackLengths, false },
+    { "primary_pdg", kPrimary, true },
+    { "primary_ekin", kPrimary, false },
+    { "primary_x", kPrimary, false },
+    { "primary_y", kPrimary, false },
+    { "primary_dirx", kPrimary, false },
+    { "primary_diry", kPrimary, false },
+    { "primary_dirz", kPrimary, false },
+    { "species", kMix, true },
+    { "beam_energy", kMix, false },
+    { "nof_primaries", kPileUp, true },
+    { "signal_edep", kPileUp, false },
+    { "pileup_edep", kPileUp, false }
+  };
+
+  const char* kVectorNames[B4cNtupleSchema::kNofVectors] = {
+    "abso_layers", "gap_layers", "fe_layers", "w_layers"
+  };
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cNtupleSchema::Options::Options()
+ : layers(false),
+   totals(false),
+   trackLengths(false),
+   primary(false),
+   basketSize(256000),
+   compression(1)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cNtupleSchema::Options& B4cNtupleSchema::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal B4cNtupleSchema* B4cNtupleSchema::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cNtupleSchema::B4cNtupleSchema()
+ : fAnalysisManager(0),
+   fNtupleId(-1)
+{
+  for ( G4int i=0; i<kNofColumns; ++i ) {
+    fColumnId[i] = -1;
+  }
+  for ( G4int i=0; i<kNofVectors; ++i ) {
+    fHasVector[i] = false;
+  }
+  fgInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cNtupleSchema::~B4cNtupleSchema()
+{
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cNtupleSchema::Book(G4int ntupleId)
+{
+  if ( IsBooked() ) return;
+
+  const Options& options = GetOptions();
+  G4bool groups[] 
+    = { true, options.totals, options.trackLengths, options.primary,
+        B4cParticleMix::IsEnabled(), B4cPileUp::IsEnabled() };
+
+  G4VAnalysisManager* analysisManager = B4Analysis::GetManager();
+  fAnalysisManager = analysisManager;
+  // Large baskets: fewer, bigger buffered writes at high event rates
+  B4Analysis::SetBasketSize(options.basketSize);
+  B4Analysis::SetCompressionLevel(options.compression);
+
+  fNtupleId 
+    = analysisManager->CreateNtuple("result", "Total Deposited Energy / MeV");
+  for ( G4int i=0; i<kNofColumns; ++i ) {
+    if ( ! groups[kColumnDefs[i].group] ) continue;
+    if ( kColumnDefs[i].isInteger ) {
+      fColumnId[i] = analysisManager->CreateNtupleIColumn(kColumnDefs[i].name);
+    } 
+    else {
+      fColumnId[i] = analysisManager->CreateNtupleDColumn(kColumnDefs[i].name);
+    }
+  }
+  if ( options.layers ) {
+    for ( G4int i=0; i<kNofVectors; ++i ) {
+      analysisManager->CreateNtupleDColumn(kVectorNames[i], fVectors[i]);
+      fHasVector[i] = true;
+    }
+  }
+  analysisManager->FinishNtuple();
+
+  if ( fNtupleId != ntupleId ) {
+    G4ExceptionDescription msg;
+    msg << "The result ntuple has id " << fNtupleId 
+        << " instead of " << ntupleId;
+    G4Exception("B4cNtupleSchema::Book()",
+      "MyCode0009", FatalException, msg);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cNtupleSchema::Fill(G4int column, G4double value) const
+{
+  if ( fColumnId[column] < 0 ) return;
+  fAnalysisManager->FillNtupleDColumn(fNtupleId, fColumnId[column], value);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cNtupleSchema::Fill(G4int column, G4int value) const
+{
+  if ( fColumnId[column] < 0 ) return;
+  fAnalysisManager->FillNtupleIColumn(fNtupleId, fColumnId[column], value);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cNtupleSchema::AddRow() const
+{
+  fAnalysisManager->AddNtupleRow(fNtupleId);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
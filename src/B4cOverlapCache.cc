@@ -0,0 +1,222 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cOverlapCache.cc
+/// \brief Implementation of the B4cOverlapCache class
+
+#include "B4cOverlapCache.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4VSolid.hh"
+#include "G4Material.hh"
+#include "G4Timer.hh"
+#include "G4Version.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  // 64-bit FNV-1a hash of the geometry description
+  unsigned long long HashKey(const G4String& key) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for ( size_t i=0; i<key.size(); ++i ) {
+      hash ^= (unsigned char)key[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cOverlapCache::B4cOverlapCache()
+ : fMessenger(0),
+   fUseCache(true),
+   fCacheFile("overlap_cache.txt"),
+   fForce(false),
+   fResolution(1000)
+{
+  // The geometry is built on the master only: the commands are not passed
+  // to the worker threads
+  fMessenger = new G4GenericMessenger(this, "/B4/overlaps/", 
+    "Geometry overlap check control");
+  fMessenger->DeclareProperty("useCache", fUseCache,
+    "Skip the overlap check of the geometries found in the cache file.")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareProperty("cacheFile", fCacheFile,
+    "File of the hashes of the geometries validated against overlaps.")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareProperty("force", fForce,
+    "Check the overlaps even of the geometries found in the cache file.")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareProperty("resolution", fResolution,
+    "Number of surface points tested per volume.")
+    .SetParameterName("nofPoints", false)
+    .SetRange("nofPoints>0")
+    .SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cOverlapCache::~B4cOverlapCache()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cOverlapCache::Validate()
+{
+  std::ostringstream hash;
+  hash << std::hex << std::setw(16) << std::setfill('0') 
+       << HashKey(GetKey());
+
+  G4bool cached = fUseCache && IsCached(hash.str());
+  if ( cached && ! fForce ) {
+    G4cout << "Overlap check skipped: geometry " << hash.str() 
+           << " validated before (" << fCacheFile << ")" << G4endl;
+    return true;
+  }
+
+  // The replicas fill their mother exactly, only the placements are
+  // tested
+  G4Timer timer;
+  timer.Start();
+  G4int nofPlacements = 0;
+  G4int nofOverlaps = 0;
+  const G4PhysicalVolumeStore* volumes = G4PhysicalVolumeStore::GetInstance();
+  for ( size_t i=0; i<volumes->size(); ++i ) {
+    G4VPhysicalVolume* volume = (*volumes)[i];
+    if ( ! volume->GetMotherLogical() || volume->IsReplicated() ) continue;
+    ++nofPlacements;
+    if ( volume->CheckOverlaps(fResolution) ) ++nofOverlaps;
+  }
+  timer.Stop();
+
+  G4cout << "Overlap check of geometry " << hash.str() << ": " 
+         << nofPlacements << " placements tested in " 
+         << timer.GetRealElapsed() << " s, ";
+  if ( nofOverlaps ) {
+    G4cout << nofOverlaps << " with overlaps" << G4endl;
+    return false;
+  }
+  G4cout << "no overlap" << G4endl;
+
+  if ( fUseCache && ! cached ) AddToCache(hash.str());
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String B4cOverlapCache::GetKey() const
+{
+  std::ostringstream key;
+  key << std::setprecision(12);
+
+  key << "geant4: " << G4Version << '\n'
+      << "resolution: " << fResolution << '\n';
+
+  // Logical volumes: solid and material
+  const G4LogicalVolumeStore* logicals = G4LogicalVolumeStore::GetInstance();
+  for ( size_t i=0; i<logicals->size(); ++i ) {
+    const G4LogicalVolume* logical = (*logicals)[i];
+    key << "volume: " << logical->GetName() << ' '
+        << ( logical->GetMaterial() ? logical->GetMaterial()->GetName() 
+                                    : G4String("-") ) << '\n';
+    logical->GetSolid()->StreamInfo(key);
+  }
+
+  // Physical volumes: position in the mother or replication
+  const G4PhysicalVolumeStore* volumes = G4PhysicalVolumeStore::GetInstance();
+  for ( size_t i=0; i<volumes->size(); ++i ) {
+    const G4VPhysicalVolume* volume = (*volumes)[i];
+    key << "placement: " << volume->GetName() << ' '
+        << volume->GetLogicalVolume()->GetName() << ' '
+        << ( volume->GetMotherLogical() 
+             ? volume->GetMotherLogical()->GetName() : G4String("-") ) 
+        << ' ' << volume->GetCopyNo();
+    if ( volume->IsReplicated() ) {
+      EAxis axis;
+      G4int nofReplicas;
+      G4double width, offset;
+      G4bool consuming;
+      volume->GetReplicationData(axis, nofReplicas, width, offset, consuming);
+      key << " replica " << axis << ' ' << nofReplicas << ' ' 
+          << width/mm << ' ' << offset/mm;
+    }
+    else {
+      G4ThreeVector translation = volume->GetTranslation();
+      key << ' ' << translation.x()/mm << ' ' << translation.y()/mm 
+          << ' ' << translation.z()/mm;
+      if ( volume->GetRotation() ) key << ' ' << *volume->GetRotation();
+    }
+    key << '\n';
+  }
+
+  return key.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cOverlapCache::IsCached(const G4String& hash) const
+{
+  std::ifstream input(fCacheFile);
+  std::string line;
+  while ( std::getline(input, line) ) {
+    std::istringstream tokens(line);
+    std::string first;
+    if ( tokens >> first && first == hash ) return true;
+  }
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cOverlapCache::AddToCache(const G4String& hash) const
+{
+  // one line per geometry, appended so that concurrent jobs do not
+  // overwrite each other
+  std::ofstream output(fCacheFile, std::ios::app);
+  output << hash << std::endl;
+  if ( ! output ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot write the overlap cache file " << fCacheFile;
+    G4Exception("B4cOverlapCache::AddToCache()",
+      "MyCode0019", JustWarning, msg);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,220 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cParameterSweep.cc
+/// \brief Implementation of the B4cParameterSweep class
+
+#include "B4cParameterSweep.hh"
+#include "B4cDetectorConstruction.hh"
+#include "B4cRun.hh"
+
+#include "G4RunManager.hh"
+#include "G4StateManager.hh"
+#include "G4UImanager.hh"
+#include "G4UIcommand.hh"
+#include "G4UnitsTable.hh"
+#include "G4Timer.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
+#include <iomanip>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cParameterSweep::B4cParameterSweep(B4cDetectorConstruction* detConstruction)
+ : fDetConstruction(detConstruction),
+   fPoints()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cParameterSweep::~B4cParameterSweep()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cParameterSweep::Load(const G4String& fileName)
+{
+  std::ifstream input(fileName);
+  if ( ! input ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open sweep file " << fileName;
+    G4Exception("B4cParameterSweep::Load()",
+      "MyCode0005", JustWarning, msg);
+    return false;
+  }
+
+  std::string line;
+  G4int lineNumber = 0;
+  while ( std::getline(input, line) ) {
+    ++lineNumber;
+    std::istringstream tokens(line);
+    std::string first;
+    if ( ! (tokens >> first) || first[0] == '#' ) continue;
+
+    Point point;
+    G4String unit;
+    point.particle = first;
+    tokens >> point.energy >> unit 
+           >> point.emLayers >> point.absoThickness >> point.gapThickness
+           >> point.feLayers >> point.wLayers >> point.hadLayerThickness
+           >> point.nofEvents;
+    if ( tokens.fail() ) {
+      G4ExceptionDescription msg;
+      msg << "Cannot parse line " << lineNumber << " of " << fileName 
+          << ": " << line;
+      G4Exception("B4cParameterSweep::Load()",
+        "MyCode0005", JustWarning, msg);
+      return false;
+    }
+
+    point.energy *= G4UnitDefinition::GetValueOf(unit);
+    point.absoThickness *= mm;
+    point.gapThickness *= mm;
+    point.hadLayerThickness *= mm;
+    fPoints.push_back(point);
+  }
+
+  G4cout << "Loaded " << fPoints.size() << " sweep points from " 
+         << fileName << G4endl;
+
+  return ! fPoints.empty();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cParameterSweep::Execute(const G4String& summaryFileName)
+{
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
+  G4RunManager* runManager = G4RunManager::GetRunManager();
+
+  std::ofstream summary(summaryFileName);
+  summary 
+    << "point,particle,energy_MeV,emlayers,absorber_mm,gap_mm,"
+    << "felayers,wlayers,hadronic_mm,events,"
+    << "abso_mean_MeV,abso_rms_MeV,gap_mean_MeV,gap_rms_MeV,"
+    << "hcal_mean_MeV,hcal_rms_MeV,total_mean_MeV,total_rms_MeV,"
+    << "time_s,output" << std::endl;
+
+  G4Timer sweepTimer;
+  sweepTimer.Start();
+
+  G4int nofRebuilds = 0;
+  const Point* built = 0;
+  for ( size_t i=0; i<fPoints.size(); ++i ) {
+    const Point& point = fPoints[i];
+
+    G4Timer pointTimer;
+    pointTimer.Start();
+
+    // Geometry: set up before the first initialisation, rebuilt only when
+    // it differs from the one of the previous point
+    G4bool initialised 
+      = G4StateManager::GetStateManager()->GetCurrentState() != G4State_PreInit;
+    if ( ! built || ! SameGeometry(point, *built) ) {
+      fDetConstruction->SetGeometry(
+        point.absoThickness, point.gapThickness, point.emLayers,
+        point.hadLayerThickness, point.feLayers, point.wLayers);
+      if ( initialised ) {
+        UImanager->ApplyCommand("/run/reinitializeGeometry true");
+        ++nofRebuilds;
+      }
+      else {
+        UImanager->ApplyCommand("/run/initialize");
+      }
+      built = &point;
+    }
+
+    // Beam and output file
+    std::ostringstream fileName;
+    fileName << "result_" << i;
+    UImanager->ApplyCommand("/gun/particle " + point.particle);
+    UImanager->ApplyCommand(
+      "/gun/energy " + G4UIcommand::ConvertToString(point.energy/MeV) + " MeV");
+    UImanager->ApplyCommand("/analysis/setFileName " + fileName.str());
+
+    UImanager->ApplyCommand(
+      "/run/beamOn " + G4UIcommand::ConvertToString(point.nofEvents));
+
+    pointTimer.Stop();
+
+    const B4cRun* run 
+      = static_cast<const B4cRun*>(runManager->GetCurrentRun());
+    WriteSummary(summary, i, point, fileName.str(), run,
+                 pointTimer.GetRealElapsed());
+  }
+
+  sweepTimer.Stop();
+
+  G4cout
+    << G4endl
+    << "--------------------End of Sweep----------------------------" << G4endl
+    << " " << fPoints.size() << " points, " << nofRebuilds 
+    << " geometry rebuilds in " << sweepTimer.GetRealElapsed() << " s" 
+    << G4endl
+    << " Summary written to " << summaryFileName << G4endl
+    << "------------------------------------------------------------" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cParameterSweep::SameGeometry(const Point& first,
+                                       const Point& second) const
+{
+  return first.emLayers == second.emLayers 
+      && first.absoThickness == second.absoThickness
+      && first.gapThickness == second.gapThickness
+      && first.feLayers == second.feLayers
+      && first.wLayers == second.wLayers
+      && first.hadLayerThickness == second.hadLayerThickness;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cParameterSweep::WriteSummary(std::ofstream& summary, G4int index,
+                                     const Point& point,
+                                     const G4String& fileName,
+                                     const B4cRun* run, G4double time) const
+{
+  summary 
+    << index << ',' << point.particle << ',' << point.energy/MeV << ','
+    << point.emLayers << ',' << point.absoThickness/mm << ','
+    << point.gapThickness/mm << ',' << point.feLayers << ','
+    << point.wLayers << ',' << point.hadLayerThickness/mm << ','
+    << ( run ? run->GetNumberOfEvent() : 0 );
+
+  G4int quantities[] 
+    = { B4cRun::kAbso, B4cRun::kGap, B4cRun::kHcal, B4cRun::kTotal };
+  for ( G4int i=0; i<4; ++i ) {
+    summary << ',' << ( run ? run->GetMean(quantities[i])/MeV : 0. )
+            << ',' << ( run ? run->GetRms(quantities[i])/MeV : 0. );
+  }
+
+  summary << ',' << time << ',' << fileName << std::endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,364 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cParameterisedShowerModel.cc
+/// \brief Implementation of the B4cParameterisedShowerModel class
+
+#include "B4cParameterisedShowerModel.hh"
+#include "B4cCalorimeterSD.hh"
+#include "B4cDetectorConstruction.hh"
+
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4FastSimulationManager.hh"
+#include "G4Region.hh"
+#include "G4Material.hh"
+#include "G4Element.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4TransportationManager.hh"
+#include "G4TouchableHistory.hh"
+#include "G4AffineTransform.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4ParticleTable.hh"
+#include "G4EmCalculator.hh"
+#include "G4Track.hh"
+#include "G4Run.hh"
+#include "G4RunManager.hh"
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  // Critical energy of a solid or liquid (PDG), from the mean Z by mass
+  G4double GetCriticalEnergy(const G4Material* material) {
+    G4double z = 0.;
+    const G4double* fractions = material->GetFractionVector();
+    for ( size_t i=0; i<material->GetNumberOfElements(); ++i ) {
+      z += fractions[i]*material->GetElement(i)->GetZ();
+    }
+    return 610.*MeV/(z + 1.24);
+  }
+
+  // Minimum ionisation energy loss, from a muon of about 400 MeV
+  G4double GetMipDEDX(const G4Material* material) {
+    G4EmCalculator calculator;
+    const G4ParticleDefinition* muon
+      = G4ParticleTable::GetParticleTable()->FindParticle("mu-");
+    return calculator.ComputeElectronicDEDX(400.*MeV, muon, material);
+  }
+
+  const G4double scaleEnergy = 21.2052*MeV;
+  const G4double profileB = 0.5;
+  const G4double coreFraction = 0.8;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cParameterisedShowerModel::Options::Options()
+ : enable(false),
+   minEnergy(1.*GeV),
+   nofSpots(200),
+   eOverMip(1.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cParameterisedShowerModel::Options& 
+B4cParameterisedShowerModel::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cParameterisedShowerModel::Medium::Medium()
+ : valid(false),
+   nofLayers(0),
+   absoThickness(0.),
+   gapThickness(0.),
+   layerThickness(0.),
+   radiationLength(0.),
+   criticalEnergy(0.),
+   moliereRadius(0.),
+   gapFraction(0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cParameterisedShowerModel::B4cParameterisedShowerModel(
+                                                    const G4String& name)
+ : G4VFastSimulationModel(name),
+   fEnvelopes(),
+   fNavigator(new G4Navigator()),
+   fTouchable(new G4TouchableHistory()),
+   fNavigatorReady(false),
+   fRunID(-1),
+   fMedia()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cParameterisedShowerModel::~B4cParameterisedShowerModel()
+{
+  delete fTouchable;
+  delete fNavigator;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cParameterisedShowerModel::AddEnvelope(G4Region* region)
+{
+  if ( ! region || fEnvelopes.count(region) ) return;
+
+  G4FastSimulationManager* manager = region->GetFastSimulationManager();
+  if ( ! manager ) manager = new G4FastSimulationManager(region);
+  manager->AddFastSimulationModel(this);
+  fEnvelopes.insert(region);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cParameterisedShowerModel::IsApplicable(
+                                     const G4ParticleDefinition& particle)
+{
+  G4int pdgCode = particle.GetPDGEncoding();
+  return pdgCode == 22 || pdgCode == 11 || pdgCode == -11;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cParameterisedShowerModel::ModelTrigger(const G4FastTrack& fastTrack)
+{
+  const Options& options = GetOptions();
+  if ( ! options.enable ) return false;
+  if ( fastTrack.GetPrimaryTrack()->GetKineticEnergy() < options.minEnergy ) {
+    return false;
+  }
+  if ( fastTrack.GetPrimaryTrackLocalDirection().z() <= 0. ) return false;
+
+  return GetMedium(fastTrack.GetEnvelopeLogicalVolume()) != 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cParameterisedShowerModel::DoIt(const G4FastTrack& fastTrack, 
+                                       G4FastStep& fastStep)
+{
+  const G4Track* track = fastTrack.GetPrimaryTrack();
+  G4double energy = track->GetKineticEnergy();
+  G4bool isGamma = track->GetDefinition()->GetPDGEncoding() == 22;
+
+  // Effective medium of the module in which the shower starts, prepared
+  // by ModelTrigger()
+  const Medium* medium = GetMedium(fastTrack.GetEnvelopeLogicalVolume());
+  if ( ! medium ) return;
+
+  // Longitudinal profile
+  G4double tMax 
+    = std::log(energy/medium->criticalEnergy) + ( isGamma ? 0.5 : -0.5 );
+  G4double profileA = 1. + profileB*std::max(tMax, 0.);
+
+  // Shower axis in the envelope frame
+  G4ThreeVector position = fastTrack.GetPrimaryTrackLocalPosition();
+  G4ThreeVector direction = fastTrack.GetPrimaryTrackLocalDirection();
+  G4ThreeVector u = direction.orthogonal().unit();
+  G4ThreeVector v = direction.cross(u);
+  const G4AffineTransform* toGlobal 
+    = fastTrack.GetInverseAffineTransformation();
+  G4double zFront = - medium->nofLayers*medium->layerThickness/2.;
+
+  // The world may have been rebuilt since the previous shower
+  G4VPhysicalVolume* world 
+    = G4TransportationManager::GetTransportationManager()
+        ->GetNavigatorForTracking()->GetWorldVolume();
+  if ( fNavigator->GetWorldVolume() != world ) {
+    fNavigator->SetWorldVolume(world);
+  }
+  fNavigatorReady = false;
+
+  G4int nofSpots = std::max(GetOptions().nofSpots, 1);
+  G4double spotEnergy = energy/nofSpots;
+  for ( G4int i=0; i<nofSpots; ++i ) {
+    // depth and layer
+    G4double t = CLHEP::RandGamma::shoot(profileA, profileB);
+    G4double z = position.z() + t*medium->radiationLength*direction.z();
+    G4int layer = G4int((z - zFront)/medium->layerThickness);
+    if ( layer < 0 || layer >= medium->nofLayers ) continue;
+
+    // transverse position
+    G4double radius 
+      = ( G4UniformRand() < coreFraction ) ? medium->moliereRadius/5. 
+                                           : medium->moliereRadius;
+    G4double random = G4UniformRand();
+    G4double r = radius*std::sqrt(random/(1. - random));
+    G4double phi = twopi*G4UniformRand();
+    G4ThreeVector offset = r*(std::cos(phi)*u + std::sin(phi)*v);
+
+    // sampling: one deposit in the middle of the absorber and of the gap
+    G4double zLayer = zFront + layer*medium->layerThickness;
+    if ( medium->absoThickness > 0. ) {
+      G4double zAbso = zLayer + medium->absoThickness/2.;
+      G4ThreeVector axisPoint 
+        = position + (zAbso - position.z())/direction.z()*direction;
+      Deposit(toGlobal->TransformPoint(axisPoint + offset),
+              spotEnergy*(1. - medium->gapFraction));
+    }
+    if ( medium->gapThickness > 0. ) {
+      G4double zGap 
+        = zLayer + medium->absoThickness + medium->gapThickness/2.;
+      G4ThreeVector axisPoint 
+        = position + (zGap - position.z())/direction.z()*direction;
+      Deposit(toGlobal->TransformPoint(axisPoint + offset),
+              spotEnergy*medium->gapFraction);
+    }
+  }
+
+  // The energy is deposited by the spots directly in the SDs
+  fastStep.KillPrimaryTrack();
+  fastStep.ProposePrimaryTrackPathLength(0.);
+  fastStep.ProposeTotalEnergyDeposited(0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cParameterisedShowerModel::Deposit(const G4ThreeVector& position,
+                                          G4double edep)
+{
+  if ( edep <= 0. ) return;
+
+  fNavigator->LocateGlobalPointAndUpdateTouchable(
+    position, fTouchable, fNavigatorReady);
+  fNavigatorReady = true;
+
+  G4VPhysicalVolume* volume = fTouchable->GetVolume();
+  if ( ! volume ) return;
+
+  B4cCalorimeterSD* calorSD 
+    = dynamic_cast<B4cCalorimeterSD*>(
+        volume->GetLogicalVolume()->GetSensitiveDetector());
+  if ( calorSD ) calorSD->AddSpot(edep, position, fTouchable);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const B4cParameterisedShowerModel::Medium* 
+B4cParameterisedShowerModel::GetMedium(const G4LogicalVolume* envelope)
+{
+  // The effective media are computed once per run, the geometry may have
+  // changed in between
+  G4int runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  if ( runID != fRunID ) {
+    fRunID = runID;
+    fMedia.clear();
+  }
+
+  std::map<const G4LogicalVolume*, Medium>::iterator it 
+    = fMedia.find(envelope);
+  if ( it == fMedia.end() ) {
+    it = fMedia.insert(std::make_pair(envelope, Medium())).first;
+    it->second.valid = Prepare(envelope, it->second);
+  }
+  return it->second.valid ? &it->second : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cParameterisedShowerModel::Prepare(const G4LogicalVolume* envelope,
+                                            Medium& medium) const
+{
+  if ( ! envelope ) return false;
+
+  const B4cDetectorConstruction* construct
+    = static_cast<const B4cDetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  // The EM module of the envelope volume, named after the module
+  const B4cCalorimeterStack& stack = construct->GetStack();
+  const B4cCalorimeterStack::Module* module = 0;
+  for ( G4int i=0; i<stack.GetNofModules(); ++i ) {
+    if ( stack.GetModule(i).section == B4cCalorimeterStack::kEm &&
+         stack.GetModule(i).name == envelope->GetName() ) {
+      module = &stack.GetModule(i);
+      break;
+    }
+  }
+  if ( ! module ) return false;
+  medium.nofLayers = module->nofLayers;
+  medium.absoThickness = module->absorberThickness;
+  medium.gapThickness = module->activeThickness;
+  medium.layerThickness = medium.absoThickness + medium.gapThickness;
+
+  G4LogicalVolumeStore* volumeStore = G4LogicalVolumeStore::GetInstance();
+  G4LogicalVolume* absorberLV 
+    = volumeStore->GetVolume(module->GetVolumeName(false), false);
+  G4LogicalVolume* gapLV 
+    = volumeStore->GetVolume(module->GetVolumeName(true), false);
+  const G4Material* absorber = absorberLV ? absorberLV->GetMaterial() : 0;
+  const G4Material* gap = gapLV ? gapLV->GetMaterial() : 0;
+
+  // Thickness in radiation lengths of each medium
+  G4double absoX0 
+    = absorber ? medium.absoThickness/absorber->GetRadlen() : 0.;
+  G4double gapX0 = gap ? medium.gapThickness/gap->GetRadlen() : 0.;
+  if ( medium.nofLayers <= 0 || absoX0 + gapX0 <= 0. ) return false;
+
+  medium.radiationLength = medium.layerThickness/(absoX0 + gapX0);
+  medium.criticalEnergy 
+    = ( ( absorber ? absoX0*GetCriticalEnergy(absorber) : 0. ) +
+        ( gap ? gapX0*GetCriticalEnergy(gap) : 0. ) )/(absoX0 + gapX0);
+  medium.moliereRadius 
+    = scaleEnergy*medium.radiationLength/medium.criticalEnergy;
+
+  // Visible fraction from the mip energy loss
+  G4double absoMip 
+    = absorber ? medium.absoThickness*GetMipDEDX(absorber) : 0.;
+  G4double gapMip = gap ? medium.gapThickness*GetMipDEDX(gap) : 0.;
+  medium.gapFraction 
+    = ( absoMip + gapMip > 0. ) 
+      ? std::min(GetOptions().eOverMip*gapMip/(absoMip + gapMip), 1.) : 0.;
+
+  if ( G4Threading::G4GetThreadId() <= 0 ) {
+    G4cout
+      << G4endl
+      << "---> Parameterised EM showers in " << module->name << ": X0 = " 
+      << medium.radiationLength/mm << " mm, Ec = " 
+      << medium.criticalEnergy/MeV << " MeV, Rm = " 
+      << medium.moliereRadius/mm << " mm, gap fraction = "
+      << medium.gapFraction << G4endl;
+  }
+
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,160 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cParticleMix.cc
+/// \brief Implementation of the B4cParticleMix class
+
+#include "B4cParticleMix.hh"
+
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4UIcommand.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  // Species of all threads, set by the commands between runs
+  std::vector<B4cParticleMix::Species> mixSpecies;
+  std::vector<G4double> mixCumulativeWeights;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal B4cParticleMix* B4cParticleMix::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cParticleMix::B4cParticleMix()
+ : fEventSpecies(-1),
+   fFirstHistoId(-1),
+   fNofHistoSpecies(0)
+{
+  fgInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cParticleMix::~B4cParticleMix()
+{
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cParticleMix::AddSpecies(const G4String& species)
+{
+  std::istringstream input(species);
+  G4String name;
+  G4double value = 0.;
+  G4String unit;
+  G4double weight = 1.;
+  input >> name >> value >> unit;
+  if ( ! ( input >> weight ) ) weight = 1.;
+
+  Species newSpecies;
+  newSpecies.particle 
+    = G4ParticleTable::GetParticleTable()->FindParticle(name);
+  newSpecies.energy = value*G4UIcommand::ValueOf(unit.c_str());
+  newSpecies.weight = weight;
+
+  if ( ! newSpecies.particle || newSpecies.energy <= 0. || weight <= 0. ) {
+    G4ExceptionDescription msg;
+    msg << "Invalid species \"" << species << "\"," 
+        << " expected <particle> <energy> <unit> [weight]." << G4endl;
+    msg << "The species is not added.";
+    G4Exception("B4cParticleMix::AddSpecies()",
+      "MyCode0016", JustWarning, msg);
+    return;
+  }
+
+  mixSpecies.push_back(newSpecies);
+  G4double sum 
+    = mixCumulativeWeights.empty() ? 0. : mixCumulativeWeights.back();
+  mixCumulativeWeights.push_back(sum + weight);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cParticleMix::ClearSpecies()
+{
+  mixSpecies.clear();
+  mixCumulativeWeights.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cParticleMix::GetNofSpecies()
+{
+  return mixSpecies.size();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const B4cParticleMix::Species& B4cParticleMix::GetSpecies(G4int index)
+{
+  return mixSpecies[index];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String B4cParticleMix::GetLabel(G4int index)
+{
+  // e.g. "pi+_10GeV"
+  std::ostringstream label;
+  label << mixSpecies[index].particle->GetParticleName() << "_" 
+        << mixSpecies[index].energy/GeV << "GeV";
+  return label.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cParticleMix::SampleSpecies()
+{
+  fEventSpecies = DrawSpecies();
+  return fEventSpecies;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cParticleMix::DrawSpecies() const
+{
+  // a handful of species: a binary search of the cumulative weights
+  G4double u = G4UniformRand()*mixCumulativeWeights.back();
+  G4int index 
+    = std::upper_bound(mixCumulativeWeights.begin(), 
+                       mixCumulativeWeights.end(), u) 
+      - mixCumulativeWeights.begin();
+  return std::min(index, GetNofSpecies() - 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,266 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cPhysicsTableCache.cc
+/// \brief Implementation of the B4cPhysicsTableCache class
+
+#include "B4cPhysicsTableCache.hh"
+
+#include "G4VUserPhysicsList.hh"
+#include "G4GenericMessenger.hh"
+#include "G4StateManager.hh"
+#include "G4Material.hh"
+#include "G4Element.hh"
+#include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4ProductionCuts.hh"
+#include "G4Version.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <set>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  // 64-bit FNV-1a hash of the key description
+  unsigned long long HashKey(const G4String& key) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for ( size_t i=0; i<key.size(); ++i ) {
+      hash ^= (unsigned char)key[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  G4String ReadFile(const G4String& fileName) {
+    std::ifstream input(fileName);
+    std::ostringstream content;
+    content << input.rdbuf();
+    return content.str();
+  }
+
+  // Create a directory and its missing parents (mkdir -p); on failure the
+  // directory which could not be created and the errno are returned
+  G4bool MakeDirectories(const G4String& path, G4String& failed, 
+                         int& error) {
+    for ( size_t end = path.find('/', 1); ; end = path.find('/', end + 1) ) {
+      G4String directory = path.substr(0, end);
+      if ( directory.size() && mkdir(directory.c_str(), 0755) != 0 ) {
+        struct stat status;
+        if ( errno != EEXIST || stat(directory.c_str(), &status) != 0 ||
+             ! S_ISDIR(status.st_mode) ) {
+          error = ( errno != EEXIST ) ? errno : ENOTDIR;
+          failed = directory;
+          return false;
+        }
+      }
+      if ( end == std::string::npos ) return true;
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cPhysicsTableCache::B4cPhysicsTableCache(G4VUserPhysicsList* physicsList,
+                                           const G4String& physicsListName)
+ : G4VStateDependent(),
+   fPhysicsList(physicsList),
+   fPhysicsListName(physicsListName),
+   fMessenger(0),
+   fUseCache(false),
+   fCacheDir("physics_tables"),
+   fKey(),
+   fTableDir(),
+   fStorePending(false)
+{
+  // The tables are built on the master only: the commands are not passed
+  // to the worker threads
+  fMessenger 
+    = new G4GenericMessenger(this, "/B4/phys/", "Physics tables control");
+  fMessenger->DeclareProperty("useCache", fUseCache,
+    "Store and retrieve the physics tables in the cache directory\n"
+    "(off by default).")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareProperty("cacheDir", fCacheDir,
+    "Top directory of the physics table cache, created with its parents\n"
+    "if needed.")
+    .SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cPhysicsTableCache::~B4cPhysicsTableCache()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cPhysicsTableCache::Notify(G4ApplicationState requestedState)
+{
+  if ( ! fUseCache ) return true;
+
+  G4ApplicationState previousState 
+    = G4StateManager::GetStateManager()->GetPreviousState();
+
+  // Run initialisation: the physics tables are (re)built next
+  if ( previousState == G4State_Idle && requestedState == G4State_Init ) {
+    Prepare();
+  }
+  // End of run initialisation: the physics tables are built
+  else if ( previousState == G4State_Init && requestedState == G4State_Idle 
+            && fStorePending ) {
+    Store();
+  }
+
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String B4cPhysicsTableCache::GetKey() const
+{
+  std::ostringstream key;
+  key << std::setprecision(12);
+
+  key << "physics list: " << fPhysicsListName << '\n'
+      << "geant4: " << G4Version << '\n'
+      << "default cut: " << fPhysicsList->GetDefaultCutValue()/mm << '\n';
+
+  // Material table
+  const G4MaterialTable* materials = G4Material::GetMaterialTable();
+  for ( size_t i=0; i<materials->size(); ++i ) {
+    const G4Material* material = (*materials)[i];
+    key << "material: " << material->GetName() 
+        << ' ' << material->GetDensity()/(g/cm3)
+        << ' ' << material->GetTemperature()/kelvin;
+    const G4ElementVector* elements = material->GetElementVector();
+    const G4double* fractions = material->GetFractionVector();
+    for ( size_t j=0; j<material->GetNumberOfElements(); ++j ) {
+      key << ' ' << (*elements)[j]->GetName() << ' ' << fractions[j];
+    }
+    key << '\n';
+  }
+
+  // Production cuts per region
+  const G4RegionStore* regions = G4RegionStore::GetInstance();
+  for ( size_t i=0; i<regions->size(); ++i ) {
+    const G4Region* region = (*regions)[i];
+    key << "region: " << region->GetName();
+    const G4ProductionCuts* cuts = region->GetProductionCuts();
+    if ( cuts ) {
+      for ( G4int j=0; j<4; ++j ) key << ' ' << cuts->GetProductionCut(j)/mm;
+    }
+    key << '\n';
+  }
+
+  // Materials used in each region, which define the material-cuts couples
+  std::set<std::string> couples;
+  const G4LogicalVolumeStore* volumes = G4LogicalVolumeStore::GetInstance();
+  for ( size_t i=0; i<volumes->size(); ++i ) {
+    const G4LogicalVolume* volume = (*volumes)[i];
+    if ( ! volume->GetRegion() || ! volume->GetMaterial() ) continue;
+    couples.insert(
+      volume->GetRegion()->GetName() + " " + volume->GetMaterial()->GetName());
+  }
+  for ( std::set<std::string>::const_iterator it = couples.begin();
+        it != couples.end(); ++it ) {
+    key << "couple: " << *it << '\n';
+  }
+
+  return key.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cPhysicsTableCache::Prepare()
+{
+  G4String key = GetKey();
+  if ( key == fKey ) return;
+
+  fKey = key;
+  std::ostringstream tableDir;
+  tableDir << fCacheDir << '/' 
+           << std::hex << std::setw(16) << std::setfill('0') << HashKey(key);
+  fTableDir = tableDir.str();
+
+  // The key file is written last, after the tables have been stored
+  if ( ReadFile(fTableDir + "/key.txt") == fKey ) {
+    G4cout << "Physics table cache hit: retrieving tables from " 
+           << fTableDir << G4endl;
+    fPhysicsList->SetPhysicsTableRetrieved(fTableDir);
+    fStorePending = false;
+  }
+  else {
+    G4cout << "Physics table cache miss: tables will be built and stored in "
+           << fTableDir << G4endl;
+    fPhysicsList->ResetPhysicsTableRetrieved();
+    fStorePending = true;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cPhysicsTableCache::Store()
+{
+  fStorePending = false;
+
+  G4String failed;
+  int error = 0;
+  if ( ! MakeDirectories(fTableDir, failed, error) ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot create the directory " << failed << ": " 
+        << std::strerror(error) << G4endl
+        << "The physics tables are not stored in " << fTableDir;
+    G4Exception("B4cPhysicsTableCache::Store()",
+      "MyCode0006", JustWarning, msg);
+    return;
+  }
+
+  if ( ! fPhysicsList->StorePhysicsTable(fTableDir) ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot store the physics tables in " << fTableDir;
+    G4Exception("B4cPhysicsTableCache::Store()",
+      "MyCode0006", JustWarning, msg);
+    return;
+  }
+
+  std::ofstream keyFile(fTableDir + "/key.txt");
+  keyFile << fKey;
+
+  G4cout << "Physics table cache: tables stored in " << fTableDir << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,116 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cPileUp.cc
+/// \brief Implementation of the B4cPileUp class
+
+#include "B4cPileUp.hh"
+
+#include "G4Poisson.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cPileUp::Options::Options()
+ : mean(0.),
+   timeWindow(0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cPileUp::Options& B4cPileUp::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal B4cPileUp* B4cPileUp::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cPileUp::B4cPileUp()
+ : fPrimaryOf(),
+   fNofPrimaries(0)
+{
+  fgInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cPileUp::~B4cPileUp()
+{
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cPileUp::SampleNofOverlays() const
+{
+  return G4Poisson(GetOptions().mean);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cPileUp::SampleTimeOffset() const
+{
+  return G4UniformRand()*GetOptions().timeWindow;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cPileUp::PrepareNewEvent()
+{
+  // the capacity is kept for the next events
+  fPrimaryOf.clear();
+  fPrimaryOf.push_back(0);
+  fNofPrimaries = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cPileUp::RecordTrack(G4int trackID, G4int parentID)
+{
+  // The primaries have the track IDs 1 to N in the order of the vertices;
+  // the secondaries get the next IDs as they are stacked, so the parent 
+  // of a track is already recorded
+  if ( trackID >= G4int(fPrimaryOf.size()) ) fPrimaryOf.resize(trackID+1, 0);
+
+  if ( parentID == 0 ) {
+    fPrimaryOf[trackID] = trackID - 1;
+    fNofPrimaries = std::max(fNofPrimaries, trackID);
+  }
+  else {
+    fPrimaryOf[trackID] = GetPrimary(parentID);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,221 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cPrimaryFile.cc
+/// \brief Implementation of the B4cPrimaryFile class
+
+#include "B4cPrimaryFile.hh"
+
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cPrimaryFile::B4cPrimaryFile()
+ : fFileName(),
+   fMapping(0),
+   fMappingSize(0),
+   fIndex(0),
+   fParticles(0),
+   fNofEvents(0),
+   fOwnedIndex(),
+   fOwnedParticles()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cPrimaryFile::~B4cPrimaryFile()
+{
+  Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cPrimaryFile::Open(const G4String& fileName)
+{
+  Close();
+  fFileName = fileName;
+
+  if ( Map() || ReadHepEvt() ) return true;
+
+  Close();
+  return false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cPrimaryFile::Close()
+{
+  if ( fMapping ) munmap(fMapping, fMappingSize);
+  fMapping = 0;
+  fMappingSize = 0;
+  fIndex = 0;
+  fParticles = 0;
+  fNofEvents = 0;
+  fOwnedIndex.clear();
+  fOwnedParticles.clear();
+  fFileName.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cPrimaryFile::Map()
+{
+  int descriptor = open(fFileName.c_str(), O_RDONLY);
+  if ( descriptor < 0 ) return false;
+
+  struct stat status;
+  void* mapping = MAP_FAILED;
+  size_t size = 0;
+  if ( fstat(descriptor, &status) == 0 ) {
+    size = status.st_size;
+    if ( size >= kPrimaryHeaderSize ) {
+      mapping = mmap(0, size, PROT_READ, MAP_SHARED, descriptor, 0);
+    }
+  }
+  // the mapping stays valid after the file is closed
+  close(descriptor);
+  if ( mapping == MAP_FAILED ) return false;
+
+  fMapping = mapping;
+  fMappingSize = size;
+
+  const B4cPrimaryHeader* header 
+    = static_cast<const B4cPrimaryHeader*>(fMapping);
+  if ( std::memcmp(header->magic, kPrimaryMagic, sizeof(kPrimaryMagic)) != 0 ||
+       header->version != kPrimaryVersion || 
+       header->headerSize < sizeof(B4cPrimaryHeader) ||
+       header->nofEvents == 0 ) {
+    munmap(fMapping, fMappingSize);
+    fMapping = 0;
+    fMappingSize = 0;
+    return false;
+  }
+
+  // The index and the particles must be complete and consistent; the 
+  // counts are bounded by the size left in the file before any size is 
+  // computed from them, so that a corrupt header cannot overflow
+  size_t available 
+    = ( header->headerSize <= size ) ? size - header->headerSize : 0;
+  G4bool valid 
+    = header->nofEvents < available/sizeof(uint64_t) &&
+      header->nofEvents < uint64_t(std::numeric_limits<G4int>::max());
+  size_t indexSize 
+    = valid ? (header->nofEvents + 1)*sizeof(uint64_t) : 0;
+  valid = valid &&
+    header->nofParticles <= (available - indexSize)/sizeof(B4cPrimaryRecord);
+  const char* data = static_cast<const char*>(fMapping);
+  const uint64_t* index 
+    = reinterpret_cast<const uint64_t*>(data + header->headerSize);
+  valid = valid &&
+    index[0] == 0 && index[header->nofEvents] == header->nofParticles;
+  for ( uint64_t i=0; valid && i<header->nofEvents; ++i ) {
+    valid = index[i] <= index[i+1];
+  }
+  if ( ! valid ) {
+    munmap(fMapping, fMappingSize);
+    fMapping = 0;
+    fMappingSize = 0;
+    return false;
+  }
+
+  fIndex = index;
+  fParticles = reinterpret_cast<const B4cPrimaryRecord*>(
+                 data + header->headerSize + indexSize);
+  fNofEvents = header->nofEvents;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cPrimaryFile::ReadHepEvt()
+{
+  std::ifstream input(fFileName);
+  if ( ! input ) return false;
+
+  fOwnedIndex.push_back(0);
+  G4int nofEntries = 0;
+  while ( input >> nofEntries ) {
+    for ( G4int i=0; i<nofEntries; ++i ) {
+      G4int status, pdg, daughter1, daughter2;
+      G4double px, py, pz, mass;
+      if ( ! ( input >> status >> pdg >> daughter1 >> daughter2 
+                     >> px >> py >> pz >> mass ) ) return false;
+      if ( status != 1 ) continue;
+
+      B4cPrimaryRecord particle;
+      std::memset(&particle, 0, sizeof(particle));
+      particle.pdg = pdg;
+      particle.px = px*GeV/MeV;
+      particle.py = py*GeV/MeV;
+      particle.pz = pz*GeV/MeV;
+      fOwnedParticles.push_back(particle);
+    }
+    fOwnedIndex.push_back(fOwnedParticles.size());
+  }
+  // the input stops at the end of file or at a malformed event count
+  if ( ! input.eof() || fOwnedIndex.size() < 2 ) return false;
+
+  fIndex = &fOwnedIndex[0];
+  fParticles = fOwnedParticles.empty() ? 0 : &fOwnedParticles[0];
+  fNofEvents = fOwnedIndex.size() - 1;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cPrimaryFile::Prefetch(G4int firstEvent, G4int nofEvents) const
+{
+  if ( ! fMapping || nofEvents <= 0 ) return;
+
+  // The kernel reads the pages in the background, so that the next events
+  // are in memory before they are generated
+  G4int lastEvent = std::min(firstEvent + nofEvents, fNofEvents);
+  const char* begin 
+    = reinterpret_cast<const char*>(fParticles + fIndex[firstEvent]);
+  const char* end 
+    = reinterpret_cast<const char*>(fParticles + fIndex[lastEvent]);
+  if ( end <= begin ) return;
+
+  uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+  uintptr_t pageBegin = reinterpret_cast<uintptr_t>(begin) & ~(pageSize - 1);
+  madvise(reinterpret_cast<void*>(pageBegin), 
+          reinterpret_cast<uintptr_t>(end) - pageBegin, MADV_WILLNEED);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
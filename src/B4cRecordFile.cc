@@ -0,0 +1,195 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cRecordFile.cc
+/// \brief Implementation of the B4cRecordFile class
+
+#include "B4cRecordFile.hh"
+
+#include "G4Threading.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+
+namespace {
+  const char* kFieldNames[B4cRecordFile::kNofFields] = {
+    "event_id", "primary_pdg", "primary_ekin",
+    "abso_edep", "gap_edep", "hcal_edep", "total_edep",
+    "abso_layers", "gap_layers", "fe_layers", "w_layers"
+  };
+
+  static_assert(sizeof(B4cRecordHeader) <= kRecordHeaderSize,
+                "The record header does not fit in its reserved size");
+  static_assert(B4cRecordFile::kNofFields <= kRecordMaxFields,
+                "Too many fields in the record");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRecordFile::Options::Options()
+ : enable(false),
+   chunkSize(256),
+   fileName("records")
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRecordFile::Options& B4cRecordFile::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal B4cRecordFile* B4cRecordFile::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRecordFile::B4cRecordFile()
+ : fFile(0),
+   fHeader(),
+   fChunkSize(0),
+   fNofChunkRecords(0),
+   fChunk()
+{
+  fgInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRecordFile::~B4cRecordFile()
+{
+  Close();
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRecordFile::Open(G4int runID, G4int nofAbsoLayers, 
+                         G4int nofGapLayers, G4int nofFeLayers,
+                         G4int nofWLayers)
+{
+  if ( IsOpen() ) Close();
+
+  const Options& options = GetOptions();
+
+  std::ostringstream fileName;
+  fileName << options.fileName << "_r" << runID;
+  if ( G4Threading::G4GetThreadId() >= 0 ) {
+    fileName << "_t" << G4Threading::G4GetThreadId();
+  }
+  fileName << ".b4r";
+  fFile = std::fopen(fileName.str().c_str(), "wb");
+  if ( ! fFile ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open " << fileName.str() 
+        << ", the event records are not written.";
+    G4Exception("B4cRecordFile::Open()",
+      "MyCode0012", JustWarning, msg);
+    return;
+  }
+
+  // Record layout, fixed for the run
+  G4int counts[kNofFields] = { 1, 1, 1, 1, 1, 1, 1, 
+    std::max(nofAbsoLayers, 0), std::max(nofGapLayers, 0),
+    std::max(nofFeLayers, 0), std::max(nofWLayers, 0) };
+
+  std::memset(&fHeader, 0, sizeof(fHeader));
+  std::memcpy(fHeader.magic, kRecordMagic, sizeof(kRecordMagic));
+  fHeader.version = kRecordVersion;
+  fHeader.headerSize = kRecordHeaderSize;
+  fHeader.nofFields = kNofFields;
+  for ( G4int i=0; i<kNofFields; ++i ) {
+    B4cRecordField& field = fHeader.fields[i];
+    std::strncpy(field.name, kFieldNames[i], sizeof(field.name) - 1);
+    field.offset = fHeader.nofValues;
+    field.count = counts[i];
+    fHeader.nofValues += counts[i];
+  }
+
+  std::vector<char> header(kRecordHeaderSize, 0);
+  std::memcpy(&header[0], &fHeader, sizeof(fHeader));
+  std::fwrite(&header[0], 1, header.size(), fFile);
+  std::fflush(fFile);
+
+  fChunkSize = std::max(options.chunkSize, 1);
+  fNofChunkRecords = 0;
+  fChunk.assign(fChunkSize*fHeader.nofValues, 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRecordFile::Close()
+{
+  if ( ! IsOpen() ) return;
+
+  WriteChunk();
+  std::fclose(fFile);
+  fFile = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double* B4cRecordFile::NewRecord()
+{
+  G4double* record = &fChunk[fNofChunkRecords*fHeader.nofValues];
+  std::fill(record, record + fHeader.nofValues, 0.);
+  return record;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRecordFile::CommitRecord()
+{
+  if ( ++fNofChunkRecords == fChunkSize ) WriteChunk();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRecordFile::WriteChunk()
+{
+  if ( fNofChunkRecords == 0 ) return;
+
+  // The records reach the file before the header counts them
+  std::fwrite(&fChunk[0], sizeof(G4double), 
+              fNofChunkRecords*fHeader.nofValues, fFile);
+  std::fflush(fFile);
+
+  fHeader.nofRecords += fNofChunkRecords;
+  std::fseek(fFile, offsetof(B4cRecordHeader, nofRecords), SEEK_SET);
+  std::fwrite(&fHeader.nofRecords, sizeof(fHeader.nofRecords), 1, fFile);
+  std::fflush(fFile);
+  std::fseek(fFile, 0, SEEK_END);
+
+  fNofChunkRecords = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,220 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cRegionSettings.cc
+/// \brief Implementation of the B4cRegionSettings class
+
+#include "B4cRegionSettings.hh"
+
+#include "G4Region.hh"
+#include "G4LogicalVolume.hh"
+#include "G4ProductionCuts.hh"
+#include "G4UserLimits.hh"
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRegionSettings::B4cRegionSettings(const G4String& directory, 
+                                     const G4String& title,
+                                     G4double cut, G4double minEkin)
+ : G4VUserRegionInformation(),
+   fCuts(new G4ProductionCuts),
+   fLimits(new G4UserLimits(DBL_MAX, DBL_MAX, DBL_MAX, minEkin)),
+   fMessenger(0),
+   fName(directory),
+   fKillTime(DBL_MAX),
+   fDeferTime(DBL_MAX),
+   fKillEkin(0.),
+   fKillParticles(1, "neutron")
+{
+  fCuts->SetProductionCut(cut);
+
+  fMessenger = new G4GenericMessenger(this, directory, title);
+  fMessenger->DeclareMethodWithUnit("cut", "mm", 
+    &B4cRegionSettings::SetCut,
+    "Set the production cut of gammas, e-, e+ and protons in the region.")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareMethodWithUnit("maxStep", "mm", 
+    &B4cRegionSettings::SetMaxStep,
+    "Set the maximum step length in the region.")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareMethodWithUnit("maxTime", "ns", 
+    &B4cRegionSettings::SetMaxTime,
+    "Set the time after which the tracks are killed in the region.")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareMethodWithUnit("minEkin", "MeV", 
+    &B4cRegionSettings::SetMinEkin,
+    "Set the kinetic energy below which the tracks are killed in the region.")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareMethodWithUnit("killTime", "ns", 
+    &B4cRegionSettings::SetKillTime,
+    "Kill the secondaries created in the region after this time.")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareMethodWithUnit("deferTime", "ns", 
+    &B4cRegionSettings::SetDeferTime,
+    "Defer the secondaries created in the region after this time\n"
+    "to the waiting stack.")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareMethodWithUnit("killEkin", "MeV", 
+    &B4cRegionSettings::SetKillEkin,
+    "Kill the secondaries of the killParticles types created in the region\n"
+    "below this kinetic energy.")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareMethod("killParticles", 
+    &B4cRegionSettings::SetKillParticles,
+    "Set the particle types (names separated by spaces) subject to killEkin.")
+    .SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRegionSettings::~B4cRegionSettings()
+{
+  // The production cuts are kept: the material-cuts couples refer to them
+  // until the end of the job
+  delete fMessenger;
+  delete fLimits;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::Print() const
+{
+  G4cout 
+    << fName << ": cut " << GetCut()/mm << " mm, kill time "
+    << fKillTime/ns << " ns, defer time " << fDeferTime/ns 
+    << " ns, kill energy " << fKillEkin/MeV << " MeV for";
+  for ( size_t i=0; i<fKillParticles.size(); ++i ) {
+    G4cout << " " << fKillParticles[i];
+  }
+  G4cout << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::Apply(G4Region* region) const
+{
+  region->SetProductionCuts(fCuts);
+  // the region does not own its user information
+  region->SetUserInformation(const_cast<B4cRegionSettings*>(this));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::Apply(G4LogicalVolume* volume) const
+{
+  // the volume does not own its user limits
+  volume->SetUserLimits(fLimits);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::SetCut(G4double cut)
+{
+  if ( cut == fCuts->GetProductionCut(0) ) return;
+
+  fCuts->SetProductionCut(cut);
+  // the physics tables of the region materials are rebuilt for next run
+  G4RunManager::GetRunManager()->PhysicsHasBeenModified();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::SetMaxStep(G4double maxStep)
+{
+  fLimits->SetMaxAllowedStep(maxStep);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::SetMaxTime(G4double maxTime)
+{
+  fLimits->SetUserMaxTime(maxTime);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::SetMinEkin(G4double minEkin)
+{
+  fLimits->SetUserMinEkine(minEkin);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::SetKillTime(G4double killTime)
+{
+  fKillTime = killTime;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::SetDeferTime(G4double deferTime)
+{
+  fDeferTime = deferTime;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::SetKillEkin(G4double killEkin)
+{
+  fKillEkin = killEkin;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRegionSettings::SetKillParticles(const G4String& names)
+{
+  fKillParticles.clear();
+  std::istringstream input(names);
+  G4String name;
+  while ( input >> name ) fKillParticles.push_back(name);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cRegionSettings::IsKillParticle(
+                            const G4ParticleDefinition* particle) const
+{
+  return std::find(fKillParticles.begin(), fKillParticles.end(),
+                   particle->GetParticleName()) != fKillParticles.end();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cRegionSettings::GetCut() const
+{
+  return fCuts->GetProductionCut(0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,296 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cResponseSummary.cc
+/// \brief Implementation of the B4cResponseSummary class
+
+#include "B4cResponseSummary.hh"
+
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+  G4String GetParticleName(G4int pdg) 
+  {
+    G4ParticleDefinition* particle 
+      = G4ParticleTable::GetParticleTable()->FindParticle(pdg);
+    if ( particle ) return particle->GetParticleName();
+    std::ostringstream name;
+    name << "pdg" << pdg;
+    return name.str();
+  }
+
+  // e.g. "pi+_10GeV", as the species of a mixed run
+  G4String GetSpeciesName(const B4cRun::SpeciesKey& key) 
+  {
+    std::ostringstream name;
+    name << GetParticleName(key.pdg) << "_" << key.energy/GeV << "GeV";
+    return name.str();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cResponseSummary::Options::Options()
+ : json(false),
+   fileName("summary")
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cResponseSummary::Options& B4cResponseSummary::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cResponseSummary::B4cResponseSummary()
+ : fLastResponses()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cResponseSummary::~B4cResponseSummary()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cResponseSummary::Report(const B4cRun* run)
+{
+  const std::map<B4cRun::SpeciesKey, B4cRun::Response>& responses 
+    = run->GetResponses();
+  if ( responses.empty() ) return;
+
+  // the species of the last runs by particle type and energy only, the 
+  // mixture may change from one run to the next
+  std::map<B4cRun::SpeciesKey, B4cRun::Response>::const_iterator it;
+  for ( it = responses.begin(); it != responses.end(); ++it ) {
+    B4cRun::SpeciesKey key(-1, it->first.pdg, it->first.energy);
+    fLastResponses[key] = it->second;
+  }
+
+  Print(run);
+  if ( GetOptions().json ) WriteJson(run);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<G4double> B4cResponseSummary::GetEOverPiEnergies() const
+{
+  // the energies with both electrons (or positrons) and charged pions
+  std::vector<G4double> energies;
+  std::map<B4cRun::SpeciesKey, B4cRun::Response>::const_iterator it;
+  for ( it = fLastResponses.begin(); it != fLastResponses.end(); ++it ) {
+    G4double energy = it->first.energy;
+    if ( std::find(energies.begin(), energies.end(), energy) 
+           != energies.end() ) continue;
+    B4cRun::SpeciesKey electron(-1, 0, 0.), pion(-1, 0, 0.);
+    if ( FindEOverPi(energy, electron, pion) ) energies.push_back(energy);
+  }
+  std::sort(energies.begin(), energies.end());
+  return energies;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cResponseSummary::FindEOverPi(G4double energy,
+                                       B4cRun::SpeciesKey& electron, 
+                                       B4cRun::SpeciesKey& pion) const
+{
+  // electrons (or positrons) and charged pions of the last runs at the
+  // same energy
+  const G4int electrons[] = { 11, -11 };
+  const G4int pions[] = { 211, -211 };
+  electron.pdg = pion.pdg = 0;
+  for ( G4int i=1; i>=0; --i ) {
+    B4cRun::SpeciesKey key(-1, electrons[i], energy);
+    if ( fLastResponses.count(key) ) electron = key;
+    key.pdg = pions[i];
+    if ( fLastResponses.count(key) ) pion = key;
+  }
+  return electron.pdg && pion.pdg;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cResponseSummary::GetEOverPi(G4double energy, 
+                                      G4double& ratio, G4double& error,
+                                      B4cRun::SpeciesKey& electron, 
+                                      B4cRun::SpeciesKey& pion) const
+{
+  if ( ! FindEOverPi(energy, electron, pion) ) return false;
+
+  const B4cRunningStatistics& e = fLastResponses.at(electron).visible;
+  const B4cRunningStatistics& pi = fLastResponses.at(pion).visible;
+  if ( e.GetMean() <= 0. || pi.GetMean() <= 0. ) return false;
+
+  ratio = e.GetMean()/pi.GetMean();
+  G4double eError = e.GetMeanError()/e.GetMean();
+  G4double piError = pi.GetMeanError()/pi.GetMean();
+  error = ratio*std::sqrt(eError*eError + piError*piError);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cResponseSummary::Print(const B4cRun* run) const
+{
+  G4cout << " Response per species (visible = gap energy):" << G4endl;
+
+  const std::map<B4cRun::SpeciesKey, B4cRun::Response>& responses 
+    = run->GetResponses();
+  std::map<B4cRun::SpeciesKey, B4cRun::Response>::const_iterator it;
+  for ( it = responses.begin(); it != responses.end(); ++it ) {
+    const B4cRun::Response& response = it->second;
+    G4cout
+      << "  " << std::setw(8) << std::left << GetSpeciesName(it->first) 
+      << std::right << ": " << response.visible.GetN() << " events, E = "
+      << G4BestUnit(response.primaryEnergy.GetMean(), "Energy") << G4endl
+      << "            visible = " 
+      << G4BestUnit(response.visible.GetMean(), "Energy") << " +- "
+      << G4BestUnit(response.visible.GetMeanError(), "Energy")
+      << " sigma/E = " << response.visible.GetRelativeRms() << " +- "
+      << response.visible.GetRelativeRmsError() << G4endl
+      << "            total = " 
+      << G4BestUnit(response.total.GetMean(), "Energy") << " +- "
+      << G4BestUnit(response.total.GetMeanError(), "Energy")
+      << " sampling fraction = " << response.samplingFraction.GetMean() 
+      << " +- " << response.samplingFraction.GetMeanError() << G4endl;
+  }
+
+  std::vector<G4double> energies = GetEOverPiEnergies();
+  for ( size_t i=0; i<energies.size(); ++i ) {
+    G4double ratio, error;
+    B4cRun::SpeciesKey electron(-1, 0, 0.), pion(-1, 0, 0.);
+    if ( ! GetEOverPi(energies[i], ratio, error, electron, pion) ) continue;
+    G4cout
+      << " e/pi = " << ratio << " +- " << error << " ("
+      << GetSpeciesName(electron) << ", " << GetSpeciesName(pion) << ")" 
+      << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cResponseSummary::WriteStatistics(std::ostream& output, 
+                             const char* name,
+                             const B4cRunningStatistics& statistics) const
+{
+  output 
+    << "      \"" << name << "\": { \"mean\": " << statistics.GetMean()
+    << ", \"mean_error\": " << statistics.GetMeanError()
+    << ", \"rms\": " << statistics.GetRms()
+    << ", \"rms_error\": " << statistics.GetRmsError() << " },\n";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cResponseSummary::WriteJson(const B4cRun* run) const
+{
+  std::ostringstream fileName;
+  fileName << GetOptions().fileName << "_r" << run->GetRunID() << ".json";
+  std::ofstream output(fileName.str().c_str());
+  if ( ! output ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open " << fileName.str() 
+        << ", the response summary is not written.";
+    G4Exception("B4cResponseSummary::WriteJson()",
+      "MyCode0014", JustWarning, msg);
+    return;
+  }
+
+  // energies in MeV
+  output << std::setprecision(10);
+  output 
+    << "{\n"
+    << "  \"run\": " << run->GetRunID() << ",\n"
+    << "  \"events\": " << run->GetNumberOfEvent() << ",\n"
+    << "  \"species\": [";
+
+  const std::map<B4cRun::SpeciesKey, B4cRun::Response>& responses 
+    = run->GetResponses();
+  std::map<B4cRun::SpeciesKey, B4cRun::Response>::const_iterator it;
+  for ( it = responses.begin(); it != responses.end(); ++it ) {
+    const B4cRun::Response& response = it->second;
+    output
+      << ( it == responses.begin() ? "\n" : ",\n" )
+      << "    {\n"
+      << "      \"name\": \"" << GetSpeciesName(it->first) << "\",\n"
+      << "      \"mix_index\": " << it->first.species << ",\n"
+      << "      \"pdg\": " << it->first.pdg << ",\n"
+      << "      \"energy\": " << it->first.energy << ",\n"
+      << "      \"events\": " << response.visible.GetN() << ",\n"
+      << "      \"primary_energy\": " << response.primaryEnergy.GetMean() 
+      << ",\n";
+    WriteStatistics(output, "visible", response.visible);
+    WriteStatistics(output, "total", response.total);
+    WriteStatistics(output, "sampling_fraction", response.samplingFraction);
+    output
+      << "      \"resolution\": { \"value\": " 
+      << response.visible.GetRelativeRms() 
+      << ", \"error\": " << response.visible.GetRelativeRmsError() << " },\n"
+      << "      \"total_over_energy\": { \"bin_width\": 0.01, \"counts\": [";
+    for ( G4int i=0; i<B4cRun::kNofResponseBins; ++i ) {
+      output << ( i ? ", " : "" ) << response.histogram[i];
+    }
+    output 
+      << "], \"overflow\": " 
+      << response.histogram[B4cRun::kNofResponseBins] << " }\n"
+      << "    }";
+  }
+  output << "\n  ]";
+
+  // one entry per energy with both electrons and pions
+  output << ",\n  \"e_over_pi\": [";
+  std::vector<G4double> energies = GetEOverPiEnergies();
+  for ( size_t i=0; i<energies.size(); ++i ) {
+    G4double ratio, error;
+    B4cRun::SpeciesKey electron(-1, 0, 0.), pion(-1, 0, 0.);
+    if ( ! GetEOverPi(energies[i], ratio, error, electron, pion) ) continue;
+    output
+      << ( i ? ",\n" : "\n" )
+      << "    { \"energy\": " << energies[i] 
+      << ", \"value\": " << ratio << ", \"error\": " << error 
+      << ", \"electron\": \"" << GetSpeciesName(electron) 
+      << "\", \"pion\": \"" << GetSpeciesName(pion) << "\" }";
+  }
+  output << ( energies.empty() ? "]" : "\n  ]" );
+  output << "\n}\n";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
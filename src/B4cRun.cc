@@ -0,0 +1,196 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cRun.cc
+/// \brief Implementation of the B4cRun class
+
+#include "B4cRun.hh"
+
+#include <algorithm>
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRun::B4cRun(G4int nofEmLayers)
+ : G4Run(),
+   fNofRecorded(0),
+   fEmLayerEdep(nofEmLayers > 0 ? nofEmLayers : 0, 0.),
+   fNofTimedSDSteps(0.),
+   fTimedSDSeconds(0.),
+   fNofWriterRecords(0.),
+   fWriterDepthSum(0.),
+   fWriterMaxDepth(0.),
+   fNofWriterStalls(0.),
+   fWriterStallSeconds(0.),
+   fResponses(),
+   fVolumeSteps(),
+   fLastVolume(0),
+   fLastVolumeSteps(0)
+{
+  for ( G4int i=0; i<kNofQuantities; ++i ) {
+    fSum[i] = 0.;
+    fSum2[i] = 0.;
+  }
+  for ( G4int i=0; i<kNofRegions; ++i ) {
+    fNofRegionSteps[i] = 0.;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRun::~B4cRun()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRun::Merge(const G4Run* run)
+{
+  const B4cRun* localRun = static_cast<const B4cRun*>(run);
+
+  fNofRecorded += localRun->fNofRecorded;
+  for ( G4int i=0; i<kNofQuantities; ++i ) {
+    fSum[i]  += localRun->fSum[i];
+    fSum2[i] += localRun->fSum2[i];
+  }
+  for ( size_t i=0; i<fEmLayerEdep.size(); ++i ) {
+    fEmLayerEdep[i] += localRun->fEmLayerEdep[i];
+  }
+  fNofTimedSDSteps += localRun->fNofTimedSDSteps;
+  fTimedSDSeconds += localRun->fTimedSDSeconds;
+  for ( G4int i=0; i<kNofRegions; ++i ) {
+    fNofRegionSteps[i] += localRun->fNofRegionSteps[i];
+  }
+  fNofWriterRecords += localRun->fNofWriterRecords;
+  fWriterDepthSum += localRun->fWriterDepthSum;
+  fWriterMaxDepth = std::max(fWriterMaxDepth, localRun->fWriterMaxDepth);
+  fNofWriterStalls += localRun->fNofWriterStalls;
+  fWriterStallSeconds += localRun->fWriterStallSeconds;
+  std::map<SpeciesKey, Response>::const_iterator it;
+  for ( it = localRun->fResponses.begin(); 
+        it != localRun->fResponses.end(); ++it ) {
+    fResponses[it->first].Merge(it->second);
+  }
+
+  std::map<const G4LogicalVolume*, VolumeSteps>::const_iterator itv;
+  for ( itv = localRun->fVolumeSteps.begin(); 
+        itv != localRun->fVolumeSteps.end(); ++itv ) {
+    VolumeSteps& volumeSteps = fVolumeSteps[itv->first];
+    volumeSteps.steps += itv->second.steps;
+    volumeSteps.timedSteps += itv->second.timedSteps;
+    volumeSteps.seconds += itv->second.seconds;
+  }
+
+  G4Run::Merge(run);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRun::AddEvent(G4double absoEdep, G4double gapEdep, G4double hcalEdep)
+{
+  G4double values[kNofQuantities]
+    = { absoEdep, gapEdep, hcalEdep, absoEdep + gapEdep + hcalEdep };
+
+  for ( G4int i=0; i<kNofQuantities; ++i ) {
+    fSum[i]  += values[i];
+    fSum2[i] += values[i]*values[i];
+  }
+  ++fNofRecorded;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRun::AddResponse(const SpeciesKey& key, G4double primaryEnergy, 
+                         G4double absoEdep, G4double gapEdep,
+                         G4double hcalEdep)
+{
+  Response& response = fResponses[key];
+  G4double total = absoEdep + gapEdep + hcalEdep;
+  response.primaryEnergy.Add(primaryEnergy);
+  response.visible.Add(gapEdep);
+  response.total.Add(total);
+  if ( absoEdep + gapEdep > 0. ) {
+    response.samplingFraction.Add(gapEdep/(absoEdep + gapEdep));
+  }
+  if ( primaryEnergy > 0. ) {
+    G4int bin = G4int(total/primaryEnergy*100.);
+    response.histogram[std::min(std::max(bin, 0), G4int(kNofResponseBins))] 
+      += 1.;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRun::Response::Response()
+ : primaryEnergy(),
+   visible(),
+   total(),
+   samplingFraction()
+{
+  std::fill(histogram, histogram + kNofResponseBins + 1, 0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRun::Response::Merge(const Response& other)
+{
+  primaryEnergy.Merge(other.primaryEnergy);
+  visible.Merge(other.visible);
+  total.Merge(other.total);
+  samplingFraction.Merge(other.samplingFraction);
+  for ( G4int i=0; i<=kNofResponseBins; ++i ) {
+    histogram[i] += other.histogram[i];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cRun::GetMean(G4int quantity) const
+{
+  if ( ! fNofRecorded ) return 0.;
+  return fSum[quantity]/fNofRecorded;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cRun::GetRms(G4int quantity) const
+{
+  if ( ! fNofRecorded ) return 0.;
+  G4double mean = fSum[quantity]/fNofRecorded;
+  G4double rms2 = fSum2[quantity]/fNofRecorded - mean*mean;
+  return ( rms2 > 0. ) ? std::sqrt(rms2) : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* B4cRun::GetRegionName(G4int region)
+{
+  static const char* names[kNofRegions] 
+    = { "EMCalorimeter", "FeCalorimeter", "WCalorimeter", "other" };
+  return names[region];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,110 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cRunningStatistics.cc
+/// \brief Implementation of the B4cRunningStatistics class
+
+#include "B4cRunningStatistics.hh"
+
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRunningStatistics::B4cRunningStatistics()
+ : fN(0.),
+   fMean(0.),
+   fM2(0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cRunningStatistics::~B4cRunningStatistics()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRunningStatistics::Merge(const B4cRunningStatistics& other)
+{
+  if ( other.fN <= 0. ) return;
+
+  G4double n = fN + other.fN;
+  G4double delta = other.fMean - fMean;
+  fMean += delta*other.fN/n;
+  fM2 += other.fM2 + delta*delta*fN*other.fN/n;
+  fN = n;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cRunningStatistics::Reset()
+{
+  fN = 0.;
+  fMean = 0.;
+  fM2 = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cRunningStatistics::GetRms() const
+{
+  return std::sqrt(GetVariance());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cRunningStatistics::GetMeanError() const
+{
+  return ( fN > 0. ) ? GetRms()/std::sqrt(fN) : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cRunningStatistics::GetRmsError() const
+{
+  return ( fN > 1. ) ? GetRms()/std::sqrt(2.*(fN - 1.)) : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cRunningStatistics::GetRelativeRms() const
+{
+  return ( fMean != 0. ) ? GetRms()/std::fabs(fMean) : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4cRunningStatistics::GetRelativeRmsError() const
+{
+  // errors of the rms and of the mean combined
+  if ( fN <= 1. || fMean == 0. ) return 0.;
+  G4double relativeRms = GetRelativeRms();
+  return relativeRms 
+         *std::sqrt(1./(2.*(fN - 1.)) + relativeRms*relativeRms/fN);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
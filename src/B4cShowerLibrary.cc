@@ -0,0 +1,369 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cShowerLibrary.cc
+/// \brief Implementation of the B4cShowerLibrary class
+
+#include "B4cShowerLibrary.hh"
+
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <map>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  G4Mutex libraryMutex = G4MUTEX_INITIALIZER;
+  const char libraryMagic[8] = { 'B', '4', 'C', 'S', 'L', 'I', 'B', '1' };
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Owner of the mapped libraries. A file rewritten since it was mapped is
+/// mapped again; the previous mappings are kept until the end of the job
+/// as a worker may still hold them.
+
+class B4cShowerLibraryRegistry
+{
+  public:
+    ~B4cShowerLibraryRegistry() {
+      for ( size_t i=0; i<fLibraries.size(); ++i ) delete fLibraries[i];
+    }
+
+    const B4cShowerLibrary* Open(const G4String& fileName) {
+      struct stat status;
+      if ( stat(fileName.c_str(), &status) != 0 ) return 0;
+
+      Entry& entry = fEntries[fileName];
+      if ( entry.library && entry.modified == status.st_mtime && 
+           entry.size == status.st_size ) return entry.library;
+
+      B4cShowerLibrary* library = new B4cShowerLibrary(fileName);
+      if ( ! library->IsValid() ) {
+        delete library;
+        return 0;
+      }
+      fLibraries.push_back(library);
+      entry.library = library;
+      entry.modified = status.st_mtime;
+      entry.size = status.st_size;
+      return library;
+    }
+
+  private:
+    struct Entry {
+      Entry() : library(0), modified(0), size(0) {}
+      const B4cShowerLibrary* library;
+      time_t modified;
+      off_t  size;
+    };
+    std::map<G4String, Entry> fEntries;
+    std::vector<B4cShowerLibrary*> fLibraries;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const B4cShowerLibrary* B4cShowerLibrary::Open(const G4String& fileName)
+{
+  static B4cShowerLibraryRegistry registry;
+
+  G4AutoLock lock(&libraryMutex);
+  const B4cShowerLibrary* library = registry.Open(fileName);
+  if ( ! library ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot read the shower library " << fileName;
+    G4Exception("B4cShowerLibrary::Open()",
+      "MyCode0008", JustWarning, msg);
+  }
+  return library;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cShowerLibrary::Write(const G4String& fileName, 
+                               const G4String& geometry,
+                               G4int nofEnergyBins, 
+                               G4double minEnergy, G4double maxEnergy,
+                               const std::vector<RecordedShower>& showers)
+{
+  // Sort the showers by particle and energy bin
+  G4int nofBins = kNofParticles*nofEnergyBins;
+  std::vector< std::vector<const RecordedShower*> > binned(nofBins);
+  for ( size_t i=0; i<showers.size(); ++i ) {
+    G4int bin = GetEnergyBin(showers[i].energy, nofEnergyBins,
+                             minEnergy, maxEnergy);
+    if ( bin < 0 ) continue;
+    binned[showers[i].particle*nofEnergyBins + bin].push_back(&showers[i]);
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, libraryMagic, sizeof(header.magic));
+  header.nofParticles = kNofParticles;
+  header.nofEnergyBins = nofEnergyBins;
+  header.minEnergy = minEnergy/MeV;
+  header.maxEnergy = maxEnergy/MeV;
+  std::strncpy(header.geometry, geometry.c_str(), sizeof(header.geometry)-1);
+
+  std::vector<uint64_t> index(nofBins+1, 0);
+  std::vector<Shower> records;
+  for ( G4int bin=0; bin<nofBins; ++bin ) {
+    index[bin] = records.size();
+    for ( size_t i=0; i<binned[bin].size(); ++i ) {
+      Shower record;
+      record.energy = binned[bin][i]->energy/MeV;
+      record.firstSpot = header.nofSpots;
+      record.nofSpots = binned[bin][i]->spots.size();
+      record.reserved = 0;
+      records.push_back(record);
+      header.nofSpots += record.nofSpots;
+    }
+  }
+  index[nofBins] = records.size();
+  header.nofShowers = records.size();
+
+  // Write a new file and rename it, so that a mapping of the previous file
+  // stays valid
+  G4String tmpFileName = fileName + ".tmp";
+  std::ofstream output(tmpFileName, std::ios::binary);
+  output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  output.write(reinterpret_cast<const char*>(&index[0]), 
+               index.size()*sizeof(uint64_t));
+  if ( records.size() ) {
+    output.write(reinterpret_cast<const char*>(&records[0]), 
+                 records.size()*sizeof(Shower));
+  }
+  for ( G4int bin=0; bin<nofBins; ++bin ) {
+    for ( size_t i=0; i<binned[bin].size(); ++i ) {
+      const std::vector<Spot>& spots = binned[bin][i]->spots;
+      if ( ! spots.size() ) continue;
+      output.write(reinterpret_cast<const char*>(&spots[0]), 
+                   spots.size()*sizeof(Spot));
+    }
+  }
+  output.close();
+
+  if ( ! output || std::rename(tmpFileName.c_str(), fileName.c_str()) != 0 ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot write the shower library " << fileName;
+    G4Exception("B4cShowerLibrary::Write()",
+      "MyCode0027", JustWarning, msg);
+    return false;
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cShowerLibrary::GetParticleIndex(G4int pdgCode)
+{
+  switch ( pdgCode ) {
+    case 22:  return kGamma;
+    case 11:  return kElectron;
+    case -11: return kPositron;
+    default:  return -1;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cShowerLibrary::GetEnergyBin(G4double energy, G4int nofEnergyBins,
+                                     G4double minEnergy, G4double maxEnergy)
+{
+  if ( energy < minEnergy || energy >= maxEnergy ) return -1;
+  G4int bin 
+    = G4int(nofEnergyBins*std::log(energy/minEnergy)
+                         /std::log(maxEnergy/minEnergy));
+  return std::min(bin, nofEnergyBins-1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cShowerLibrary::B4cShowerLibrary(const G4String& fileName)
+ : fData(0),
+   fSize(0),
+   fHeader(0),
+   fIndex(0),
+   fShowers(0),
+   fSpots(0)
+{
+  int descriptor = open(fileName.c_str(), O_RDONLY);
+  if ( descriptor < 0 ) return;
+
+  struct stat status;
+  if ( fstat(descriptor, &status) == 0 && 
+       status.st_size >= off_t(sizeof(Header)) ) {
+    void* data 
+      = mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if ( data != MAP_FAILED ) {
+      fData = data;
+      fSize = status.st_size;
+    }
+  }
+  close(descriptor);
+  if ( ! fData ) return;
+
+  // Check the header
+  const char* bytes = static_cast<const char*>(fData);
+  const Header* header = reinterpret_cast<const Header*>(bytes);
+  if ( std::memcmp(header->magic, libraryMagic, sizeof(libraryMagic)) != 0 ||
+       header->nofParticles != kNofParticles ||
+       header->nofEnergyBins == 0 ||
+       ! ( header->minEnergy > 0. ) || 
+       ! ( header->maxEnergy > header->minEnergy ) ) {
+    G4ExceptionDescription msg;
+    msg << fileName << " is not a shower library or has an invalid header.";
+    G4Exception("B4cShowerLibrary::B4cShowerLibrary()",
+      "MyCode0023", JustWarning, msg);
+    return;
+  }
+
+  // Check the record counts against the file size, without overflow
+  uint64_t nofIndices = uint64_t(header->nofParticles)*header->nofEnergyBins + 1;
+  uint64_t remaining = fSize - sizeof(Header);
+  G4bool validSize = nofIndices <= remaining/sizeof(uint64_t);
+  if ( validSize ) {
+    remaining -= nofIndices*sizeof(uint64_t);
+    validSize = header->nofShowers <= remaining/sizeof(Shower);
+  }
+  if ( validSize ) {
+    remaining -= header->nofShowers*sizeof(Shower);
+    validSize = remaining % sizeof(Spot) == 0 && 
+                header->nofSpots == remaining/sizeof(Spot);
+  }
+  if ( ! validSize ) {
+    G4ExceptionDescription msg;
+    msg << "The size of the shower library " << fileName 
+        << " does not match its header (" << header->nofShowers 
+        << " showers, " << header->nofSpots << " spots): " << fSize 
+        << " bytes.";
+    G4Exception("B4cShowerLibrary::B4cShowerLibrary()",
+      "MyCode0024", JustWarning, msg);
+    return;
+  }
+  const uint64_t* index 
+    = reinterpret_cast<const uint64_t*>(bytes + sizeof(Header));
+  const Shower* showers = reinterpret_cast<const Shower*>(index + nofIndices);
+  const Spot* spots = reinterpret_cast<const Spot*>(showers + header->nofShowers);
+
+  // The index must cover the showers in order: the showers of each 
+  // (particle, energy bin) lie between two consecutive entries
+  G4bool validIndex 
+    = index[0] == 0 && index[nofIndices-1] == header->nofShowers;
+  for ( uint64_t i=1; validIndex && i<nofIndices; ++i ) {
+    validIndex = index[i] >= index[i-1];
+  }
+  if ( ! validIndex ) {
+    G4ExceptionDescription msg;
+    msg << "The index of the shower library " << fileName 
+        << " does not cover its " << header->nofShowers << " showers.";
+    G4Exception("B4cShowerLibrary::B4cShowerLibrary()",
+      "MyCode0025", JustWarning, msg);
+    return;
+  }
+
+  // The spots of each shower must lie in the spot records
+  for ( uint64_t i=0; i<header->nofShowers; ++i ) {
+    if ( showers[i].firstSpot > header->nofSpots ||
+         showers[i].nofSpots > header->nofSpots - showers[i].firstSpot ) {
+      G4ExceptionDescription msg;
+      msg << "Shower " << i << " of the shower library " << fileName 
+          << " refers to spots beyond the " << header->nofSpots 
+          << " spots of the file.";
+      G4Exception("B4cShowerLibrary::B4cShowerLibrary()",
+        "MyCode0026", JustWarning, msg);
+      return;
+    }
+  }
+
+  fHeader = header;
+  fIndex = index;
+  fShowers = showers;
+  fSpots = spots;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cShowerLibrary::~B4cShowerLibrary()
+{
+  if ( fData ) munmap(fData, fSize);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cShowerLibrary::IsValid() const
+{
+  return fHeader != 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cShowerLibrary::HasShowers(G4int particle, G4double energy) const
+{
+  G4int bin = GetEnergyBin(energy, fHeader->nofEnergyBins,
+                           fHeader->minEnergy*MeV, fHeader->maxEnergy*MeV);
+  if ( particle < 0 || bin < 0 ) return false;
+  G4int index = particle*fHeader->nofEnergyBins + bin;
+  return fIndex[index+1] > fIndex[index];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const B4cShowerLibrary::Shower* 
+B4cShowerLibrary::FindShower(G4int particle, G4double energy, 
+                             G4double random) const
+{
+  G4int bin = GetEnergyBin(energy, fHeader->nofEnergyBins,
+                           fHeader->minEnergy*MeV, fHeader->maxEnergy*MeV);
+  if ( particle < 0 || bin < 0 ) return 0;
+  G4int index = particle*fHeader->nofEnergyBins + bin;
+  uint64_t nofShowers = fIndex[index+1] - fIndex[index];
+  if ( ! nofShowers ) return 0;
+
+  uint64_t shower = std::min(uint64_t(random*nofShowers), nofShowers-1);
+  return fShowers + fIndex[index] + shower;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String B4cShowerLibrary::GetGeometry() const
+{
+  return std::string(fHeader->geometry, 
+                     strnlen(fHeader->geometry, sizeof(fHeader->geometry)));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,325 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cShowerLibraryModel.cc
+/// \brief Implementation of the B4cShowerLibraryModel class
+
+#include "B4cShowerLibraryModel.hh"
+#include "B4cShowerLibraryRecorder.hh"
+#include "B4cCalorimeterSD.hh"
+
+#include "G4FastTrack.hh"
+#include "G4FastStep.hh"
+#include "G4FastSimulationManager.hh"
+#include "G4Region.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4Navigator.hh"
+#include "G4TransportationManager.hh"
+#include "G4TouchableHistory.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Track.hh"
+#include "G4Step.hh"
+#include "G4Run.hh"
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cShowerLibraryModel::Options::Options()
+ : mode(kOff),
+   fileName("showers.lib"),
+   maxEnergy(10.*MeV),
+   minEnergy(0.1*MeV),
+   nofEnergyBins(20),
+   maxShowersPerBin(200),
+   spotSize(1.*mm)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryModel::Options::SetMode(const G4String& value)
+{
+  if      ( value == "off" )      mode = kOff;
+  else if ( value == "replay" )   mode = kReplay;
+  else if ( value == "record" )   mode = kRecord;
+  else if ( value == "validate" ) mode = kValidate;
+  else {
+    G4ExceptionDescription msg;
+    msg << "Unknown shower library mode " << value << ", mode unchanged.";
+    G4Exception("B4cShowerLibraryModel::Options::SetMode()",
+      "MyCode0028", JustWarning, msg);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cShowerLibraryModel::Options& B4cShowerLibraryModel::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal B4cShowerLibraryModel* B4cShowerLibraryModel::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cShowerLibraryModel::B4cShowerLibraryModel(const G4String& name)
+ : G4VFastSimulationModel(name),
+   fEnvelopes(),
+   fAbsorberLV(0),
+   fTungstenLV(0),
+   fLibrary(0),
+   fLibraryRunID(-1),
+   fNavigator(new G4Navigator()),
+   fTouchable(new G4TouchableHistory())
+{
+  fgInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cShowerLibraryModel::~B4cShowerLibraryModel()
+{
+  delete fTouchable;
+  delete fNavigator;
+  if ( fgInstance == this ) fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryModel::AddEnvelope(G4Region* region)
+{
+  // The fast simulation manager of a region is thread-local and kept when
+  // the geometry is rebuilt
+  if ( ! region || fEnvelopes.count(region) ) return;
+
+  G4FastSimulationManager* manager = region->GetFastSimulationManager();
+  if ( ! manager ) manager = new G4FastSimulationManager(region);
+  manager->AddFastSimulationModel(this);
+  fEnvelopes.insert(region);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryModel::SetTriggerVolumes(G4LogicalVolume* absorberLV, 
+                                              G4LogicalVolume* tungstenLV)
+{
+  fAbsorberLV = absorberLV;
+  fTungstenLV = tungstenLV;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cShowerLibraryModel::IsApplicable(
+                                     const G4ParticleDefinition& particle)
+{
+  return B4cShowerLibrary::GetParticleIndex(particle.GetPDGEncoding()) >= 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cShowerLibraryModel::IsTriggered(const G4LogicalVolume* volume,
+                                          G4double energy) const
+{
+  return energy < GetOptions().maxEnergy && 
+         ( volume == fAbsorberLV || volume == fTungstenLV );
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cShowerLibraryModel::ModelTrigger(const G4FastTrack& fastTrack)
+{
+  // Only the replay is a fast simulation, the record and validation
+  // showers are started by the stepping action
+  if ( GetOptions().mode != kReplay ) return false;
+
+  const G4Track* track = fastTrack.GetPrimaryTrack();
+  G4double energy = track->GetKineticEnergy();
+  if ( ! IsTriggered(track->GetVolume()->GetLogicalVolume(), energy) ) {
+    return false;
+  }
+
+  G4int particle 
+    = B4cShowerLibrary::GetParticleIndex(
+        track->GetDefinition()->GetPDGEncoding());
+  const B4cShowerLibrary* library = GetLibrary();
+  return library && library->HasShowers(particle, energy);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryModel::StartShower(const G4Step* step)
+{
+  const Options& options = GetOptions();
+  if ( options.mode != kRecord && options.mode != kValidate ) return;
+
+  // The particle before the step, as seen by a trigger
+  const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+  G4double energy = preStepPoint->GetKineticEnergy();
+  if ( ! IsTriggered(
+           preStepPoint->GetPhysicalVolume()->GetLogicalVolume(), energy) ) {
+    return;
+  }
+
+  G4int particle 
+    = B4cShowerLibrary::GetParticleIndex(
+        step->GetTrack()->GetDefinition()->GetPDGEncoding());
+  if ( particle < 0 ) return;
+
+  // The particle is tracked, its shower is followed by the recorder of 
+  // this thread
+  B4cShowerLibraryRecorder* recorder 
+    = B4cShowerLibraryRecorder::GetInstance();
+  if ( ! recorder || recorder->IsInShower(step) ) return;
+
+  if ( options.mode == kRecord ) {
+    recorder->StartShower(step, particle);
+  }
+  else {
+    const B4cShowerLibrary* library = GetLibrary();
+    if ( ! library || ! library->HasShowers(particle, energy) ) return;
+    if ( recorder->StartShower(step, particle) ) {
+      DepositShower(library, 
+        library->FindShower(particle, energy, G4UniformRand()),
+        energy, preStepPoint->GetPosition(), 
+        preStepPoint->GetMomentumDirection(), true);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryModel::DoIt(const G4FastTrack& fastTrack, 
+                                 G4FastStep& fastStep)
+{
+  const G4Track* track = fastTrack.GetPrimaryTrack();
+  G4double energy = track->GetKineticEnergy();
+  G4int particle 
+    = B4cShowerLibrary::GetParticleIndex(
+        track->GetDefinition()->GetPDGEncoding());
+
+  DepositShower(fLibrary, 
+    fLibrary->FindShower(particle, energy, G4UniformRand()),
+    energy, track->GetPosition(), track->GetMomentumDirection(), false);
+
+  // The energy is deposited by the spots directly in the SDs
+  fastStep.KillPrimaryTrack();
+  fastStep.ProposePrimaryTrackPathLength(0.);
+  fastStep.ProposeTotalEnergyDeposited(0.);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const B4cShowerLibrary* B4cShowerLibraryModel::GetLibrary()
+{
+  // The library file is (re)opened once per run
+  G4int runID = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+  if ( runID == fLibraryRunID ) return fLibrary;
+
+  fLibraryRunID = runID;
+  fLibrary = B4cShowerLibrary::Open(GetOptions().fileName);
+  if ( fLibrary && 
+       fLibrary->GetGeometry() 
+         != B4cShowerLibraryRecorder::GetGeometryDescription() ) {
+    G4ExceptionDescription msg;
+    msg << "The shower library " << GetOptions().fileName 
+        << " was recorded with another geometry:" << G4endl
+        << "  " << fLibrary->GetGeometry();
+    G4Exception("B4cShowerLibraryModel::GetLibrary()",
+      "MyCode0029", JustWarning, msg);
+  }
+  return fLibrary;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryModel::DepositShower(
+                                   const B4cShowerLibrary* library,
+                                   const B4cShowerLibrary::Shower* shower,
+                                   G4double energy,
+                                   const G4ThreeVector& position,
+                                   const G4ThreeVector& direction,
+                                   G4bool validation)
+{
+  if ( ! shower ) return;
+
+  // Shower frame along the particle direction, with a random azimuth
+  G4ThreeVector w = direction;
+  G4ThreeVector u0 = w.orthogonal().unit();
+  G4ThreeVector v0 = w.cross(u0);
+  G4double phi = twopi*G4UniformRand();
+  G4double cosPhi = std::cos(phi);
+  G4double sinPhi = std::sin(phi);
+  G4ThreeVector u = cosPhi*u0 + sinPhi*v0;
+  G4ThreeVector v = cosPhi*v0 - sinPhi*u0;
+
+  // The world may have been rebuilt since the previous shower
+  G4VPhysicalVolume* world 
+    = G4TransportationManager::GetTransportationManager()
+        ->GetNavigatorForTracking()->GetWorldVolume();
+  if ( fNavigator->GetWorldVolume() != world ) {
+    fNavigator->SetWorldVolume(world);
+  }
+
+  B4cShowerLibraryRecorder* recorder 
+    = B4cShowerLibraryRecorder::GetInstance();
+
+  const B4cShowerLibrary::Spot* spots = library->GetSpots(shower);
+  for ( uint32_t i=0; i<shower->nofSpots; ++i ) {
+    const B4cShowerLibrary::Spot& spot = spots[i];
+    G4ThreeVector spotPosition 
+      = position + spot.x*mm*u + spot.y*mm*v + spot.z*mm*w;
+    G4double edep = spot.fraction*energy;
+
+    // The spots of a shower are close: start the search from the previous
+    // one
+    fNavigator->LocateGlobalPointAndUpdateTouchable(
+      spotPosition, fTouchable, i > 0);
+    G4VPhysicalVolume* volume = fTouchable->GetVolume();
+    if ( ! volume ) continue;
+
+    B4cCalorimeterSD* calorSD 
+      = dynamic_cast<B4cCalorimeterSD*>(
+          volume->GetLogicalVolume()->GetSensitiveDetector());
+    if ( ! calorSD ) continue;
+
+    if ( validation ) {
+      recorder->AddLibraryDeposit(calorSD, fTouchable, edep);
+    }
+    else {
+      calorSD->AddSpot(edep, spotPosition, fTouchable);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
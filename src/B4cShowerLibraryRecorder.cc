@@ -0,0 +1,421 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+// $Id$
+//
+/// \file B4cShowerLibraryRecorder.cc
+/// \brief Implementation of the B4cShowerLibraryRecorder class
+
+#include "B4cShowerLibraryRecorder.hh"
+#include "B4cShowerLibraryModel.hh"
+#include "B4cCalorimeterSD.hh"
+#include "B4cDetectorConstruction.hh"
+
+#include "G4Step.hh"
+#include "G4StepPoint.hh"
+#include "G4Track.hh"
+#include "G4VTouchable.hh"
+#include "G4RunManager.hh"
+#include "G4AutoLock.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace {
+  // Data of all threads, merged at the end of run
+  G4Mutex recorderMutex = G4MUTEX_INITIALIZER;
+  std::vector<B4cShowerLibrary::RecordedShower> mergedShowers;
+  std::map<G4String, std::vector<G4double> > mergedFullProfiles;
+  std::map<G4String, std::vector<G4double> > mergedLibraryProfiles;
+  G4int mergedNofValidatedShowers = 0;
+
+  void MergeProfiles(const std::map<G4String, std::vector<G4double> >& from,
+                     std::map<G4String, std::vector<G4double> >& to) {
+    std::map<G4String, std::vector<G4double> >::const_iterator it;
+    for ( it = from.begin(); it != from.end(); ++it ) {
+      std::vector<G4double>& profile = to[it->first];
+      if ( profile.size() < it->second.size() ) {
+        profile.resize(it->second.size(), 0.);
+      }
+      for ( size_t i=0; i<it->second.size(); ++i ) profile[i] += it->second[i];
+    }
+  }
+
+  // Clusters of the recorded showers: 21 bits per voxel index
+  const G4long voxelOffset = 1L << 20;
+  G4long VoxelKey(G4double x, G4double y, G4double z, G4double size) {
+    G4long ix = std::floor(x/size) + voxelOffset;
+    G4long iy = std::floor(y/size) + voxelOffset;
+    G4long iz = std::floor(z/size) + voxelOffset;
+    const G4long maxIndex = 2*voxelOffset - 1;
+    ix = std::min(std::max(ix, 0L), maxIndex);
+    iy = std::min(std::max(iy, 0L), maxIndex);
+    iz = std::min(std::max(iz, 0L), maxIndex);
+    return ( ix << 42 ) | ( iy << 21 ) | iz;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal 
+B4cShowerLibraryRecorder* B4cShowerLibraryRecorder::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cShowerLibraryRecorder::B4cShowerLibraryRecorder()
+ : fShowerOfTrack(),
+   fShowers(),
+   fRecorded(),
+   fNofRecordedPerBin(),
+   fNofValidatedShowers(0),
+   fFullProfiles(),
+   fLibraryProfiles()
+{
+  fgInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cShowerLibraryRecorder::~B4cShowerLibraryRecorder()
+{
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String B4cShowerLibraryRecorder::GetGeometryDescription()
+{
+  const B4cDetectorConstruction* construct
+    = static_cast<const B4cDetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+
+  std::ostringstream description;
+  description 
+    << "em " << construct->GetNumberOfLayers() << " x [" 
+    << construct->GetAbsorberThickness()/mm << " + " 
+    << construct->GetGapThickness()/mm << "] mm, fe " 
+    << construct->GetNumberOfFeLayers() << ", w "
+    << construct->GetNumberOfWLayers() << " x " 
+    << construct->GetHadLayerThickness()/mm << " mm, xy "
+    << construct->GetCalorimeterSizeXY()/mm << " mm";
+  return description.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryRecorder::RecordStep(const G4Step* step)
+{
+  if ( fShowers.empty() ) return;
+
+  G4int mode = B4cShowerLibraryModel::GetOptions().mode;
+  if ( mode != B4cShowerLibraryModel::kRecord && 
+       mode != B4cShowerLibraryModel::kValidate ) return;
+
+  const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+  G4int index = FindShower(step->GetTrack(), preStepPoint->GetGlobalTime());
+  if ( index < 0 ) return;
+
+  G4double edep = step->GetTotalEnergyDeposit();
+  if ( edep <= 0. ) return;
+
+  if ( mode == B4cShowerLibraryModel::kRecord ) {
+    AddSpot(fShowers[index], preStepPoint->GetPosition(), edep);
+  }
+  else {
+    const B4cCalorimeterSD* calorSD 
+      = dynamic_cast<const B4cCalorimeterSD*>(
+          preStepPoint->GetSensitiveDetector());
+    if ( calorSD ) {
+      AddDeposit(fFullProfiles, calorSD, preStepPoint->GetTouchable(), edep);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cShowerLibraryRecorder::FindShower(const G4Track* track,
+                                           G4double creationTime)
+{
+  std::unordered_map<G4int, G4int>::const_iterator it 
+    = fShowerOfTrack.find(track->GetTrackID());
+  if ( it != fShowerOfTrack.end() ) return it->second;
+
+  // A track joins the shower of its parent at its first step, if it was
+  // created after the start of the shower
+  if ( track->GetCurrentStepNumber() != 1 ) return -1;
+  it = fShowerOfTrack.find(track->GetParentID());
+  if ( it == fShowerOfTrack.end() ) return -1;
+  if ( creationTime <= fShowers[it->second].startTime ) return -1;
+
+  G4int index = it->second;
+  fShowerOfTrack[track->GetTrackID()] = index;
+  return index;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cShowerLibraryRecorder::IsInShower(const G4Step* step)
+{
+  // The pre-step time is the one of the track creation at its first step
+  return FindShower(step->GetTrack(), 
+                    step->GetPreStepPoint()->GetGlobalTime()) >= 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4cShowerLibraryRecorder::StartShower(const G4Step* step, 
+                                             G4int particle)
+{
+  const B4cShowerLibraryModel::Options& options 
+    = B4cShowerLibraryModel::GetOptions();
+  const G4StepPoint* preStepPoint = step->GetPreStepPoint();
+  G4double energy = preStepPoint->GetKineticEnergy();
+
+  if ( options.mode == B4cShowerLibraryModel::kRecord ) {
+    G4int bin 
+      = B4cShowerLibrary::GetEnergyBin(energy, options.nofEnergyBins,
+                                       options.minEnergy, options.maxEnergy);
+    if ( particle < 0 || bin < 0 ) return false;
+    
+    size_t nofBins = B4cShowerLibrary::kNofParticles*options.nofEnergyBins;
+    if ( fNofRecordedPerBin.size() != nofBins ) {
+      fNofRecordedPerBin.assign(nofBins, 0);
+    }
+    G4int& nofRecorded 
+      = fNofRecordedPerBin[particle*options.nofEnergyBins + bin];
+    if ( nofRecorded >= options.maxShowersPerBin ) return false;
+    ++nofRecorded;
+  }
+  else {
+    ++fNofValidatedShowers;
+  }
+
+  ShowerInProgress shower;
+  shower.particle = particle;
+  shower.energy = energy;
+  shower.startTime = preStepPoint->GetGlobalTime();
+  shower.origin = preStepPoint->GetPosition();
+  shower.w = preStepPoint->GetMomentumDirection();
+  shower.u = shower.w.orthogonal().unit();
+  shower.v = shower.w.cross(shower.u);
+
+  fShowerOfTrack[step->GetTrack()->GetTrackID()] = fShowers.size();
+  fShowers.push_back(shower);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryRecorder::AddLibraryDeposit(
+                                          const B4cCalorimeterSD* calorSD,
+                                          const G4VTouchable* touchable,
+                                          G4double edep)
+{
+  AddDeposit(fLibraryProfiles, calorSD, touchable, edep);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryRecorder::AddDeposit(Profiles& profiles,
+                                          const B4cCalorimeterSD* calorSD,
+                                          const G4VTouchable* touchable,
+                                          G4double edep)
+{
+  G4int layer = touchable->GetReplicaNumber(1);
+  if ( layer < 0 ) return;
+
+  std::vector<G4double>& profile = profiles[calorSD->GetName()];
+  if ( G4int(profile.size()) <= layer ) profile.resize(layer+1, 0.);
+  profile[layer] += edep;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryRecorder::AddSpot(ShowerInProgress& shower, 
+                                       const G4ThreeVector& position,
+                                       G4double edep)
+{
+  G4ThreeVector relative = position - shower.origin;
+  G4double x = relative.dot(shower.u);
+  G4double y = relative.dot(shower.v);
+  G4double z = relative.dot(shower.w);
+
+  G4long key 
+    = VoxelKey(x, y, z, B4cShowerLibraryModel::GetOptions().spotSize);
+  std::unordered_map<G4long, G4int>::iterator it 
+    = shower.spotOfVoxel.find(key);
+  G4int spot;
+  if ( it != shower.spotOfVoxel.end() ) {
+    spot = it->second;
+  }
+  else {
+    spot = shower.spotSums.size()/4;
+    shower.spotOfVoxel[key] = spot;
+    shower.spotSums.resize(shower.spotSums.size() + 4, 0.);
+  }
+
+  // Energy-weighted centre of the cluster
+  G4double* sums = &shower.spotSums[4*spot];
+  sums[0] += edep;
+  sums[1] += edep*x;
+  sums[2] += edep*y;
+  sums[3] += edep*z;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryRecorder::EndOfEvent()
+{
+  if ( B4cShowerLibraryModel::GetOptions().mode 
+         == B4cShowerLibraryModel::kRecord ) {
+    for ( size_t i=0; i<fShowers.size(); ++i ) {
+      const ShowerInProgress& shower = fShowers[i];
+      B4cShowerLibrary::RecordedShower recorded;
+      recorded.particle = shower.particle;
+      recorded.energy = shower.energy;
+      G4int nofSpots = shower.spotSums.size()/4;
+      recorded.spots.resize(nofSpots);
+      for ( G4int j=0; j<nofSpots; ++j ) {
+        const G4double* sums = &shower.spotSums[4*j];
+        B4cShowerLibrary::Spot& spot = recorded.spots[j];
+        spot.x = sums[1]/sums[0]/mm;
+        spot.y = sums[2]/sums[0]/mm;
+        spot.z = sums[3]/sums[0]/mm;
+        spot.fraction = sums[0]/shower.energy;
+      }
+      fRecorded.push_back(recorded);
+    }
+  }
+
+  fShowers.clear();
+  fShowerOfTrack.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryRecorder::EndOfRun()
+{
+  G4AutoLock lock(&recorderMutex);
+  mergedShowers.insert(mergedShowers.end(), fRecorded.begin(), fRecorded.end());
+  MergeProfiles(fFullProfiles, mergedFullProfiles);
+  MergeProfiles(fLibraryProfiles, mergedLibraryProfiles);
+  mergedNofValidatedShowers += fNofValidatedShowers;
+
+  fRecorded.clear();
+  fNofRecordedPerBin.clear();
+  fFullProfiles.clear();
+  fLibraryProfiles.clear();
+  fNofValidatedShowers = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cShowerLibraryRecorder::WriteResults()
+{
+  const B4cShowerLibraryModel::Options& options 
+    = B4cShowerLibraryModel::GetOptions();
+
+  G4AutoLock lock(&recorderMutex);
+
+  if ( options.mode == B4cShowerLibraryModel::kRecord ) {
+    if ( B4cShowerLibrary::Write(options.fileName, GetGeometryDescription(),
+                                 options.nofEnergyBins, 
+                                 options.minEnergy, options.maxEnergy,
+                                 mergedShowers) ) {
+      G4cout
+        << G4endl
+        << "---> Shower library: " << mergedShowers.size()
+        << " showers written in " << options.fileName << G4endl;
+    }
+  }
+
+  if ( options.mode == B4cShowerLibraryModel::kValidate ) {
+    G4cout
+      << G4endl
+      << "--------------------Shower library validation------------------"
+      << G4endl
+      << " " << mergedNofValidatedShowers << " showers from " 
+      << options.fileName << " compared with the full simulation" << G4endl
+      << std::setw(12) << "detector" << std::setw(7) << "layer" 
+      << std::setw(14) << "full (MeV)" << std::setw(14) << "library (MeV)"
+      << std::setw(12) << "deviation" << G4endl;
+
+    G4double fullTotal = 0.;
+    G4double libraryTotal = 0.;
+    std::map<G4String, std::vector<G4double> >::iterator it;
+    for ( it = mergedFullProfiles.begin(); 
+          it != mergedFullProfiles.end(); ++it ) {
+      std::vector<G4double>& full = it->second;
+      std::vector<G4double>& library = mergedLibraryProfiles[it->first];
+      size_t nofLayers = std::max(full.size(), library.size());
+      full.resize(nofLayers, 0.);
+      library.resize(nofLayers, 0.);
+      for ( size_t i=0; i<nofLayers; ++i ) {
+        if ( full[i] <= 0. && library[i] <= 0. ) continue;
+        G4cout 
+          << std::setw(12) << it->first << std::setw(7) << i
+          << std::setw(14) << full[i]/MeV << std::setw(14) << library[i]/MeV;
+        if ( full[i] > 0. ) {
+          G4cout << std::setw(11) << 100.*(library[i] - full[i])/full[i] 
+                 << "%";
+        }
+        G4cout << G4endl;
+        fullTotal += full[i];
+        libraryTotal += library[i];
+      }
+    }
+    // deposits of the library only
+    for ( it = mergedLibraryProfiles.begin(); 
+          it != mergedLibraryProfiles.end(); ++it ) {
+      if ( mergedFullProfiles.count(it->first) ) continue;
+      for ( size_t i=0; i<it->second.size(); ++i ) {
+        libraryTotal += it->second[i];
+      }
+    }
+
+    G4cout << std::setw(19) << "total" 
+           << std::setw(14) << fullTotal/MeV 
+           << std::setw(14) << libraryTotal/MeV;
+    if ( fullTotal > 0. ) {
+      G4cout << std::setw(11) << 100.*(libraryTotal - fullTotal)/fullTotal 
+             << "%";
+    }
+    G4cout << G4endl
+      << "---------------------------------------------------------------"
+      << G4endl;
+  }
+
+  mergedShowers.clear();
+  mergedFullProfiles.clear();
+  mergedLibraryProfiles.clear();
+  mergedNofValidatedShowers = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
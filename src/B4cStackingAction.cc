@@ -0,0 +1,114 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cStackingAction.cc
+/// \brief Implementation of the B4cStackingAction class
+
+#include "B4cStackingAction.hh"
+#include "B4cRegionSettings.hh"
+#include "B4cPileUp.hh"
+
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Region.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal B4cStackingAction* B4cStackingAction::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cStackingAction::B4cStackingAction()
+ : G4UserStackingAction()
+{
+  for ( G4int i=0; i<kNofCuts; ++i ) {
+    fKilledEnergy[i] = 0.;
+  }
+  fgInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cStackingAction::~B4cStackingAction()
+{
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ClassificationOfNewTrack 
+B4cStackingAction::ClassifyNewTrack(const G4Track* track)
+{
+  // primary of origin of the track, for the pile-up bookkeeping
+  B4cPileUp* pileUp = B4cPileUp::GetInstance();
+  if ( pileUp && B4cPileUp::IsEnabled() ) {
+    pileUp->RecordTrack(track->GetTrackID(), track->GetParentID());
+  }
+
+  if ( track->GetParentID() == 0 ) return fUrgent;
+
+  // The secondaries have the touchable of their creation point
+  const G4VPhysicalVolume* volume = track->GetVolume();
+  if ( ! volume ) return fUrgent;
+
+  const B4cRegionSettings* settings 
+    = dynamic_cast<const B4cRegionSettings*>(
+        volume->GetLogicalVolume()->GetRegion()->GetUserInformation());
+  if ( ! settings ) return fUrgent;
+
+  G4double time = track->GetGlobalTime();
+  if ( time > settings->GetKillTime() ) {
+    fKilledEnergy[kTimeCut] += track->GetKineticEnergy();
+    return fKill;
+  }
+
+  if ( track->GetKineticEnergy() < settings->GetKillEkin() &&
+       settings->IsKillParticle(track->GetDefinition()) ) {
+    fKilledEnergy[kEnergyCut] += track->GetKineticEnergy();
+    return fKill;
+  }
+
+  if ( time > settings->GetDeferTime() ) return fWaiting;
+
+  return fUrgent;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cStackingAction::PrepareNewEvent()
+{
+  for ( G4int i=0; i<kNofCuts; ++i ) {
+    fKilledEnergy[i] = 0.;
+  }
+
+  B4cPileUp* pileUp = B4cPileUp::GetInstance();
+  if ( pileUp ) pileUp->PrepareNewEvent();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
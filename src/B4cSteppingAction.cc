@@ -0,0 +1,120 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cSteppingAction.cc
+/// \brief Implementation of the B4cSteppingAction class
+
+#include "B4cSteppingAction.hh"
+#include "B4cShowerLibraryRecorder.hh"
+#include "B4cShowerLibraryModel.hh"
+#include "B4cRun.hh"
+
+#include "G4Step.hh"
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4Region.hh"
+#include "G4RunManager.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cSteppingAction::Options& B4cSteppingAction::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cSteppingAction::B4cSteppingAction(B4cShowerLibraryRecorder* recorder)
+ : G4UserSteppingAction(),
+   fRecorder(recorder),
+   fLastRegion(0),
+   fLastIndex(B4cRun::kOtherRegion),
+   fLastTime()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cSteppingAction::~B4cSteppingAction()
+{
+  delete fRecorder;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4cSteppingAction::GetRegionIndex(const G4Region* region) const
+{
+  for ( G4int i=0; i<B4cRun::kOtherRegion; ++i ) {
+    if ( region->GetName() == B4cRun::GetRegionName(i) ) return i;
+  }
+  return B4cRun::kOtherRegion;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cSteppingAction::UserSteppingAction(const G4Step* step)
+{
+  // Count the step in the region of its volume; the region names are 
+  // compared only when the region changes
+  const G4LogicalVolume* volume 
+    = step->GetPreStepPoint()->GetPhysicalVolume()->GetLogicalVolume();
+  const G4Region* region = volume->GetRegion();
+  if ( region != fLastRegion ) {
+    fLastRegion = region;
+    fLastIndex = GetRegionIndex(region);
+  }
+  B4cRun* run 
+    = static_cast<B4cRun*>(
+        G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  run->AddRegionStep(fLastIndex);
+
+  // Navigation benchmark: the time since the previous step goes to the
+  // volume of this one, unless the track has just started
+  if ( GetOptions().timing ) {
+    std::chrono::steady_clock::time_point now 
+      = std::chrono::steady_clock::now();
+    if ( step->GetTrack()->GetCurrentStepNumber() > 1 ) {
+      std::chrono::duration<double> elapsed = now - fLastTime;
+      run->AddVolumeStep(volume, elapsed.count(), true);
+    }
+    else {
+      run->AddVolumeStep(volume, 0., false);
+    }
+    fLastTime = now;
+  }
+
+  // Shower library record and validation: a shower started at this step
+  // includes its deposits
+  if ( fRecorder ) {
+    B4cShowerLibraryModel* model = B4cShowerLibraryModel::GetInstance();
+    if ( model ) model->StartShower(step);
+    fRecorder->RecordStep(step);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
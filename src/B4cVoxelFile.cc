@@ -0,0 +1,271 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+//
+// $Id$
+//
+/// \file B4cVoxelFile.cc
+/// \brief Implementation of the B4cVoxelFile class
+
+#include "B4cVoxelFile.hh"
+
+#include "G4Threading.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include <zlib.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cVoxelFile::Options::Options()
+ : enable(false),
+   chunkSize(100),
+   maxVoxels(1 << 20),
+   compression(6),
+   fileName("voxels")
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cVoxelFile::Options& B4cVoxelFile::GetOptions()
+{
+  static Options options;
+  return options;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ThreadLocal B4cVoxelFile* B4cVoxelFile::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cVoxelFile::B4cVoxelFile()
+ : fFile(0),
+   fOffset(0),
+   fHeader(),
+   fNofVoxels(0.),
+   fIndex(),
+   fEventID(0),
+   fEventVoxels(),
+   fEventIDs(),
+   fNofEventVoxels(),
+   fVoxels(),
+   fEdeps(),
+   fPayload(),
+   fCompressed()
+{
+  fgInstance = this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4cVoxelFile::~B4cVoxelFile()
+{
+  Close();
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cVoxelFile::Open(G4int runID, G4int nofVoxelsX, G4int nofVoxelsY,
+                        G4int nofEmLayers, G4int nofLayers, G4double sizeXY)
+{
+  if ( IsOpen() ) Close();
+
+  const Options& options = GetOptions();
+
+  std::ostringstream fileName;
+  fileName << options.fileName << "_r" << runID;
+  if ( G4Threading::G4GetThreadId() >= 0 ) {
+    fileName << "_t" << G4Threading::G4GetThreadId();
+  }
+  fileName << ".b4v";
+
+  if ( nofVoxelsX <= 0 || nofVoxelsY <= 0 || nofLayers <= 0 ) {
+    G4ExceptionDescription msg;
+    msg << "No voxel grid (/B4/sd/voxelsX, voxelsY), " << fileName.str() 
+        << " is not written.";
+    G4Exception("B4cVoxelFile::Open()",
+      "MyCode0013", JustWarning, msg);
+    return;
+  }
+
+  fFile = std::fopen(fileName.str().c_str(), "wb");
+  if ( ! fFile ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot open " << fileName.str() 
+        << ", the shower images are not written.";
+    G4Exception("B4cVoxelFile::Open()",
+      "MyCode0013", JustWarning, msg);
+    return;
+  }
+
+  std::memset(&fHeader, 0, sizeof(fHeader));
+  std::memcpy(fHeader.magic, kVoxelMagic, sizeof(kVoxelMagic));
+  fHeader.version = kVoxelVersion;
+  fHeader.nofVoxelsX = nofVoxelsX;
+  fHeader.nofVoxelsY = nofVoxelsY;
+  fHeader.nofLayers = nofLayers;
+  fHeader.sizeXY = sizeXY;
+  fHeader.nofEmLayers = nofEmLayers;
+
+  fOffset = 0;
+  Write(&fHeader, sizeof(fHeader));
+  fNofVoxels = 0.;
+  fIndex.clear();
+  fEventVoxels.clear();
+  fEventIDs.clear();
+  fNofEventVoxels.clear();
+  fVoxels.clear();
+  fEdeps.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cVoxelFile::Close()
+{
+  if ( ! IsOpen() ) return;
+
+  WriteChunk();
+
+  // Chunk index, then the final header
+  fHeader.nofChunks = fIndex.size();
+  fHeader.indexOffset = fOffset;
+  if ( ! fIndex.empty() ) {
+    Write(&fIndex[0], fIndex.size()*sizeof(B4cVoxelChunk));
+  }
+  std::fseek(fFile, 0, SEEK_SET);
+  std::fwrite(&fHeader, sizeof(fHeader), 1, fFile);
+  std::fclose(fFile);
+  fFile = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cVoxelFile::BeginEvent(G4int eventID)
+{
+  fEventID = eventID;
+  fEventVoxels.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cVoxelFile::EndEvent()
+{
+  // Voxels in increasing order, the deposits of the same voxel in 
+  // several detectors (absorber and gap) are summed
+  std::sort(fEventVoxels.begin(), fEventVoxels.end());
+  size_t nofVoxels = 0;
+  for ( size_t i=0; i<fEventVoxels.size(); ++i ) {
+    if ( nofVoxels > 0 && fVoxels.back() == uint32_t(fEventVoxels[i].first) ) {
+      fEdeps.back() += fEventVoxels[i].second;
+      continue;
+    }
+    fVoxels.push_back(fEventVoxels[i].first);
+    fEdeps.push_back(fEventVoxels[i].second);
+    ++nofVoxels;
+  }
+  fEventVoxels.clear();
+
+  fEventIDs.push_back(fEventID);
+  fNofEventVoxels.push_back(nofVoxels);
+
+  const Options& options = GetOptions();
+  if ( G4int(fEventIDs.size()) >= options.chunkSize ||
+       G4int(fVoxels.size()) >= options.maxVoxels ) WriteChunk();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cVoxelFile::Write(const void* data, size_t size)
+{
+  std::fwrite(data, 1, size, fFile);
+  fOffset += size;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4cVoxelFile::WriteChunk()
+{
+  if ( fEventIDs.empty() ) return;
+
+  // Payload arrays, contiguous
+  size_t nofEvents = fEventIDs.size();
+  size_t nofVoxels = fVoxels.size();
+  size_t sizes[] = { nofEvents*sizeof(int32_t), nofEvents*sizeof(uint32_t),
+                     nofVoxels*sizeof(uint32_t), nofVoxels*sizeof(float) };
+  const void* arrays[] = { &fEventIDs[0], &fNofEventVoxels[0], 
+                           nofVoxels ? &fVoxels[0] : 0,
+                           nofVoxels ? &fEdeps[0] : 0 };
+  fPayload.resize(sizes[0] + sizes[1] + sizes[2] + sizes[3]);
+  size_t position = 0;
+  for ( G4int i=0; i<4; ++i ) {
+    if ( sizes[i] ) std::memcpy(&fPayload[position], arrays[i], sizes[i]);
+    position += sizes[i];
+  }
+
+  uLongf compressedSize = compressBound(fPayload.size());
+  fCompressed.resize(compressedSize);
+  G4int level = std::min(std::max(GetOptions().compression, 0), 9);
+  int status 
+    = compress2(&fCompressed[0], &compressedSize,
+                reinterpret_cast<const Bytef*>(&fPayload[0]), fPayload.size(),
+                level);
+  if ( status != Z_OK ) {
+    // The file stays readable, only the events of this chunk are lost
+    G4ExceptionDescription msg;
+    msg << "Cannot compress the shower images of events " 
+        << fEventIDs.front() << " to " << fEventIDs.back() 
+        << " (zlib error " << status << "), they are not written.";
+    G4Exception("B4cVoxelFile::WriteChunk()",
+      "MyCode0030", JustWarning, msg);
+  }
+  else {
+    B4cVoxelChunk chunk;
+    chunk.firstEventID = fEventIDs.front();
+    chunk.lastEventID = fEventIDs.back();
+    chunk.nofEvents = nofEvents;
+    chunk.nofVoxels = nofVoxels;
+    chunk.payloadOffset = fOffset + sizeof(chunk);
+    chunk.payloadSize = compressedSize;
+    Write(&chunk, sizeof(chunk));
+    Write(&fCompressed[0], compressedSize);
+    fIndex.push_back(chunk);
+
+    // only the events written are counted in the header
+    fHeader.nofEvents += nofEvents;
+    fNofVoxels += nofVoxels;
+  }
+
+  // The buffers keep their capacity for the next chunk
+  fEventIDs.clear();
+  fNofEventVoxels.clear();
+  fVoxels.clear();
+  fEdeps.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......